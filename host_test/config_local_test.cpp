@@ -0,0 +1,306 @@
+//The real LocalConfig (device_config.cpp) on top of a RAM partition (stubs/):
+//raw v1-v8 slots migrated by load()/streamed_size, a raw slot upgraded to TLV
+//and older/newer TLV record sets through the on_start() load path.
+#include "device_config.hpp"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace zb
+{
+    LocalConfig g_Config;
+}
+
+using namespace zb;
+
+namespace
+{
+    int g_Failed = 0;
+#define CHECK(cond) do{ if (!(cond)) { std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); ++g_Failed; } }while(0)
+
+    //on-flash layout of device_config.cpp
+    constexpr size_t kSlotSize = 4096;
+    constexpr uint32_t kSlotMagic = 0x4746434c;
+    enum class SlotFormat: uint16_t { Raw = 0, TLV = 1 };
+    struct SlotHeader
+    {
+        uint32_t m_Magic;
+        uint32_t m_Seq;
+        uint16_t m_Len;
+        SlotFormat m_Format;
+        uint32_t m_Crc;
+    };
+
+    using Bytes = std::vector<uint8_t>;
+    using Tag = LocalConfig::Tag;
+
+    void write_slot(uint8_t slot, uint32_t seq, SlotFormat format, Bytes const& payload)
+    {
+        SlotHeader h{kSlotMagic, seq, uint16_t(payload.size()), format, esp_rom_crc32_le(0, payload.data(), payload.size())};
+        uint8_t *p = host::partition_data() + slot * kSlotSize;
+        std::memset(p, 0xff, kSlotSize);
+        std::memcpy(p, &h, sizeof(h));
+        std::memcpy(p + sizeof(h), payload.data(), payload.size());
+    }
+
+    SlotHeader read_slot_header(uint8_t slot)
+    {
+        SlotHeader h;
+        std::memcpy(&h, host::partition_data() + slot * kSlotSize, sizeof(h));
+        return h;
+    }
+
+    //as the device boots with the partition as it is. Value initialized as the static g_Config is
+    LocalConfig boot()
+    {
+        LocalConfig c{};
+        CHECK(c.on_start() == ESP_OK);
+        return c;
+    }
+
+    //every persisted field away from its default
+    LocalConfig make_source()
+    {
+        LocalConfig c{};
+        c.SetOnOffTimeout(123);
+        c.SetOnOffMode(OnOffMode::OffOnly);
+        LocalConfig::PresenceDetectionMode m;
+        m.m_Raw = 0x5a;
+        c.SetPresenceDetectionMode(m);
+        c.SetLD2412Mode(LD2412::SystemMode::Simple);
+        c.SetIlluminanceThreshold(42);
+        c.SetExternalOnOffTimeout(17);
+        auto rp = c.GetReportPolicy();
+        rp.m_Distance.m_Deadband = 77;
+        rp.m_Energy.m_MaxIntervalS = 600;
+        rp.m_Adaptive = false;
+        c.SetReportPolicy(rp);
+        c.SetApproachDistance(250);
+        auto nf = c.GetNoiseFloor();
+        nf.m_Enabled = true;
+        nf.m_BaseMove[13] = 9;
+        c.SetNoiseFloor(nf);
+        auto z = c.GetZones();
+        z.m_Zones[3] = {2, 5, 30, 40};
+        c.SetZones(z);
+        c.SetPerBindDelivery(true);
+        c.SetActiveReportingCheck(true);
+        auto caps = c.GetBindCaps();
+        caps.Put({1, 2, 3, 4, 5, 6, 7, 8}, 3, true, true, 11);
+        c.SetBindCaps(caps);
+        return c;
+    }
+
+    //the LocalConfig struct as is, as v1-v8 persisted it
+    Bytes raw_image(LocalConfig const& c, uint32_t v)
+    {
+        Bytes b(LocalConfig::streamed_size(v));
+        std::memcpy(b.data(), (const void*)&c, b.size());
+        std::memcpy(b.data(), &v, sizeof(v));
+        return b;
+    }
+
+    void record(Bytes &b, Tag tag, const void *pV, size_t n)
+    {
+        LocalConfig::TlvHeader h{uint16_t(tag), uint16_t(n)};
+        b.insert(b.end(), (const uint8_t*)&h, (const uint8_t*)&h + sizeof(h));
+        b.insert(b.end(), (const uint8_t*)pV, (const uint8_t*)pV + n);
+    }
+
+    template<class T>
+    void record(Bytes &b, Tag tag, T const& v) { record(b, tag, &v, sizeof(v)); }
+
+    bool same_report_policy(ld2412::Component::ReportPolicy const& a, ld2412::Component::ReportPolicy const& b)
+    {
+        auto same = [](auto const& x, auto const& y){
+            return x.m_Deadband == y.m_Deadband && x.m_MinIntervalMs == y.m_MinIntervalMs && x.m_MaxIntervalS == y.m_MaxIntervalS;
+        };
+        return same(a.m_Distance, b.m_Distance) && same(a.m_Energy, b.m_Energy) && a.m_Adaptive == b.m_Adaptive;
+    }
+
+    //the fields introduced up to version v come from 'src', the rest are defaults
+    void check_fields(LocalConfig const& c, LocalConfig const& src, uint32_t v)
+    {
+        const LocalConfig def{};
+        auto from = [&](uint32_t since) -> LocalConfig const& { return v >= since ? src : def; };
+        CHECK(c.GetVersion() == LocalConfig::kActualStreamingVersion);
+        CHECK(c.GetOnOffTimeout() == from(1).GetOnOffTimeout());
+        CHECK(c.GetOnOffMode() == from(1).GetOnOffMode());
+        CHECK(c.GetPresenceDetectionMode().m_Raw == from(1).GetPresenceDetectionMode().m_Raw);
+        CHECK(c.GetLD2412Mode() == from(1).GetLD2412Mode());
+        CHECK(c.GetIlluminanceThreshold() == from(1).GetIlluminanceThreshold());
+        CHECK(c.GetExternalOnOffTimeout() == from(1).GetExternalOnOffTimeout());
+        CHECK(same_report_policy(c.GetReportPolicy(), from(2).GetReportPolicy()));
+        CHECK(c.GetApproachDistance() == from(3).GetApproachDistance());
+        CHECK(!std::memcmp(&c.GetNoiseFloor(), &from(4).GetNoiseFloor(), sizeof(c.GetNoiseFloor())));
+        CHECK(!std::memcmp(&c.GetZones(), &from(5).GetZones(), sizeof(c.GetZones())));
+        CHECK(c.GetPerBindDelivery() == from(6).GetPerBindDelivery());
+        CHECK(c.GetActiveReportingCheck() == from(7).GetActiveReportingCheck());
+        CHECK(!std::memcmp(&c.GetBindCaps(), &from(8).GetBindCaps(), sizeof(c.GetBindCaps())));
+    }
+
+    void test_streamed_size()
+    {
+        const size_t expected[] = {16, 30, 32, 63, 79, 80, 81};
+        for(uint32_t v = 1; v <= 7; ++v)
+            CHECK(LocalConfig::streamed_size(v) == expected[v - 1]);
+        CHECK(LocalConfig::streamed_size(LocalConfig::kActualStreamingVersion) == sizeof(LocalConfig));
+        CHECK(LocalConfig::streamed_size(7) < sizeof(LocalConfig));
+    }
+
+    void test_raw_migration()
+    {
+        const LocalConfig src = make_source();
+        for(uint32_t v = 1; v <= LocalConfig::kActualStreamingVersion; ++v)
+        {
+            host::partition_reset(2 * kSlotSize);
+            write_slot(0, 5, SlotFormat::Raw, raw_image(src, v));
+            const LocalConfig c = boot();
+            check_fields(c, src, v);
+            CHECK(c.GetRestarts() == 1);
+        }
+
+        //v8 written with fewer binds: the missing entries stay empty
+        {
+            host::partition_reset(2 * kSlotSize);
+            Bytes b = raw_image(src, 8);
+            b.resize(b.size() - sizeof(src.GetBindCaps().m_Entries[0]));
+            write_slot(0, 5, SlotFormat::Raw, b);
+            const LocalConfig c = boot();
+            CHECK(c.GetRestarts() == 1);
+            CHECK(c.GetActiveReportingCheck());
+            CHECK(!std::memcmp(&c.GetBindCaps().m_Entries[0], &src.GetBindCaps().m_Entries[0], sizeof(c.GetBindCaps().m_Entries[0])));
+        }
+
+        //shorter than its version: defaults
+        {
+            host::partition_reset(2 * kSlotSize);
+            Bytes b = raw_image(src, 4);
+            b.pop_back();
+            write_slot(0, 5, SlotFormat::Raw, b);
+            const LocalConfig c = boot();
+            check_fields(c, src, 0);
+            CHECK(c.GetRestarts() == 0);
+        }
+
+        //newer than known: defaults
+        {
+            host::partition_reset(2 * kSlotSize);
+            Bytes b = raw_image(src, 8);
+            const uint32_t v = LocalConfig::kActualStreamingVersion + 1;
+            std::memcpy(b.data(), &v, sizeof(v));
+            write_slot(0, 5, SlotFormat::Raw, b);
+            check_fields(boot(), src, 0);
+        }
+    }
+
+    void test_raw_upgraded_to_tlv()
+    {
+        const LocalConfig src = make_source();
+        host::partition_reset(2 * kSlotSize);
+        write_slot(0, 5, SlotFormat::Raw, raw_image(src, 5));
+        const LocalConfig first = boot();
+        check_fields(first, src, 5);
+
+        //written right away to the other slot as TLV
+        const SlotHeader h = read_slot_header(1);
+        CHECK(h.m_Magic == kSlotMagic);
+        CHECK(h.m_Seq == 6);
+        CHECK(h.m_Format == SlotFormat::TLV);
+        CHECK(h.m_Len >= LocalConfig::kFieldCount * sizeof(LocalConfig::TlvHeader));
+
+        //the next boot takes the TLV copy
+        const LocalConfig second = boot();
+        check_fields(second, src, 5);
+        CHECK(second.GetRestarts() == 2);
+        CHECK(read_slot_header(0).m_Format == SlotFormat::TLV);
+        CHECK(read_slot_header(0).m_Seq == 7);
+
+        //a broken newest copy (seq 7, 2 restarts): the older one (seq 6, 1 restart) is used
+        host::partition_data()[sizeof(SlotHeader) + 4] ^= 0xff;
+        const LocalConfig third = boot();
+        check_fields(third, src, 5);
+        CHECK(third.GetRestarts() == 2);
+    }
+
+    void test_tlv_older_records()
+    {
+        //what a firmware knowing only the v1 fields would have written
+        const LocalConfig src = make_source();
+        Bytes b;
+        record(b, Tag::OnOffTimeout, src.GetOnOffTimeout());
+        record(b, Tag::OnOffMode, src.GetOnOffMode());
+        record(b, Tag::PresenceDetectionMode, src.GetPresenceDetectionMode());
+        record(b, Tag::LD2412Mode, src.GetLD2412Mode());
+        record(b, Tag::IlluminanceThreshold, src.GetIlluminanceThreshold());
+        record(b, Tag::ExternalOnOffTimeout, src.GetExternalOnOffTimeout());
+        const uint16_t restarts = 40;
+        record(b, Tag::Restarts, restarts);
+        host::partition_reset(2 * kSlotSize);
+        write_slot(1, 9, SlotFormat::TLV, b);
+        const LocalConfig c = boot();
+        check_fields(c, src, 1);
+        CHECK(c.GetRestarts() == restarts + 1);
+        CHECK(read_slot_header(0).m_Seq == 10);
+    }
+
+    void test_tlv_newer_records()
+    {
+        //everything we know, plus what a newer firmware might add
+        const LocalConfig src = make_source();
+        Bytes b;
+        uint32_t crc;
+        b.resize(kSlotSize);
+        size_t written = src.encode([](void *pCtx, size_t off, const void *pSrc, size_t n){
+                std::memcpy(static_cast<Bytes*>(pCtx)->data() + off, pSrc, n);
+                return true;
+            }, &b, crc);
+        CHECK(written > 0);
+        b.resize(written);
+        const uint8_t future[40] = {0xee};
+        record(b, Tag(100), future);
+        //more binds than we have: the extra entries are skipped
+        Bytes caps(sizeof(src.GetBindCaps()) + 2 * sizeof(src.GetBindCaps().m_Entries[0]), 0xab);
+        std::memcpy(caps.data(), &src.GetBindCaps(), sizeof(src.GetBindCaps()));
+        record(b, Tag::BindCaps, caps.data(), caps.size());
+        //grown at the end
+        uint8_t zones[sizeof(src.GetZones()) + 3] = {};
+        std::memcpy(zones, &src.GetZones(), sizeof(src.GetZones()));
+        record(b, Tag::Zones, zones);
+
+        host::partition_reset(2 * kSlotSize);
+        write_slot(0, 3, SlotFormat::TLV, b);
+        check_fields(boot(), src, LocalConfig::kActualStreamingVersion);
+
+        //the stored copy is back to the known records only
+        const SlotHeader h = read_slot_header(1);
+        CHECK(h.m_Format == SlotFormat::TLV && h.m_Seq == 4);
+        CHECK(h.m_Len == written);
+    }
+
+    void test_unchanged_setter()
+    {
+        LocalConfig c{};
+        const uint32_t changes = LocalConfig::GetWriteStats().m_Changes;
+        c.SetOnOffTimeout(c.GetOnOffTimeout());
+        c.SetZones(c.GetZones());
+        c.SetIlluminanceExternal(c.GetIlluminanceExternal());
+        CHECK(LocalConfig::GetWriteStats().m_Changes == changes);
+        c.SetOnOffTimeout(c.GetOnOffTimeout() + 1);
+        CHECK(LocalConfig::GetWriteStats().m_Changes == changes + 1);
+    }
+}
+
+int main()
+{
+    test_streamed_size();
+    test_raw_migration();
+    test_raw_upgraded_to_tlv();
+    test_tlv_older_records();
+    test_tlv_newer_records();
+    test_unchanged_setter();
+    std::printf("config_local: %d failed checks\n", g_Failed);
+    return g_Failed ? 1 : 0;
+}
@@ -0,0 +1,215 @@
+//Checks the TLV config codec (config_tlv.hpp) against a plain buffer storage:
+//round trip, unknown tags, truncated records and repeated tags.
+#include "config_tlv.hpp"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace zb::tlv;
+
+namespace
+{
+    uint32_t crc32_le(uint32_t crc, uint8_t const *pBuf, uint32_t len)
+    {
+        crc = ~crc;
+        while(len--)
+        {
+            crc ^= *pBuf++;
+            for(int i = 0; i < 8; ++i)
+                crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+        }
+        return ~crc;
+    }
+
+    struct Config
+    {
+        uint16_t m_A = 1;
+        uint8_t m_B = 2;
+        uint8_t m_C[6] = {3, 3, 3, 3, 3, 3};
+        uint32_t m_D = 4;
+
+        bool operator==(Config const&) const = default;
+    };
+
+    enum Tag: uint16_t { A = 1, B = 2, C = 3, D = 4, Unknown = 100 };
+
+#define FIELD(tag, field) {tag, uint16_t(offsetof(Config, field)), uint16_t(sizeof(Config::field))}
+    constexpr Schema<4> kSchema = {
+        .m_Fields = { FIELD(A, m_A), FIELD(B, m_B), FIELD(C, m_C), FIELD(D, m_D) },
+        .m_Crc = &crc32_le
+    };
+#undef FIELD
+
+    struct Buffer
+    {
+        std::vector<uint8_t> m_Data;
+        size_t m_FailWriteAt = size_t(-1);
+
+        static bool read(void *pCtx, size_t off, void *pDst, size_t n)
+        {
+            auto &b = *static_cast<Buffer*>(pCtx);
+            if (off + n > b.m_Data.size())
+                return false;
+            std::memcpy(pDst, b.m_Data.data() + off, n);
+            return true;
+        }
+
+        static bool write(void *pCtx, size_t off, const void *pSrc, size_t n)
+        {
+            auto &b = *static_cast<Buffer*>(pCtx);
+            if (off + n > b.m_FailWriteAt)
+                return false;
+            if (b.m_Data.size() < off + n)
+                b.m_Data.resize(off + n);
+            std::memcpy(b.m_Data.data() + off, pSrc, n);
+            return true;
+        }
+
+        //a raw record, for the cases the encoder never produces
+        void Record(uint16_t tag, std::vector<uint8_t> const& value)
+        {
+            Header h{tag, uint16_t(value.size())};
+            auto *p = reinterpret_cast<const uint8_t*>(&h);
+            m_Data.insert(m_Data.end(), p, p + sizeof(h));
+            m_Data.insert(m_Data.end(), value.begin(), value.end());
+        }
+
+        uint32_t Crc() const { return crc32_le(0, m_Data.data(), m_Data.size()); }
+
+        bool Decode(Config &dst, size_t &off) { return kSchema.Decode(&dst, &read, this, m_Data.size(), Crc(), off); }
+    };
+
+    int g_Failed = 0;
+#define CHECK(cond) do{ if (!(cond)) { std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); ++g_Failed; } }while(0)
+
+    void test_round_trip()
+    {
+        Config src{.m_A = 0x1234, .m_B = 0x56, .m_C = {1, 2, 3, 4, 5, 6}, .m_D = 0xdeadbeef};
+        Buffer b;
+        uint32_t crc;
+        const size_t n = kSchema.Encode(&src, &Buffer::write, &b, crc);
+        CHECK(n == 4 * sizeof(Header) + 2 + 1 + 6 + 4);
+        CHECK(n == b.m_Data.size());
+        CHECK(crc == b.Crc());
+
+        Config dst{};
+        size_t off;
+        CHECK(kSchema.Decode(&dst, &Buffer::read, &b, n, crc, off));
+        CHECK(off == n);
+        CHECK(dst == src);
+
+        //any corruption is caught by the CRC
+        b.m_Data[sizeof(Header)] ^= 1;
+        CHECK(!kSchema.Decode(&dst, &Buffer::read, &b, n, crc, off));
+    }
+
+    void test_encode_write_failure()
+    {
+        //more than the staging buffer, so that the failure hits a middle chunk
+        struct Big { uint8_t m_Data[100]{}; } big;
+        constexpr Schema<2> kBig = {
+            .m_Fields = { {1, 0, 50}, {2, 50, 50} },
+            .m_Crc = &crc32_le
+        };
+        Buffer b;
+        b.m_FailWriteAt = 64;
+        uint32_t crc;
+        CHECK(kBig.Encode(&big, &Buffer::write, &b, crc) == 0);
+    }
+
+    void test_unknown_tag()
+    {
+        Buffer b;
+        b.Record(A, {0x22, 0x11});
+        b.Record(Unknown, std::vector<uint8_t>(70, 0xee));//longer than the skip chunk
+        b.Record(B, {0x77});
+        Config dst;
+        size_t off;
+        CHECK(b.Decode(dst, off));
+        CHECK(dst.m_A == 0x1122);
+        CHECK(dst.m_B == 0x77);
+        //missing ones are untouched
+        CHECK(dst.m_D == Config{}.m_D);
+    }
+
+    void test_size_mismatch()
+    {
+        Buffer b;
+        b.Record(C, {9, 9});//shorter: prefix only
+        b.Record(D, {1, 0, 0, 0, 0xaa, 0xbb});//longer: the rest is skipped
+        b.Record(B, {5});
+        Config dst;
+        size_t off;
+        CHECK(b.Decode(dst, off));
+        CHECK(dst.m_C[0] == 9 && dst.m_C[1] == 9 && dst.m_C[2] == 3);
+        CHECK(dst.m_D == 1);
+        CHECK(dst.m_B == 5);
+    }
+
+    void test_truncated_header()
+    {
+        Buffer b;
+        b.Record(B, {5});
+        b.m_Data.push_back(A);//half of a header
+        Config dst;
+        size_t off;
+        CHECK(!b.Decode(dst, off));
+        CHECK(off == sizeof(Header) + 1);
+    }
+
+    void test_len_past_end()
+    {
+        Buffer b;
+        b.Record(B, {5});
+        b.Record(C, {1, 2, 3, 4, 5, 6});
+        //the storage goes on (as a flash slot does), the records end before the value does
+        const size_t len = b.m_Data.size() - 2;
+        const uint32_t crc = crc32_le(0, b.m_Data.data(), len);
+        Config dst;
+        size_t off;
+        CHECK(!kSchema.Decode(&dst, &Buffer::read, &b, len, crc, off));
+        CHECK(off == 2 * sizeof(Header) + 1);
+        CHECK(dst.m_C[0] == Config{}.m_C[0]);
+
+        //storage shorter than the claimed length
+        Buffer s;
+        s.Record(B, {5});
+        CHECK(!kSchema.Decode(&dst, &Buffer::read, &s, s.m_Data.size() + 4, s.Crc(), off));
+    }
+
+    void test_duplicate_tags()
+    {
+        Buffer b;
+        b.Record(A, {1, 0});
+        b.Record(D, {7, 0, 0, 0});
+        b.Record(A, {2, 0});
+        Config dst;
+        size_t off;
+        CHECK(b.Decode(dst, off));
+        CHECK(dst.m_A == 2);//the last one wins
+        CHECK(dst.m_D == 7);
+    }
+
+    void test_empty()
+    {
+        Buffer b;
+        Config dst;
+        size_t off;
+        CHECK(b.Decode(dst, off));
+        CHECK(dst == Config{});
+    }
+}
+
+int main()
+{
+    test_round_trip();
+    test_encode_write_failure();
+    test_unknown_tag();
+    test_size_mismatch();
+    test_truncated_header();
+    test_len_past_end();
+    test_duplicate_tags();
+    test_empty();
+    std::printf("config_tlv: %d failed checks\n", g_Failed);
+    return g_Failed ? 1 : 0;
+}
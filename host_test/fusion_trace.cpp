@@ -0,0 +1,205 @@
+//Replays a presence source trace through zb::fusion::Engine the way
+//update_presence_state() does (including the hold re-evaluation timer)
+//and checks the presence against the expectations in the trace.
+//
+//Trace lines ('#' starts a comment):
+//  <ms> <mmwave|pir|external|approach> <0|1>   source state change
+//  <ms> expect <on|off>                        presence after everything up to <ms>
+//  <ms> mask <edge> <keep>                     source bitmasks (hex) of the presence detection config (default: e f)
+//
+//fusion_trace [--bench <iterations>] <trace>
+#include "zb_presence_fusion.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace zb::fusion;
+
+namespace
+{
+    struct Event
+    {
+        enum class Kind { Source, Expect, Mask } m_Kind;
+        uint32_t m_Ms;
+        size_t m_Source = 0;
+        bool m_Value = false;
+        uint32_t m_Edge = 0, m_Keep = 0;
+        int m_Line = 0;
+    };
+
+    bool parse_source(const char *pName, size_t &dst)
+    {
+        static const char *kNames[kSources] = {"mmwave", "pir", "external", "approach"};
+        for(size_t i = 0; i < kSources; ++i)
+            if (!std::strcmp(pName, kNames[i]))
+            {
+                dst = i;
+                return true;
+            }
+        return false;
+    }
+
+    bool load(const char *pPath, std::vector<Event> &events)
+    {
+        FILE *f = std::fopen(pPath, "r");
+        if (!f)
+        {
+            std::fprintf(stderr, "Can't open %s\n", pPath);
+            return false;
+        }
+        char line[256];
+        int lineNo = 0;
+        bool ok = true;
+        while(ok && std::fgets(line, sizeof(line), f))
+        {
+            ++lineNo;
+            if (char *pComment = std::strchr(line, '#'))
+                *pComment = 0;
+            char what[32], arg1[32], arg2[32];
+            unsigned ms;
+            int n = std::sscanf(line, "%u %31s %31s %31s", &ms, what, arg1, arg2);
+            if (n <= 0)
+                continue;//empty
+            Event e{.m_Kind = Event::Kind::Source, .m_Ms = ms, .m_Line = lineNo};
+            if (n == 3 && !std::strcmp(what, "expect"))
+            {
+                e.m_Kind = Event::Kind::Expect;
+                e.m_Value = !std::strcmp(arg1, "on");
+                ok = e.m_Value || !std::strcmp(arg1, "off");
+            }else if (n == 4 && !std::strcmp(what, "mask"))
+            {
+                e.m_Kind = Event::Kind::Mask;
+                e.m_Edge = std::strtoul(arg1, nullptr, 16);
+                e.m_Keep = std::strtoul(arg2, nullptr, 16);
+            }else if (n == 3 && parse_source(what, e.m_Source))
+                e.m_Value = std::atoi(arg1) != 0;
+            else
+                ok = false;
+
+            if (!ok)
+                std::fprintf(stderr, "%s:%d: can't parse '%s'\n", pPath, lineNo, line);
+            else if (!events.empty() && ms < events.back().m_Ms)
+            {
+                std::fprintf(stderr, "%s:%d: time goes backwards\n", pPath, lineNo);
+                ok = false;
+            }else
+                events.push_back(e);
+        }
+        std::fclose(f);
+        return ok;
+    }
+
+    struct Replay
+    {
+        Engine<kSources> m_Engine;
+        //the default presence detection config: radar is not an edge source
+        Rules<kSources> m_Rules = kDefaultRules.Masked(0xe, 0xf);
+        bool m_Presence = false;
+        bool m_FirstRun = true;
+        bool m_TriggerAllowed = true;
+        uint32_t m_HoldAt = 0;//absolute time of the hold timer, 0 - not armed
+        uint32_t m_Evaluations = 0;
+        uint32_t m_Changes = 0;
+        bool m_Verbose = false;
+
+        void Evaluate(uint32_t nowMs)
+        {
+            ++m_Evaluations;
+            bool changed = m_Engine.Evaluate(m_Rules, {m_Presence, m_FirstRun, m_TriggerAllowed}, nowMs);
+            m_HoldAt = 0;
+            if (auto holdMs = m_Engine.NextHoldExpiry(m_Rules, nowMs); m_Presence && holdMs)
+                m_HoldAt = nowMs + holdMs;
+            if (changed)
+            {
+                ++m_Changes;
+                if (m_Verbose)
+                    std::printf("%8u ms: presence %s\n", nowMs, m_Presence ? "on" : "off");
+            }
+        }
+
+        void AdvanceTo(uint32_t nowMs)
+        {
+            while(m_HoldAt && m_HoldAt <= nowMs)
+                Evaluate(m_HoldAt);
+        }
+
+        //returns the number of failed expectations
+        int Run(std::vector<Event> const& events, const char *pPath)
+        {
+            int failed = 0;
+            for(auto const& e : events)
+            {
+                AdvanceTo(e.m_Ms);
+                switch(e.m_Kind)
+                {
+                    case Event::Kind::Source:
+                        m_Engine.Set(e.m_Source, e.m_Value, e.m_Ms);
+                        Evaluate(e.m_Ms);
+                        break;
+                    case Event::Kind::Mask:
+                        m_Rules = kDefaultRules.Masked(e.m_Edge, e.m_Keep);
+                        break;
+                    case Event::Kind::Expect:
+                        if (m_Presence != e.m_Value)
+                        {
+                            if (m_Verbose)
+                                std::printf("%s:%d: expected presence %s at %u ms\n", pPath, e.m_Line, e.m_Value ? "on" : "off", e.m_Ms);
+                            ++failed;
+                        }
+                        break;
+                }
+            }
+            return failed;
+        }
+    };
+}
+
+int main(int argc, char **argv)
+{
+    long bench = 0;
+    const char *pPath = nullptr;
+    for(int i = 1; i < argc; ++i)
+    {
+        if (!std::strcmp(argv[i], "--bench") && (i + 1) < argc)
+            bench = std::atol(argv[++i]);
+        else
+            pPath = argv[i];
+    }
+    if (!pPath)
+    {
+        std::fprintf(stderr, "Usage: %s [--bench <iterations>] <trace>\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<Event> events;
+    if (!load(pPath, events))
+        return 2;
+
+    Replay r;
+    r.m_Verbose = !bench;
+    const int failed = r.Run(events, pPath);
+    if (!bench)
+    {
+        std::printf("%s: %zu events, %u evaluations, %u presence changes, %d failed expectations\n"
+                , pPath, events.size(), r.m_Evaluations, r.m_Changes, failed);
+        return failed ? 1 : 0;
+    }
+
+    uint64_t evaluations = 0;
+    uint32_t sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for(long i = 0; i < bench; ++i)
+    {
+        Replay b;
+        b.Run(events, pPath);
+        evaluations += b.m_Evaluations;
+        sink += b.m_Changes;
+    }
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%ld replays, %llu evaluations: %.1f ns per evaluation (%u changes)\n"
+            , bench, (unsigned long long)evaluations, evaluations ? double(ns) / evaluations : 0.0, sink);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,168 @@
+//Two emulated radar sensors publishing movement through their own handoff
+//rings (as SensorMailbox does), a consumer draining them the way
+//handle_movement() does and checking the fused presence and the per sensor state.
+#include "zb_handoff_ring.hpp"
+#include "zb_presence_fusion.hpp"
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+using namespace zb;
+
+namespace
+{
+    enum class TargetState: uint8_t { Clear, Move, Still, MoveAndStill };
+
+    struct Snapshot
+    {
+        uint32_t m_Seq;
+        bool m_Presence;
+        TargetState m_State;
+    };
+
+    constexpr size_t kSensors = 2;
+    constexpr size_t kSlots = 8;//same as SensorMailbox::kMovementSlots
+
+    int g_Failed = 0;
+#define CHECK(cond) do{ if (!(cond)) { std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); ++g_Failed; } }while(0)
+
+    struct Device
+    {
+        HandoffRing<Snapshot, kSlots> m_Mailbox[kSensors];
+        fusion::Sensors<kSensors, TargetState> m_Sensors;
+        fusion::Engine<fusion::kSources> m_Fusion;
+        //radar only: edge and keep on mmWave
+        fusion::Rules<fusion::kSources> m_Rules = fusion::kDefaultRules.Masked(0x1, 0x1);
+        bool m_Presence = false;
+        bool m_FirstRun = true;
+        bool m_TriggerAllowed = true;
+        uint32_t m_LastSeq[kSensors]{};
+        uint32_t m_OutOfOrder = 0;
+        uint32_t m_Consumed = 0;
+
+        void Publish(size_t sensor, Snapshot const& s) { m_Mailbox[sensor].Push(s); }
+
+        //one consumer run: every sensor drained, as the zigbee task does
+        void Consume(uint32_t nowMs = 0)
+        {
+            for(size_t i = 0; i < kSensors; ++i)
+            {
+                Snapshot s;
+                while(m_Mailbox[i].Pop(s))
+                {
+                    ++m_Consumed;
+                    if (s.m_Seq <= m_LastSeq[i])
+                        ++m_OutOfOrder;
+                    m_LastSeq[i] = s.m_Seq;
+                    const bool fusedChanged = m_Sensors.Update(i, s.m_Presence, s.m_State);
+                    //the primary sensor always re-evaluates, the others only on a change of the fused presence
+                    if (i == 0 || fusedChanged)
+                    {
+                        m_Fusion.Set(fusion::Source::mmWave, m_Sensors.Any(), nowMs);
+                        m_Fusion.Evaluate(m_Rules, {m_Presence, m_FirstRun, m_TriggerAllowed}, nowMs);
+                    }
+                }
+            }
+        }
+    };
+
+    void test_fused_presence()
+    {
+        Device d;
+        uint32_t seq = 0;
+        d.Publish(0, {++seq, true, TargetState::Move});
+        d.Consume();
+        CHECK(d.m_Presence);
+        CHECK(d.m_Sensors[0].m_State == TargetState::Move);
+        CHECK(!d.m_Sensors[1].m_Presence);
+
+        //the secondary joins: nothing changes for the fused presence
+        d.Publish(1, {++seq, true, TargetState::Still});
+        d.Consume();
+        CHECK(d.m_Presence);
+        CHECK(d.m_Sensors[1].m_State == TargetState::Still);
+
+        //the primary clears: the secondary keeps the presence
+        d.Publish(0, {++seq, false, TargetState::Clear});
+        d.Consume();
+        CHECK(d.m_Presence);
+        CHECK(!d.m_Sensors[0].m_Presence && d.m_Sensors[0].m_State == TargetState::Clear);
+        CHECK(d.m_Sensors[1].m_Presence);
+
+        //both clear
+        d.Publish(1, {++seq, false, TargetState::Clear});
+        d.Consume();
+        CHECK(!d.m_Presence);
+
+        //the secondary alone triggers it
+        d.Publish(1, {++seq, true, TargetState::MoveAndStill});
+        d.Consume();
+        CHECK(d.m_Presence);
+        CHECK(d.m_Sensors[1].m_State == TargetState::MoveAndStill);
+        CHECK(d.m_OutOfOrder == 0);
+    }
+
+    void test_overflow_converges()
+    {
+        Device d;
+        //a consumer that lags behind: the ring keeps the first kSlots, the latest slot the last one
+        for(uint32_t i = 1; i <= 3 * kSlots; ++i)
+            d.Publish(0, {i, (i & 1) != 0, (i & 1) ? TargetState::Move : TargetState::Clear});
+        d.Publish(1, {1, true, TargetState::Still});
+        d.Consume();
+        CHECK(d.m_Consumed == kSlots + 1 + 1);
+        CHECK(d.m_LastSeq[0] == 3 * kSlots);
+        CHECK(!d.m_Sensors[0].m_Presence);//the last published one
+        CHECK(d.m_Sensors[1].m_Presence);
+        CHECK(d.m_Presence);
+        CHECK(d.m_OutOfOrder == 0);
+
+        //the ring is used again after the latest slot was taken
+        d.Publish(0, {3 * kSlots + 1, true, TargetState::Move});
+        d.Publish(0, {3 * kSlots + 2, false, TargetState::Clear});
+        d.Consume();
+        CHECK(d.m_Consumed == kSlots + 2 + 2);
+        CHECK(d.m_Sensors[0].m_State == TargetState::Clear);
+    }
+
+    void test_concurrent_producers()
+    {
+        Device d;
+        constexpr uint32_t kPerSensor = 5000;
+        std::atomic<size_t> running{kSensors};
+        auto producer = [&](size_t sensor){
+            //the secondary ends with presence, the primary without it
+            for(uint32_t i = 1; i <= kPerSensor; ++i)
+            {
+                const bool presence = ((i + sensor) & 1) != 0;
+                d.Publish(sensor, {i, presence, presence ? TargetState::Still : TargetState::Clear});
+                if (i % 4 == 0)
+                    std::this_thread::yield();//partly through the ring, partly overflown
+            }
+            running.fetch_sub(1, std::memory_order_release);
+        };
+        std::thread p0(producer, 0), p1(producer, 1);
+        //spins, so that it gets preempted in the middle of a Pop
+        while(running.load(std::memory_order_acquire))
+            d.Consume();
+        p0.join();
+        p1.join();
+        d.Consume();
+
+        std::printf("concurrent: %u of %u snapshots consumed\n", d.m_Consumed, kPerSensor * uint32_t(kSensors));
+        CHECK(d.m_OutOfOrder == 0);
+        CHECK(d.m_LastSeq[0] == kPerSensor && d.m_LastSeq[1] == kPerSensor);
+        CHECK(!d.m_Sensors[0].m_Presence && d.m_Sensors[0].m_State == TargetState::Clear);
+        CHECK(d.m_Sensors[1].m_Presence && d.m_Sensors[1].m_State == TargetState::Still);
+        CHECK(d.m_Presence);
+    }
+}
+
+int main()
+{
+    test_fused_presence();
+    test_overflow_converges();
+    test_concurrent_producers();
+    std::printf("multi_sensor: %d failed checks\n", g_Failed);
+    return g_Failed ? 1 : 0;
+}
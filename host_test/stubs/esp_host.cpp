@@ -0,0 +1,104 @@
+//Host implementations of the stubbed ESP-IDF/esp-zigbee functions
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "zbh_alarm.hpp"
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    int64_t g_NowUs = 0;
+    esp_partition_t g_Partition{};
+    std::vector<uint8_t> g_Flash;
+
+    struct
+    {
+        zb::ZbAlarm::callback_t m_Cb = nullptr;
+        void *m_pParam = nullptr;
+        int64_t m_DueUs = -1;
+    } g_Alarm;
+}
+
+int64_t esp_timer_get_time() { return g_NowUs; }
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t) { return ESP_OK; }
+
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const *pBuf, uint32_t len)
+{
+    crc = ~crc;
+    while(len--)
+    {
+        crc ^= *pBuf++;
+        for(int i = 0; i < 8; ++i)
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t, esp_partition_subtype_t, const char *)
+{
+    return g_Flash.empty() ? nullptr : &g_Partition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *, size_t off, void *pDst, size_t n)
+{
+    if (off + n > g_Flash.size())
+        return ESP_ERR_INVALID_SIZE;
+    std::memcpy(pDst, g_Flash.data() + off, n);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *, size_t off, const void *pSrc, size_t n)
+{
+    if (off + n > g_Flash.size())
+        return ESP_ERR_INVALID_SIZE;
+    for(size_t i = 0; i < n; ++i)
+        g_Flash[off + i] &= static_cast<const uint8_t*>(pSrc)[i];
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *, size_t off, size_t n)
+{
+    if (off + n > g_Flash.size())
+        return ESP_ERR_INVALID_SIZE;
+    std::memset(g_Flash.data() + off, 0xff, n);
+    return ESP_OK;
+}
+
+namespace host
+{
+    void set_time_us(int64_t t) { g_NowUs = t; }
+
+    uint8_t* partition_data() { return g_Flash.data(); }
+
+    void partition_reset(size_t size)
+    {
+        g_Flash.assign(size, 0xff);
+        g_Partition.size = uint32_t(size);
+    }
+
+    int64_t alarm_due_us() { return g_Alarm.m_DueUs; }
+
+    bool alarm_fire()
+    {
+        if (g_Alarm.m_DueUs < 0 || g_Alarm.m_DueUs > g_NowUs)
+            return false;
+        g_Alarm.m_DueUs = -1;
+        g_Alarm.m_Cb(g_Alarm.m_pParam);
+        return true;
+    }
+}
+
+namespace zb
+{
+    void ZbAlarm::Setup(callback_t cb, void *param, uint32_t ms)
+    {
+        g_Alarm.m_Cb = cb;
+        g_Alarm.m_pParam = param;
+        g_Alarm.m_DueUs = g_NowUs + int64_t(ms) * 1000;
+    }
+
+    void ZbAlarm::Cancel() { g_Alarm.m_DueUs = -1; }
+    bool ZbAlarm::IsRunning() const { return g_Alarm.m_DueUs >= 0; }
+}
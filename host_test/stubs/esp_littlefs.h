@@ -0,0 +1,15 @@
+#pragma once
+#include "esp_err.h"
+struct esp_vfs_littlefs_conf_t
+{
+    const char *base_path;
+    const char *partition_label;
+    const void *partition;
+    bool format_if_mount_failed;
+    bool read_only;
+    bool dont_mount;
+    bool grow_on_mount;
+};
+//never mounts on the host: there is no config.dat to migrate
+inline esp_err_t esp_vfs_littlefs_register(const esp_vfs_littlefs_conf_t *) { return ESP_FAIL; }
+inline esp_err_t esp_vfs_littlefs_unregister(const char *) { return ESP_OK; }
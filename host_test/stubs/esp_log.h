@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdio>
+//silent unless HOST_TEST_LOG is defined
+#if defined(HOST_TEST_LOG)
+#define ESP_LOG_HOST(l, tag, fmt, ...) std::printf("%c %s: " fmt "\n", l, tag __VA_OPT__(,) __VA_ARGS__)
+#else
+#define ESP_LOG_HOST(l, tag, fmt, ...) do{ (void)tag; if (false) std::printf(fmt __VA_OPT__(,) __VA_ARGS__); }while(0)
+#endif
+#define ESP_LOGE(tag, ...) ESP_LOG_HOST('E', tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ESP_LOG_HOST('W', tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ESP_LOG_HOST('I', tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ESP_LOG_HOST('D', tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ESP_LOG_HOST('V', tag, __VA_ARGS__)
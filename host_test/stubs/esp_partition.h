@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "esp_err.h"
+enum esp_partition_type_t { ESP_PARTITION_TYPE_DATA = 1 };
+enum esp_partition_subtype_t { ESP_PARTITION_SUBTYPE_ANY = 0xff };
+struct esp_partition_t
+{
+    uint32_t size;
+};
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t, esp_partition_subtype_t, const char *label);
+esp_err_t esp_partition_read(const esp_partition_t *p, size_t off, void *pDst, size_t n);
+esp_err_t esp_partition_write(const esp_partition_t *p, size_t off, const void *pSrc, size_t n);
+esp_err_t esp_partition_erase_range(const esp_partition_t *p, size_t off, size_t n);
+namespace host
+{
+    //a RAM backed partition: erased to 0xff, writes only clear bits as NOR flash does
+    uint8_t* partition_data();
+    void partition_reset(size_t size);
+}
@@ -0,0 +1,3 @@
+#pragma once
+#include <cstdint>
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const *pBuf, uint32_t len);
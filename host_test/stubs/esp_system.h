@@ -0,0 +1,4 @@
+#pragma once
+#include "esp_err.h"
+using shutdown_handler_t = void(*)();
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t);
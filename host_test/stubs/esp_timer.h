@@ -0,0 +1,8 @@
+#pragma once
+#include <cstdint>
+//the host clock is driven by the test
+int64_t esp_timer_get_time();
+namespace host
+{
+    void set_time_us(int64_t t);
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <cstdint>
+using TickType_t = uint32_t;
+using BaseType_t = int;
+using QueueHandle_t = struct QueueDefinition*;
+using SemaphoreHandle_t = QueueHandle_t;
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY TickType_t(~0u)
@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdio>
+#include <expected>
+#include <string_view>
+#define FMT_PRINT(...) do{}while(0)
+struct FormatError {};
+template<class T> concept FormatDestination = true;
+namespace tools
+{
+    template<class T> struct formatter_t;
+    template<class Dest, class... Args>
+    std::expected<size_t, FormatError> format_to(Dest &&, std::string_view, Args const&...) { return 0; }
+}
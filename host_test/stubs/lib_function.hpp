@@ -0,0 +1,4 @@
+#pragma once
+#include <functional>
+template<class Sig>
+using GenericCallback = std::function<Sig>;
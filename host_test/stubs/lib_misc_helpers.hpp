@@ -0,0 +1,13 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+template<class F>
+struct ScopeExit
+{
+    F m_F;
+    ScopeExit(F f): m_F(std::move(f)) {}
+    ~ScopeExit() { m_F(); }
+};
+template<class T> struct is_expected_type: std::false_type {};
+template<class T> constexpr bool is_expected_type_v = is_expected_type<T>::value;
+template<class Ref, class V> struct RetValT { Ref r; V v; };
@@ -0,0 +1,27 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <expected>
+#include <functional>
+#include "lib_misc_helpers.hpp"
+#include "lib_format.hpp"
+using duration_ms_t = std::chrono::milliseconds;
+struct Err { const char *pLocation = nullptr; int code = 0; };
+namespace uart
+{
+    enum class Port { Port0, Port1 };
+    struct Channel
+    {
+        using Ref = std::reference_wrapper<Channel>;
+        using ExpectedResult = std::expected<Ref, ::Err>;
+        ExpectedResult Send(const uint8_t *, size_t);
+        ExpectedResult Flush();
+        ExpectedResult WaitAllSent();
+        duration_ms_t GetDefaultWait() const;
+        void SetDefaultWait(duration_ms_t);
+        void SetEventCallback(std::function<void()>);
+        size_t GetReadyToReadDataLen();
+        bool m_Dbg = false;
+    };
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include "ph_uart.hpp"
+namespace uart::primitives
+{
+    template<class... T> Channel::ExpectedResult write_any(Channel &, T&&...);
+    template<class T> constexpr size_t uart_sizeof() { return sizeof(T); }
+    template<class T> Channel::ExpectedResult match_bytes(Channel &, T const&);
+    template<class T> Channel::ExpectedResult read_into(Channel &, T &);
+    template<class... T> Channel::ExpectedResult read_any_limited(Channel &, uint16_t &, T&&...);
+    Channel::ExpectedResult skip_bytes(Channel &, uint16_t);
+    struct match_t { uint16_t v; };
+    struct callback_t { std::function<Channel::ExpectedResult()> f; };
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+namespace zb
+{
+    //the scheduler alarm: the test fires it by hand
+    struct ZbAlarm
+    {
+        using callback_t = void(*)(void*);
+        const char *m_pName;
+        ZbAlarm(const char *pName): m_pName(pName) {}
+        void Setup(callback_t cb, void *param, uint32_t ms);
+        void Cancel();
+        bool IsRunning() const;
+    };
+}
+namespace host
+{
+    //when the armed alarm is due (esp_timer_get_time() based), -1 if not armed
+    int64_t alarm_due_us();
+    //fires the alarm if it's due
+    bool alarm_fire();
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+namespace zb
+{
+    constexpr uint16_t kManufactureSpecificCluster = 0xfc00;
+    struct APILock
+    {
+        APILock() {}
+        ~APILock() {}
+    };
+}
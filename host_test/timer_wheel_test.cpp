@@ -0,0 +1,201 @@
+//The timer wheel (zb_timer_wheel.cpp) on a host clock, the scheduler alarm
+//fired by hand (stubs/): timers cascading down from the higher levels,
+//cancel and re-arm from a callback, never firing early, tick counter wrap.
+#include "zb_timer_wheel.hpp"
+#include "esp_timer.h"
+#include "zbh_alarm.hpp"
+#include <cstdio>
+#include <random>
+
+using namespace zb;
+
+namespace
+{
+    int g_Failed = 0;
+#define CHECK(cond) do{ if (!(cond)) { std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); ++g_Failed; } }while(0)
+
+    constexpr int64_t kTickUs = WheelTimer::kTickMs * 1000;
+
+    struct Probe
+    {
+        WheelTimer m_Timer;
+        int64_t m_DueUs = -1;
+        int64_t m_FiredUs = -1;
+        int m_Fires = 0;
+
+        static void on_fire(void *p)
+        {
+            auto *pP = static_cast<Probe*>(p);
+            pP->m_FiredUs = esp_timer_get_time();
+            ++pP->m_Fires;
+        }
+
+        void Setup(uint32_t ms)
+        {
+            m_DueUs = esp_timer_get_time() + int64_t(ms) * 1000;
+            m_FiredUs = -1;
+            m_Fires = 0;
+            m_Timer.Setup(&on_fire, this, ms);
+        }
+
+        //fired once, not before the requested time and at most a tick (plus the alarm ms rounding) late
+        bool OnTime() const { return m_Fires == 1 && m_FiredUs >= m_DueUs && m_FiredUs <= m_DueUs + kTickUs + 1000; }
+    };
+
+    //the clock moves from one alarm to the next up to 'untilUs'. Returns the number of wake ups
+    int run_until(int64_t untilUs)
+    {
+        int wakeUps = 0;
+        for(int64_t due = host::alarm_due_us(); due >= 0 && due <= untilUs; due = host::alarm_due_us())
+        {
+            host::set_time_us(std::max(due, esp_timer_get_time()));
+            host::alarm_fire();
+            ++wakeUps;
+        }
+        host::set_time_us(untilUs);
+        return wakeUps;
+    }
+
+    //nothing pending, the alarm gone: the next test starts clean wherever its clock is
+    void drain()
+    {
+        for(int i = 0; i < 1000 && host::alarm_due_us() >= 0; ++i)
+            run_until(host::alarm_due_us());
+        CHECK(WheelTimer::Pending() == 0);
+        CHECK(host::alarm_due_us() < 0);
+    }
+
+    void test_never_early(int64_t startUs)
+    {
+        host::set_time_us(startUs);
+        std::mt19937 rng(12345);
+        //all levels: up to ~3h, some on the same ticks
+        constexpr size_t kTimers = 300;
+        static Probe probes[kTimers];
+        for(size_t i = 0; i < kTimers; ++i)
+        {
+            const uint32_t ms = (i % 3 == 0) ? 1 + rng() % 700 : (i % 3 == 1) ? rng() % 600'000 : rng() % 10'800'000;
+            //spread the setup times over a few ticks as well
+            run_until(esp_timer_get_time() + rng() % 3000);
+            probes[i].Setup(ms);
+        }
+        run_until(esp_timer_get_time() + 4 * 3600 * int64_t(1000'000));
+        size_t onTime = 0;
+        for(auto const& p : probes)
+            onTime += p.OnTime();
+        CHECK(onTime == kTimers);
+        drain();
+    }
+
+    void test_cascade()
+    {
+        host::set_time_us(1000'000 + 3 * kTickUs / 2);//mid tick
+        //level 0, 1, 2 and 3, the last one past the max delay (clamped)
+        static Probe probes[5];
+        const uint32_t ms[] = {630, 40'000, 2'500'000, 30'000'000, 200'000'000};
+        for(size_t i = 0; i < 5; ++i)
+            probes[i].Setup(ms[i]);
+        //every cascade step re-places the timer lower, none of them fire early
+        for(size_t i = 0; i < 4; ++i)
+        {
+            run_until(probes[i].m_DueUs - 1);
+            CHECK(probes[i].m_Fires == 0);
+            run_until(probes[i].m_DueUs + kTickUs + 1000);
+            CHECK(probes[i].OnTime());
+        }
+        CHECK(WheelTimer::Pending() == 1);
+        //clamped to kMaxDelayTicks
+        const int64_t clampedUs = probes[4].m_DueUs - int64_t(ms[4]) * 1000 + int64_t(WheelTimer::kMaxDelayTicks) * kTickUs;
+        run_until(clampedUs - kTickUs);
+        CHECK(probes[4].m_Fires == 0);
+        run_until(clampedUs + kTickUs);
+        CHECK(probes[4].m_Fires == 1);
+        drain();
+    }
+
+    struct CancelProbe
+    {
+        WheelTimer m_Timer;
+        WheelTimer *m_pCancel = nullptr;//cancelled from the callback
+        int m_Fires = 0;
+        int m_Rearm = 0;//set up again from the callback that many times
+    };
+
+    void on_cancel_probe(void *p)
+    {
+        auto *pP = static_cast<CancelProbe*>(p);
+        ++pP->m_Fires;
+        if (pP->m_pCancel)
+            pP->m_pCancel->Cancel();
+        if (pP->m_Rearm-- > 0)
+            pP->m_Timer.Setup(&on_cancel_probe, p, 50);
+    }
+
+    void test_cancel_in_advance()
+    {
+        host::set_time_us(5000'000);
+        static CancelProbe a, b, c, d;
+        //same tick: whoever fires first cancels the other one, still in the detached slot
+        a.m_pCancel = &b.m_Timer;
+        b.m_pCancel = &a.m_Timer;
+        a.m_Timer.Setup(&on_cancel_probe, &a, 100);
+        b.m_Timer.Setup(&on_cancel_probe, &b, 100);
+        //a later one cancelled by c while it waits on a higher level, c re-arms itself twice
+        c.m_pCancel = &d.m_Timer;
+        c.m_Rearm = 2;
+        c.m_Timer.Setup(&on_cancel_probe, &c, 200);
+        d.m_Timer.Setup(&on_cancel_probe, &d, 60'000);
+        CHECK(WheelTimer::Pending() == 4);
+
+        run_until(esp_timer_get_time() + 120'000);
+        CHECK(a.m_Fires + b.m_Fires == 1);
+        CHECK(WheelTimer::Pending() == 2);
+        run_until(esp_timer_get_time() + 1000'000);
+        CHECK(c.m_Fires == 3);
+        CHECK(!c.m_Timer.IsRunning());
+        CHECK(!d.m_Timer.IsRunning());
+        run_until(esp_timer_get_time() + 120'000'000);
+        CHECK(d.m_Fires == 0);
+        drain();
+    }
+
+    void test_wrap()
+    {
+        //the 32 bit tick counter wraps within the delays
+        const int64_t wrapUs = (int64_t(1) << 32) * kTickUs;
+        for(int64_t before : {int64_t(5), int64_t(100), int64_t(5000), int64_t(300'000)})
+        {
+            host::set_time_us(wrapUs - before * kTickUs - kTickUs / 3);
+            static Probe probes[4];
+            const uint32_t ms[] = {200, 3000, 120'000, 3'000'000};
+            for(size_t i = 0; i < 4; ++i)
+                probes[i].Setup(ms[i]);
+            run_until(esp_timer_get_time() + 3'100'000'000);
+            for(auto const& p : probes)
+                CHECK(p.OnTime());
+            drain();
+        }
+
+        //placed on the same level as anywhere else: for 300 ticks that's level 1,
+        //one spread down and the fire. Not level 3 with a spread down at every level
+        static Probe p;
+        host::set_time_us(wrapUs - 3 * kTickUs);
+        p.Setup(3000);
+        CHECK(run_until(esp_timer_get_time() + 3'100'000) == 2);
+        CHECK(p.OnTime());
+        drain();
+
+        //and right past it
+        test_never_early(wrapUs - 20'000 * kTickUs);
+    }
+}
+
+int main()
+{
+    test_never_early(1000'000);
+    test_cascade();
+    test_cancel_in_advance();
+    test_wrap();
+    std::printf("timer_wheel: %d failed checks\n", g_Failed);
+    return g_Failed ? 1 : 0;
+}
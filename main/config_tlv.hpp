@@ -0,0 +1,124 @@
+#ifndef CONFIG_TLV_HPP_
+#define CONFIG_TLV_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+//No ESP-IDF dependencies here on purpose: the codec builds on the host as is
+//(see host_test). The storage and the CRC function come from the caller.
+namespace zb::tlv
+{
+    struct Header
+    {
+        uint16_t m_Tag;
+        uint16_t m_Len;
+    };
+
+    //a persisted member of an object: stable tag, where it is and how big
+    struct Field
+    {
+        uint16_t m_Tag;
+        uint16_t m_Offset;
+        uint16_t m_Size;
+    };
+
+    //the storage is behind the callbacks: a flash slot, a plain buffer
+    using read_fn_t = bool(*)(void *pCtx, size_t off, void *pDst, size_t n);
+    using write_fn_t = bool(*)(void *pCtx, size_t off, const void *pSrc, size_t n);
+    //same as esp_rom_crc32_le
+    using crc_fn_t = uint32_t(*)(uint32_t crc, uint8_t const *pBuf, uint32_t len);
+
+    template<size_t N>
+    struct Schema
+    {
+        Field m_Fields[N];
+        crc_fn_t m_Crc;
+
+        constexpr Field const* Find(uint16_t tag) const
+        {
+            for(auto const& f : m_Fields)
+                if (f.m_Tag == tag)
+                    return &f;
+            return nullptr;
+        }
+
+        //A single pass, nothing allocated.
+        //'len' bytes of records with a CRC 'crcExpected' into the fields of pObj.
+        //Unknown tags are skipped, missing ones are left as is. A value shorter
+        //or longer than its field fills/takes the prefix of it, a repeated tag overwrites.
+        //On failure pObj is partially written and 'off' is where the records went wrong
+        bool Decode(void *pObj, read_fn_t rd, void *pCtx, size_t len, uint32_t crcExpected, size_t &off) const
+        {
+            uint32_t crc = 0;
+            off = 0;
+            auto take = [&](void *pDst, size_t n){
+                if (!rd(pCtx, off, pDst, n))
+                    return false;
+                crc = m_Crc(crc, (const uint8_t*)pDst, n);
+                off += n;
+                return true;
+            };
+
+            bool ok = true;
+            uint8_t skip[32];
+            while(ok && off < len)
+            {
+                Header t;
+                if (len - off < sizeof(t) || !take(&t, sizeof(t)) || t.m_Len > len - off)
+                    return false;
+                auto *pF = Find(t.m_Tag);
+                const size_t n = pF ? std::min(size_t(t.m_Len), size_t(pF->m_Size)) : 0;
+                if (n)
+                    ok = take((uint8_t*)pObj + pF->m_Offset, n);
+                for(size_t rest = t.m_Len - n; ok && rest; )
+                {
+                    const size_t c = std::min(rest, sizeof(skip));
+                    ok = take(skip, c);
+                    rest -= c;
+                }
+            }
+            return ok && crc == crcExpected;
+        }
+
+        //all the fields of pObj in the schema order. Returns the number of bytes written, 0 on failure
+        size_t Encode(const void *pObj, write_fn_t wr, void *pCtx, uint32_t &crc) const
+        {
+            //staged, so that the flash sees a few bigger writes
+            uint8_t buf[64];
+            size_t used = 0, off = 0;
+            bool ok = true;
+            crc = 0;
+            auto flush = [&]{
+                if (ok && used)
+                    ok = wr(pCtx, off, buf, used);
+                off += used;
+                used = 0;
+            };
+            auto put = [&](const void *pSrc, size_t n){
+                crc = m_Crc(crc, (const uint8_t*)pSrc, n);
+                for(const uint8_t *p = (const uint8_t*)pSrc; n; )
+                {
+                    const size_t c = std::min(n, sizeof(buf) - used);
+                    std::memcpy(buf + used, p, c);
+                    used += c;
+                    p += c;
+                    n -= c;
+                    if (used == sizeof(buf))
+                        flush();
+                }
+            };
+
+            for(auto const& f : m_Fields)
+            {
+                Header t{f.m_Tag, f.m_Size};
+                put(&t, sizeof(t));
+                put((const uint8_t*)pObj + f.m_Offset, f.m_Size);
+            }
+            flush();
+            return ok ? off : 0;
+        }
+    };
+}
+#endif
@@ -1,6 +1,7 @@
 #ifndef DEVICE_COMMON_HPP_
 #define DEVICE_COMMON_HPP_
 #include <cstdint>
+#include <cstring>
 #include "periph/ld2412_component.hpp"
 
 namespace zb
@@ -49,5 +50,76 @@ namespace zb
 
         uint16_t GetRaw() const { return *(const uint16_t *)this; }
     };
+
+    //Outcome of the reporting check of bound devices, by IEEE address and endpoint.
+    //Independent of the position of a bind in the binding table.
+    //An entry expires after kMaxAgeBoots restarts of this device and is
+    //dropped when the device announces itself (re-paired, power cycled, updated).
+    template<size_t N>
+    struct BindCapsCache
+    {
+        static constexpr size_t kEntries = N;
+        static constexpr uint16_t kMaxAgeBoots = 16;
+        struct Entry
+        {
+            uint8_t m_IEEE[8];
+            uint8_t m_EP;
+            TriState m_Reporting        : 2 = TriState::Undefined;//Undefined - free entry
+            uint16_t m_ReportConfigured : 1 = 0;
+            uint16_t m_CheckedAtBoot;//restarts counter at the time of the check
+
+            bool Matches(const uint8_t (&ieee)[8], uint8_t ep) const
+            {
+                return m_Reporting != TriState::Undefined && m_EP == ep && !std::memcmp(m_IEEE, ieee, sizeof(m_IEEE));
+            }
+        };
+        Entry m_Entries[kEntries];
+
+        //expired entries are not found
+        const Entry* Find(const uint8_t (&ieee)[8], uint8_t ep, uint16_t boot) const
+        {
+            for(auto const& e : m_Entries)
+                if (e.Matches(ieee, ep))
+                    return uint16_t(boot - e.m_CheckedAtBoot) <= kMaxAgeBoots ? &e : nullptr;
+            return nullptr;
+        }
+
+        //replaces the entry of the same device, a free one or the one checked the longest ago
+        void Put(const uint8_t (&ieee)[8], uint8_t ep, bool capable, bool reportConfigured, uint16_t boot)
+        {
+            Entry *pDst = nullptr;
+            for(auto &e : m_Entries)
+            {
+                if (e.Matches(ieee, ep))
+                {
+                    pDst = &e;
+                    break;
+                }
+                if (!pDst || (pDst->m_Reporting != TriState::Undefined 
+                            && (e.m_Reporting == TriState::Undefined || uint16_t(boot - e.m_CheckedAtBoot) > uint16_t(boot - pDst->m_CheckedAtBoot))))
+                    pDst = &e;
+            }
+            std::memcpy(pDst->m_IEEE, ieee, sizeof(pDst->m_IEEE));
+            pDst->m_EP = ep;
+            pDst->m_Reporting = capable ? TriState::True : TriState::False;
+            pDst->m_ReportConfigured = reportConfigured;
+            pDst->m_CheckedAtBoot = boot;
+        }
+
+        void Remove(const uint8_t (&ieee)[8], uint8_t ep)
+        {
+            for(auto &e : m_Entries)
+                if (e.Matches(ieee, ep))
+                    e.m_Reporting = TriState::Undefined;
+        }
+
+        //all endpoints of a device
+        void RemoveDevice(const uint8_t (&ieee)[8])
+        {
+            for(auto &e : m_Entries)
+                if (e.m_Reporting != TriState::Undefined && !std::memcmp(e.m_IEEE, ieee, sizeof(e.m_IEEE)))
+                    e.m_Reporting = TriState::Undefined;
+        }
+    };
 }
 #endif
@@ -1,166 +1,492 @@
 #include "device_config.hpp"
 #include "esp_log.h"
 #include <sys/stat.h>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
 #include "esp_littlefs.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_system.h"
+#include "esp_timer.h"
 #include "lib_misc_helpers.hpp"
+#include "zbh_helpers.hpp"
+#include "zb/zb_timer_wheel.hpp"
 
-static const char *TAG = "esp_littlefs";
+static const char *TAG = "local_config";
 namespace zb
 {
     static const char *kBasePath = "/littlefs";
     static const char *kConfigFilePath = "/littlefs/config.dat";
     static const char *kParitionLabel = "zb_config";
-    esp_err_t LocalConfig::on_start()
+    static WheelTimer g_FlushTimer;
+    extern LocalConfig g_Config;
+
+    /**********************************************************************/
+    /* TLV schema                                                         */
+    /**********************************************************************/
+#define CONFIG_FIELD(tag, field) {uint16_t(Tag::tag), uint16_t(offsetof(LocalConfig, field)), uint16_t(sizeof(LocalConfig::field))}
+    const tlv::Schema<LocalConfig::kFieldCount> LocalConfig::kSchema = {
+        .m_Fields = {
+            CONFIG_FIELD(OnOffTimeout, m_OnOffTimeout),
+            CONFIG_FIELD(OnOffMode, m_OnOffMode),
+            CONFIG_FIELD(PresenceDetectionMode, m_PresenceDetectionMode),
+            CONFIG_FIELD(LD2412Mode, m_LD2412Mode),
+            CONFIG_FIELD(IlluminanceThreshold, m_IlluminanceThreshold),
+            CONFIG_FIELD(ExternalOnOffTimeout, m_ExternalOnOffTimeout),
+            CONFIG_FIELD(Restarts, m_Restarts),
+            CONFIG_FIELD(ReportPolicy, m_ReportPolicy),
+            CONFIG_FIELD(ApproachDistance, m_ApproachDistance),
+            CONFIG_FIELD(NoiseFloor, m_NoiseFloor),
+            CONFIG_FIELD(Zones, m_Zones),
+            CONFIG_FIELD(PerBindDelivery, m_PerBindDelivery),
+            CONFIG_FIELD(ActiveReportingCheck, m_ActiveReportingCheck),
+            CONFIG_FIELD(BindCaps, m_BindCaps),
+        },
+        .m_Crc = &esp_rom_crc32_le
+    };
+#undef CONFIG_FIELD
+
+    bool LocalConfig::decode(read_fn_t rd, void *pCtx, size_t len, uint32_t crcExpected)
     {
-        ESP_LOGI(TAG, "Initializing LittleFS");
+        *this = {};
+        size_t off;
+        if (!kSchema.Decode(this, rd, pCtx, len, crcExpected, off))
+        {
+            ESP_LOGW(TAG, "Invalid config records at %d of %d", (int)off, (int)len);
+            *this = {};
+            return false;
+        }
+        m_Version = kActualStreamingVersion;
+        return true;
+    }
 
-        esp_vfs_littlefs_conf_t conf = {
-            .base_path = kBasePath,
-            .partition_label = kParitionLabel,
-            .partition = nullptr,
-            .format_if_mount_failed = true,
-            .read_only = false,
-            .dont_mount = false,
-            .grow_on_mount = true
-        };
+    size_t LocalConfig::encode(write_fn_t wr, void *pCtx, uint32_t &crc) const
+    {
+        return kSchema.Encode(this, wr, pCtx, crc);
+    }
 
-        esp_err_t ret = esp_vfs_littlefs_register(&conf);
+    /**********************************************************************/
+    /* A/B slots                                                          */
+    /**********************************************************************/
+    //The config partition is used raw: a flash sector per slot.
+    //Every write goes to the slot not holding the latest copy, the header
+    //is written last. On boot the valid slot with the highest sequence
+    //number wins, so an interrupted write just leaves the previous copy.
+    static constexpr size_t kSlotSize = 4096;//flash sector
+    static constexpr size_t kSlots = 2;
+    static constexpr uint32_t kSlotMagic = 0x4746434c;//'LCFG'
+    enum class SlotFormat: uint16_t
+    {
+        Raw = 0,//the LocalConfig struct as is
+        TLV = 1,
+    };
+    struct SlotHeader
+    {
+        uint32_t m_Magic;
+        uint32_t m_Seq;
+        uint16_t m_Len;//payload
+        SlotFormat m_Format;
+        uint32_t m_Crc;//payload
+    };
+    static_assert(sizeof(SlotHeader) + sizeof(LocalConfig) + LocalConfig::kFieldCount * sizeof(LocalConfig::TlvHeader) <= kSlotSize, "config doesn't fit into a slot");
 
-        if (ret != ESP_OK) {
-            if (ret == ESP_FAIL) {
-                ESP_LOGE(TAG, "Failed to mount or format filesystem");
-            } else if (ret == ESP_ERR_NOT_FOUND) {
-                ESP_LOGE(TAG, "Failed to find LittleFS partition");
-            } else {
-                ESP_LOGE(TAG, "Failed to initialize LittleFS (%s)", esp_err_to_name(ret));
-            }
-            return ret;
+    static const esp_partition_t *g_pPartition = nullptr;
+    static uint32_t g_Seq = 0;//of the latest copy
+    static uint8_t g_ActiveSlot = kSlots - 1;//holds the latest copy, the next write goes to the other one
+    alignas(LocalConfig) static uint8_t g_LoadBuf[sizeof(LocalConfig)];
+
+    static bool read_partition(void *pCtx, size_t off, void *pDst, size_t n)
+    {
+        return esp_partition_read(g_pPartition, *(size_t*)pCtx + off, pDst, n) == ESP_OK;
+    }
+
+    static bool write_partition(void *pCtx, size_t off, const void *pSrc, size_t n)
+    {
+        return esp_partition_write(g_pPartition, *(size_t*)pCtx + off, pSrc, n) == ESP_OK;
+    }
+
+    static bool read_slot_header(uint8_t slot, SlotHeader &h)
+    {
+        if (esp_partition_read(g_pPartition, slot * kSlotSize, &h, sizeof(h)) != ESP_OK)
+            return false;
+        return h.m_Magic == kSlotMagic && h.m_Len <= kSlotSize - sizeof(h);
+    }
+
+    //raw format only, TLV checks it while decoding
+    static bool check_raw_slot_crc(uint8_t slot, SlotHeader const& h)
+    {
+        //the payload may be longer than we know (written with more binds): crc in chunks
+        const size_t off = slot * kSlotSize + sizeof(h);
+        uint32_t crc = 0;
+        uint8_t chunk[64];
+        for(size_t done = 0; done < h.m_Len; )
+        {
+            const size_t n = std::min(sizeof(chunk), size_t(h.m_Len - done));
+            if (esp_partition_read(g_pPartition, off + done, chunk, n) != ESP_OK)
+                return false;
+            crc = esp_rom_crc32_le(crc, chunk, n);
+            done += n;
         }
+        return crc == h.m_Crc;
+    }
 
-        struct stat st;
-        if (stat(kConfigFilePath, &st) == 0) {
-            //exists
-            FILE *f = fopen(kConfigFilePath, "rb");
-            if (!f)
+    bool LocalConfig::load(const uint8_t *pData, size_t sz)
+    {
+        uint32_t v;
+        if (sz < sizeof(v))
+        {
+            ESP_LOGE(TAG, "Config too short to have a version: %d", sz);
+            return false;
+        }
+        std::memcpy(&v, pData, sizeof(v));
+        if (v == kActualStreamingVersion)
+        {
+            //m_BindCaps at the end depends on kMaxBinds: data written with fewer binds
+            //is shorter, the missing entries just stay empty
+            if (sz < streamed_size(kActualStreamingVersion - 1))
             {
-                ESP_LOGE(TAG, "Failed to open existin file %s for binary reading", kConfigFilePath);
-                return ESP_FAIL;
+                ESP_LOGE(TAG, "Config too short: %d", sz);
+                return false;
             }
-            ScopeExit cleanup = [&]{ if (f) fclose(f);};
-            if (size_t r = fread(this, 1, sizeof(m_Version), f); r != sizeof(m_Version))
+            std::memcpy((void*)this, pData, std::min(sz, sizeof(LocalConfig)));
+        }else if (v < kActualStreamingVersion)
+        {
+            //older version: take what it had, the rest keeps the defaults
+            if (sz < streamed_size(v))
             {
-                ESP_LOGE(TAG, "Failed to read version from existing config file %s", kConfigFilePath);
-                ESP_LOGE(TAG, "Read: %d; File size: %d", r, (size_t)st.st_size);
-                fclose(f);
-                f = nullptr;
-                ++m_Restarts;
-                return on_change();//we must always write the up-to-date version after conversion
+                ESP_LOGE(TAG, "v%d config too short: %d", (int)v, sz);
+                return false;
             }
+            std::memcpy((void*)this, pData, streamed_size(v));
+            m_Version = kActualStreamingVersion;
+            ESP_LOGI(TAG, "Converted config from v%d to v%d", (int)v, (int)kActualStreamingVersion);
+        }else
+        {
+            //here be dragons. Newer than we know, start from defaults
+            ESP_LOGE(TAG, "Config v%d is newer than v%d", (int)v, (int)kActualStreamingVersion);
+            return false;
+        }
+        return true;
+    }
+
+    bool LocalConfig::load_slots()
+    {
+        SlotHeader h[kSlots];
+        bool valid[kSlots];
+        for(uint8_t i = 0; i < kSlots; ++i)
+            valid[i] = read_slot_header(i, h[i]);
+
+        //newest first, wrap safe
+        uint8_t order[kSlots] = {0, 1};
+        if (valid[0] && valid[1] && int32_t(h[1].m_Seq - h[0].m_Seq) > 0)
+            std::swap(order[0], order[1]);
 
-            if (m_Version == kActualStreamingVersion)
+        for(uint8_t slot : order)
+        {
+            if (!valid[slot])
+                continue;
+            size_t off = slot * kSlotSize + sizeof(SlotHeader);
+            bool ok = false;
+            if (h[slot].m_Format == SlotFormat::TLV)
+                ok = decode(&read_partition, &off, h[slot].m_Len, h[slot].m_Crc);
+            else if (h[slot].m_Format == SlotFormat::Raw && check_raw_slot_crc(slot, h[slot]))
             {
-                constexpr const size_t kRestToRead = sizeof(LocalConfig) - sizeof(m_Version);
-                if (size_t r = fread(&m_Version + 1, 1, kRestToRead, f); r != kRestToRead)
-                {
-                    ESP_LOGE(TAG, "Failed to read rest from existing config file %s (read: %d)", kConfigFilePath, r);
-                    return ESP_ERR_INVALID_SIZE;
-                }
-
-                ++m_Restarts;
-                return on_change();
-            }else
+                const size_t sz = std::min(size_t(h[slot].m_Len), sizeof(g_LoadBuf));
+                ok = read_partition(&off, 0, g_LoadBuf, sz) && load(g_LoadBuf, sz);
+            }
+            if (!ok)
             {
-                //here be dragons. I mean streaming conversion
-                fclose(f);
-                f = nullptr;
-                return on_change();//we must always write the up-to-date version after conversion
+                ESP_LOGW(TAG, "Config slot %d (seq %d) is not usable", slot, (int)h[slot].m_Seq);
+                continue;
             }
-        }else //doesn't exist. create new
-            return on_change();
+            g_Seq = h[slot].m_Seq;
+            g_ActiveSlot = slot;
+            ESP_LOGI(TAG, "Config from slot %d (seq %d)", slot, (int)g_Seq);
+            return true;
+        }
+        return false;
     }
 
-    esp_err_t LocalConfig::on_change()
+    //config.dat on LittleFS, the format before the A/B slots. Read once, then the partition is reused raw
+    bool LocalConfig::load_legacy()
+    {
+        const int64_t start = esp_timer_get_time();
+        esp_vfs_littlefs_conf_t conf = {
+            .base_path = kBasePath,
+            .partition_label = kParitionLabel,
+            .partition = nullptr,
+            .format_if_mount_failed = false,
+            .read_only = true,
+            .dont_mount = false,
+            .grow_on_mount = false
+        };
+        if (esp_vfs_littlefs_register(&conf) != ESP_OK)
+            return false;
+        const int64_t mounted = esp_timer_get_time();
+
+        size_t r = 0;
+        if (FILE *f = fopen(kConfigFilePath, "rb"))
+        {
+            r = fread(g_LoadBuf, 1, sizeof(g_LoadBuf), f);
+            fclose(f);
+        }
+        esp_vfs_littlefs_unregister(kParitionLabel);
+        ESP_LOGI(TAG, "LittleFS config: mount %d us, read %d us (%d bytes)", int(mounted - start), int(esp_timer_get_time() - mounted), r);
+
+        return r && load(g_LoadBuf, r);
+    }
+
+    esp_err_t LocalConfig::on_start()
     {
-        FILE *f = fopen(kConfigFilePath, "wb");
-        if (!f)
+        esp_register_shutdown_handler(&on_shutdown);
+
+        const int64_t start = esp_timer_get_time();
+        g_pPartition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, kParitionLabel);
+        if (!g_pPartition)
         {
-            ESP_LOGE(TAG, "Failed to open for writing file %s", kConfigFilePath);
+            ESP_LOGE(TAG, "Failed to find config partition %s", kParitionLabel);
             return ESP_ERR_NOT_FOUND;
         }
-        ScopeExit cleanup = [&]{fclose(f);};
-        if (size_t r = fwrite(this, 1, sizeof(LocalConfig), f); r != sizeof(LocalConfig))
+        if (g_pPartition->size < kSlots * kSlotSize)
         {
-            ESP_LOGE(TAG, "Failed to write config file %s (written: %d)", kConfigFilePath, r);
+            ESP_LOGE(TAG, "Config partition is too small: %d", (int)g_pPartition->size);
             return ESP_ERR_INVALID_SIZE;
         }
+
+        bool loaded = load_slots();
+        if (!loaded)
+        {
+            loaded = load_legacy();
+            if (loaded)
+                ESP_LOGI(TAG, "Migrating config from LittleFS");
+            if (esp_err_t e = esp_partition_erase_range(g_pPartition, 0, kSlots * kSlotSize); e != ESP_OK)
+                ESP_LOGE(TAG, "Failed to erase config partition: %s", esp_err_to_name(e));
+        }
+        ESP_LOGI(TAG, "Config %s in %d us", loaded ? "loaded" : "defaulted", int(esp_timer_get_time() - start));
+
+        if (loaded)
+            ++m_Restarts;
+        return store();//we must always write the up-to-date version after conversion
+    }
+
+    size_t LocalConfig::streamed_size(uint32_t v)
+    {
+        switch(v)
+        {
+            case 1: return 16;//up to and including m_BindReporting
+            case 2: return 30;//up to and including m_ReportPolicy
+            case 3: return 32;//up to and including m_ApproachDistance
+            case 4: return 63;//up to and including m_NoiseFloor
+            case 5: return 79;//up to and including m_Zones
+            case 6: return 80;//up to and including m_PerBindDelivery
+            case 7: return 81;//up to and including m_ActiveReportingCheck
+            default: return sizeof(LocalConfig);
+        }
+    }
+
+    esp_err_t LocalConfig::on_change()
+    {
+        ++g_WriteStats.m_Changes;
+        if (!kFlushDelayMs)
+            return store();
+
+        g_Dirty = true;
+        //not re-armed by further changes: a steady stream of them still gets written
+        if (!g_FlushTimer.IsRunning())
+            g_FlushTimer.Setup([](void *p){ ((LocalConfig *)p)->Flush(); }, this, kFlushDelayMs);
+        return ESP_OK;
+    }
+
+    esp_err_t LocalConfig::Flush()
+    {
+        g_FlushTimer.Cancel();
+        if (!g_Dirty)
+            return ESP_OK;
+        return store();
+    }
+
+    void LocalConfig::on_shutdown()
+    {
+        //only set with the flush timer armed, so the zigbee stack (and its lock) exists
+        if (!g_Dirty)
+            return;
+        //esp_restart may come from any task: the flush timer and the slots
+        //belong to the zigbee task. The lock is recursive, restarts from the zigbee task are fine
+        APILock l;
+        ESP_LOGI(TAG, "Flushing config before restart");
+        g_Config.Flush();
+    }
+
+    esp_err_t LocalConfig::store()
+    {
+        if (!g_pPartition)
+            return ESP_ERR_INVALID_STATE;
+        g_Dirty = false;
+        ++g_WriteStats.m_Writes;
+
+        const uint8_t slot = (g_ActiveSlot + 1) % kSlots;
+        size_t off = slot * kSlotSize;
+        SlotHeader h{
+            .m_Magic = kSlotMagic,
+            .m_Seq = g_Seq + 1,
+            .m_Len = 0,
+            .m_Format = SlotFormat::TLV,
+            .m_Crc = 0
+        };
+        esp_err_t e = esp_partition_erase_range(g_pPartition, off, kSlotSize);
+        if (e == ESP_OK)
+        {
+            size_t payloadOff = off + sizeof(h);
+            h.m_Len = encode(&write_partition, &payloadOff, h.m_Crc);
+            if (!h.m_Len)
+                e = ESP_FAIL;
+        }
+        if (e == ESP_OK)
+            e = esp_partition_write(g_pPartition, off, &h, sizeof(h));
+        if (e != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Failed to write config slot %d: %s", slot, esp_err_to_name(e));
+            ++g_WriteStats.m_Failures;
+            return e;
+        }
+        g_WriteStats.m_Bytes += sizeof(h) + h.m_Len;
+        g_Seq = h.m_Seq;
+        g_ActiveSlot = slot;
         return ESP_OK;
     }
 
     void LocalConfig::on_end()
     {
-        esp_vfs_littlefs_unregister(kParitionLabel);
-        ESP_LOGI(TAG, "LittleFS unmounted");
+        Flush();
     }
 
     void LocalConfig::SetVersion(uint32_t v)
     {
+        if (m_Version == v)
+            return;
         m_Version = v;
         on_change();
     }
 
     void LocalConfig::SetOnOffTimeout(uint16_t v)
     {
+        if (m_OnOffTimeout == v)
+            return;
         m_OnOffTimeout = v;
         on_change();
     }
 
     void LocalConfig::SetExternalOnOffTimeout(uint16_t v)
     {
+        if (m_ExternalOnOffTimeout == v)
+            return;
         m_ExternalOnOffTimeout = v;
         on_change();
     }
 
     void LocalConfig::SetOnOffMode(OnOffMode v)
     {
+        if (m_OnOffMode == v)
+            return;
         m_OnOffMode = v;
         on_change();
     }
 
     void LocalConfig::SetPresenceDetectionMode(PresenceDetectionMode v)
     {
+        if (m_PresenceDetectionMode.m_Raw == v.m_Raw)
+            return;
         m_PresenceDetectionMode = v;
         on_change();
     }
 
     void LocalConfig::SetLD2412Mode(LD2412::SystemMode v)
     {
+        if (m_LD2412Mode == v)
+            return;
         m_LD2412Mode = v;
         on_change();
     }
 
     void LocalConfig::SetIlluminanceThreshold(uint8_t v)
     {
+        if (m_IlluminanceThreshold == v)
+            return;
         m_IlluminanceThreshold = v;
         on_change();
     }
 
     void LocalConfig::SetIlluminanceExternal(bool v)
     {
+        if (m_PresenceDetectionMode.m_Illuminance_External == v)
+            return;
         m_PresenceDetectionMode.m_Illuminance_External = v;
         on_change();
     }
 
-    void LocalConfig::SetBindReporting(TriState8Array v)
+    void LocalConfig::SetBindCaps(BindCaps const& v)
+    {
+        if (!memcmp(&m_BindCaps, &v, sizeof(v)))
+            return;
+        m_BindCaps = v;
+        on_change();
+    }
+
+    void LocalConfig::SetReportPolicy(ld2412::Component::ReportPolicy const& v)
     {
-        m_BindReporting = v;
+        if (!memcmp(&m_ReportPolicy, &v, sizeof(v)))
+            return;
+        m_ReportPolicy = v;
+        on_change();
+    }
+
+    void LocalConfig::SetApproachDistance(uint16_t v)
+    {
+        if (m_ApproachDistance == v)
+            return;
+        m_ApproachDistance = v;
+        on_change();
+    }
+
+    void LocalConfig::SetNoiseFloor(ld2412::Component::NoiseFloorConfig const& v)
+    {
+        if (!memcmp(&m_NoiseFloor, &v, sizeof(v)))
+            return;
+        m_NoiseFloor = v;
+        on_change();
+    }
+
+    void LocalConfig::SetZones(ld2412::Component::ZonesConfig const& v)
+    {
+        if (!memcmp(&m_Zones, &v, sizeof(v)))
+            return;
+        m_Zones = v;
+        on_change();
+    }
+
+    void LocalConfig::SetPerBindDelivery(bool v)
+    {
+        if (m_PerBindDelivery == v)
+            return;
+        m_PerBindDelivery = v;
+        on_change();
+    }
+
+    void LocalConfig::SetActiveReportingCheck(bool v)
+    {
+        if (m_ActiveReportingCheck == v)
+            return;
+        m_ActiveReportingCheck = v;
         on_change();
     }
 
     void LocalConfig::FactoryReset()
     {
-        esp_littlefs_format(kParitionLabel);
+        g_FlushTimer.Cancel();
+        if (g_pPartition)
+            esp_partition_erase_range(g_pPartition, 0, kSlots * kSlotSize);
         *this = {};
-        on_change();
-        on_end();
+        store();
     }
 }
@@ -3,13 +3,57 @@
 
 #include "esp_err.h"
 #include "device_common.hpp"
+#include "zb/zb_dev_def_const.hpp"
+#include "config_tlv.hpp"
+
+//delay between a config change and its write to flash. Changes within the delay
+//are written together. 0 - write right away
+#if !defined(CONFIG_FLUSH_DELAY_MS)
+#define CONFIG_FLUSH_DELAY_MS 2000
+#endif
 
 namespace zb
 {
     struct LocalConfig
     {
-        static constexpr uint32_t kActualStreamingVersion = 1;
+        static constexpr uint32_t kActualStreamingVersion = 8;
         static constexpr uint8_t kMaxIlluminance = 255;
+        static constexpr uint32_t kFlushDelayMs = CONFIG_FLUSH_DELAY_MS;
+
+        //no member initializers: an instance is a static member below (zero initialized)
+        struct WriteStats
+        {
+            uint32_t m_Changes;//Set* calls that changed something
+            uint32_t m_Writes;//slot writes
+            uint32_t m_Bytes;
+            uint32_t m_Failures;
+        };
+
+        //Persisted as tag-length-value records with a stable tag per field.
+        //Unknown tags are skipped and missing ones keep the defaults. A value
+        //shorter or longer than its field fills/takes the prefix of it (structs only grow at the end).
+        //Never renumber or reuse a tag.
+        enum class Tag: uint16_t
+        {
+            OnOffTimeout          = 1,
+            OnOffMode             = 2,
+            PresenceDetectionMode = 3,
+            LD2412Mode            = 4,
+            IlluminanceThreshold  = 5,
+            ExternalOnOffTimeout  = 6,
+            Restarts              = 7,
+            ReportPolicy          = 8,
+            ApproachDistance      = 9,
+            NoiseFloor            = 10,
+            Zones                 = 11,
+            PerBindDelivery       = 12,
+            ActiveReportingCheck  = 13,
+            BindCaps              = 14,
+        };
+        static constexpr size_t kFieldCount = 14;
+        using TlvHeader = tlv::Header;
+        using read_fn_t = tlv::read_fn_t;
+        using write_fn_t = tlv::write_fn_t;
 
         union PresenceDetectionMode
         {
@@ -34,7 +78,23 @@ namespace zb
         uint8_t m_IlluminanceThreshold = kMaxIlluminance; //Illuminance<=Threashold -> active, sending on/off commands
         uint16_t m_ExternalOnOffTimeout = 3;
         uint16_t m_Restarts = 0;
-        TriState8Array m_BindReporting;
+        TriState8Array m_BindReporting;//not used since v8, see m_BindCaps
+        //v2
+        ld2412::Component::ReportPolicy m_ReportPolicy;
+        //v3
+        uint16_t m_ApproachDistance = 0;//cm; 0 - approaching target doesn't trigger presence
+        //v4
+        ld2412::Component::NoiseFloorConfig m_NoiseFloor;
+        //v5
+        ld2412::Component::ZonesConfig m_Zones;
+        //v6
+        bool m_PerBindDelivery = false;//on/off commands as a unicast per bound device instead of the binding table send
+        //v7
+        bool m_ActiveReportingCheck = false;//verify reporting of a bind by toggling it instead of a passive check
+        //v8
+        //the last field on purpose: it's sized by kMaxBinds
+        using BindCaps = BindCapsCache<kMaxBinds>;
+        BindCaps m_BindCaps;
     public:
         auto GetVersion() const { return m_Version; }
         auto GetOnOffTimeout() const { return m_OnOffTimeout; }
@@ -45,8 +105,15 @@ namespace zb
         bool GetIlluminanceExternal() const { return m_PresenceDetectionMode.m_Illuminance_External; }
         auto GetExternalOnOffTimeout() const { return m_ExternalOnOffTimeout; }
         auto GetRestarts() const { return m_Restarts; }
-        auto GetBindReporting() const { return m_BindReporting; }
+        auto const& GetReportPolicy() const { return m_ReportPolicy; }
+        auto GetApproachDistance() const { return m_ApproachDistance; }
+        auto const& GetNoiseFloor() const { return m_NoiseFloor; }
+        auto const& GetZones() const { return m_Zones; }
+        bool GetPerBindDelivery() const { return m_PerBindDelivery; }
+        bool GetActiveReportingCheck() const { return m_ActiveReportingCheck; }
+        auto const& GetBindCaps() const { return m_BindCaps; }
 
+        //all setters only count a change and schedule a write if the value differs
         void SetVersion(uint32_t v);
         void SetOnOffTimeout(uint16_t v);
         void SetOnOffMode(OnOffMode v);
@@ -55,13 +122,46 @@ namespace zb
         void SetIlluminanceThreshold(uint8_t v);
         void SetIlluminanceExternal(bool v);
         void SetExternalOnOffTimeout(uint16_t v);
-        void SetBindReporting(TriState8Array v);
+        void SetReportPolicy(ld2412::Component::ReportPolicy const& v);
+        void SetApproachDistance(uint16_t v);
+        void SetNoiseFloor(ld2412::Component::NoiseFloorConfig const& v);
+        void SetZones(ld2412::Component::ZonesConfig const& v);
+        void SetPerBindDelivery(bool v);
+        void SetActiveReportingCheck(bool v);
+        void SetBindCaps(BindCaps const& v);
 
         void FactoryReset();
 
         esp_err_t on_start();
+        //size of the data persisted by a given version. Fields are only ever appended
+        //so an older version is a prefix of the actual one
+        static size_t streamed_size(uint32_t v);
+        //write-behind: marks the config dirty and schedules a flush (zigbee task only)
         esp_err_t on_change();
+        //writes pending changes right away (zigbee task or APILock). Also done on esp_restart
+        esp_err_t Flush();
+        bool IsDirty() const { return g_Dirty; }
+        static WriteStats const& GetWriteStats() { return g_WriteStats; }
         void on_end();
+
+        //TLV codec (config_tlv.hpp).
+        //decode: 'len' bytes of records with a CRC32 'crc'. Defaults on failure
+        bool decode(read_fn_t rd, void *pCtx, size_t len, uint32_t crc);
+        //returns the number of bytes written, 0 on failure
+        size_t encode(write_fn_t wr, void *pCtx, uint32_t &crc) const;
+    private:
+        static const tlv::Schema<kFieldCount> kSchema;
+
+        //raw struct as persisted by v1-v8 (config.dat, first A/B slots)
+        bool load(const uint8_t *pData, size_t sz);
+        bool load_slots();
+        bool load_legacy();
+        esp_err_t store();
+        static void on_shutdown();
+
+        //not persisted
+        static inline bool g_Dirty = false;
+        static inline WriteStats g_WriteStats;
     };
 }
 #endif
@@ -15,9 +15,11 @@
 #include "driver/gpio.h"
 
 #include "zb/zb_main.hpp"
+#include "zb/zb_boot_timeline.hpp"
 
 extern "C" void app_main(void)
 {
+    zb::BootTimeline::Mark(zb::BootTimeline::Phase::AppMain);
     /* Print chip information */
     esp_chip_info_t chip_info;
     esp_chip_info(&chip_info);
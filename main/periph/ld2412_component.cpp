@@ -3,6 +3,7 @@
 #include "ld2412_component.hpp"
 #include "driver/gpio.h"
 #include "lib_thread.hpp"
+#include <algorithm>
 
 namespace ld2412
 {
@@ -26,7 +27,6 @@ namespace ld2412
             Presence,
             PresenceIntr,
             PIRPresenceIntr,
-            GatesEnergyState,
             //config
             SetTimeout,
             SetMinDistance,
@@ -35,6 +35,10 @@ namespace ld2412
             SetMoveSensitivity,
             SetStillSensitivity,
             SetDistanceRes,
+            SetReportPolicy,
+            SetNoiseFloor,
+            SetZone,
+            ZonesState,
         };
 
         Type m_Type;
@@ -56,7 +60,10 @@ namespace ld2412
                 uint8_t m_ChangeDistanceMove: 1;
                 uint8_t m_ChangeEnergyStill: 1;
                 uint8_t m_ChangeEnergyMove: 1;
-                uint8_t m_Dummy;
+
+                uint8_t m_ChangeApproaching: 1;
+                uint8_t m_Dummy: 7;
+                int16_t m_ApproachSpeed;
 
                 bool changed() const
                 {
@@ -65,7 +72,8 @@ namespace ld2412
                         || m_ChangeEnergyMove 
                         || m_ChangeEnergyStill
                         || m_ChangeDistanceMove 
-                        || m_ChangeDistanceStill;
+                        || m_ChangeDistanceStill
+                        || m_ChangeApproaching;
                 }
             }m_Presence;
             struct{
@@ -82,8 +90,96 @@ namespace ld2412
             LD2412::DistanceRes m_DistRes;
             uint8_t m_Sensitivity[14];
             bool m_Bluetooth;
+            uint8_t m_ReportPolicy[sizeof(ReportPolicy)];//ReportPolicy is not trivial, copied raw
+            struct{
+                bool m_Enabled;
+                uint8_t m_MaxDelta;
+            }m_NoiseFloor;
+            struct{
+                uint8_t m_Index;
+                Zone m_Zone;
+            }m_SetZone;
+            uint8_t m_ZonesOccupied;
         };
     };
+    static_assert(sizeof(Component::ReportPolicy) <= sizeof(Component::QueueMsg::m_Sensitivity), "Report policy must not grow the queue message");
+
+    void Component::DistanceTracker::Update(uint16_t measured, TickType_t t)
+    {
+        const int32_t z = int32_t(measured) << kFrac;
+        const uint32_t dtMs = pdTICKS_TO_MS(t - m_LastTick);
+        m_LastTick = t;
+        if (!m_Valid || dtMs > kMaxGapMs)
+        {
+            m_Pos = z;
+            m_Vel = 0;
+            m_Valid = true;
+            return;
+        }
+        if (!dtMs)
+            return;
+
+        //predict
+        const int32_t predicted = m_Pos + m_Vel * int32_t(dtMs) / 1000;
+        const int32_t r = z - predicted;
+        //correct
+        m_Pos = predicted + ((kAlpha * r) >> kFrac);
+        m_Vel += ((kBeta * r) >> kFrac) * 1000 / int32_t(dtMs);
+        if (m_Pos < 0) m_Pos = 0;
+    }
+
+    void Component::NoiseFloorTracker::Stat::Update(uint8_t e, bool first)
+    {
+        const int32_t x = int32_t(e) << kFrac;
+        if (first)
+        {
+            m_Mean = uint16_t(x);
+            m_Dev = 0;
+            return;
+        }
+        const int32_t mean = m_Mean + ((x - int32_t(m_Mean)) >> kShift);
+        const int32_t dev = m_Dev + ((std::abs(x - mean) - int32_t(m_Dev)) >> kShift);
+        m_Mean = uint16_t(mean);
+        m_Dev = uint16_t(std::max(dev, int32_t(0)));
+    }
+
+    uint8_t Component::NoiseFloorTracker::Stat::Target() const
+    {
+        const int32_t t = ((int32_t(m_Mean) + kDevFactor * int32_t(m_Dev)) >> kFrac) + kMargin;
+        return uint8_t(std::min(t, int32_t(100)));
+    }
+
+    void Component::NoiseFloorTracker::Update(uint8_t gate, uint8_t move, uint8_t still)
+    {
+        const bool first = m_Frames == 0;
+        m_Move[gate].Update(move, first);
+        m_Still[gate].Update(still, first);
+    }
+
+    uint8_t Component::NoiseFloorTracker::Nudge(uint8_t current, uint8_t target, uint8_t base, uint8_t maxDelta)
+    {
+        const int lo = std::max(int(base) - int(maxDelta), 0);
+        const int hi = std::min(int(base) + int(maxDelta), 100);
+        const int t = std::clamp(int(target), lo, hi);
+        //one step at a time
+        if (t > current) return current + 1;
+        if (t < current) return current - 1;
+        return current;
+    }
+
+    //returns true if the change from 'reported' to 'now' must be reported according to the policy
+    static bool report_governor_check(int reported, int now, Component::ReportPolicy::Field const& f, uint8_t widen, TickType_t lastReport, TickType_t t)
+    {
+        if (reported == now)
+            return false;
+        const TickType_t elapsed = t - lastReport;
+        if (f.m_MinIntervalMs && (elapsed < pdMS_TO_TICKS(f.m_MinIntervalMs)))
+            return false;
+        const int deadband = int(f.m_Deadband) << widen;
+        if (std::abs(reported - now) > deadband)
+            return true;
+        return f.m_MaxIntervalS && (elapsed >= pdMS_TO_TICKS(uint32_t(f.m_MaxIntervalS) * 1000));
+    }
 
     Component::~Component()
     {
@@ -99,12 +195,11 @@ namespace ld2412
 
     void Component::presence_pir_pin_isr(void *param)
     {
-        static int g_last = -1;
         Component &c = *static_cast<Component*>(param);
         int l = gpio_get_level(gpio_num_t(c.m_PIRPresencePin));
-        if (l != g_last)
+        if (l != c.m_LastPIRLevel)
         {
-            g_last = l;
+            c.m_LastPIRLevel = l;
             QueueMsg msg{.m_Type=QueueMsg::Type::PIRPresenceIntr, .m_Dummy=bool(l)};
             xQueueSendFromISR(c.m_FastQueue, &msg, nullptr);
         }
@@ -135,8 +230,14 @@ namespace ld2412
                     {
                         FMT_PRINT("Factory resetting has failed: {}\n", te.error());
                     }
-                    else if (m_ConfigUpdateCallback)
-                        m_ConfigUpdateCallback();
+                    else
+                    {
+                        //thresholds are back to defaults, those become the new base once tracking runs
+                        m_NoiseFloor.m_HaveBase = false;
+                        m_NoiseTracker.Reset();
+                        if (m_ConfigUpdateCallback)
+                            m_ConfigUpdateCallback();
+                    }
                 }
                 break;
             case QueueMsg::Type::RunDynamicBackgroundAnalysis:
@@ -160,6 +261,8 @@ namespace ld2412
                         e.move = {.min=0xffff, .max=0, .last = 0};
                         e.still = {.min=0xffff, .max=0, .last = 0};
                     }
+                    if (m_MeasurementsUpdateCallback)
+                        m_MeasurementsUpdateCallback();
                 }
                 break;
             case QueueMsg::Type::SwitchBluetooth:
@@ -200,10 +303,13 @@ namespace ld2412
                         FMT_PRINT("Applying calibration...\n");
                         m_CalibrationStarted = false;
                         auto cfg = d.ChangeConfiguration();
+                        uint8_t calibratedMove[14], calibratedStill[14];
                         for(uint8_t g = 0; g < 14; ++g)
                         {
                             uint8_t still = uint8_t(m_MeasuredMinMax[g].still.max * 11 / 10);
                             uint8_t move = uint8_t(m_MeasuredMinMax[g].move.max * 13 / 10);
+                            calibratedMove[g] = move;
+                            calibratedStill[g] = still;
                             FMT_PRINT("Gate {}: prev=[still:{}; move:{}]; new=[still:{}; move:{}];"
                                     " measured move=[min:{}; max:{}]"
                                     " measured still=[min:{}; max:{}]"
@@ -223,8 +329,12 @@ namespace ld2412
                         {
                             FMT_PRINT("Applying calibration and setting mode has failed: {}\n", te.error());
                         }
-                        else if (m_ConfigUpdateCallback)
-                            m_ConfigUpdateCallback();
+                        else
+                        {
+                            SetNoiseFloorBase(calibratedMove, calibratedStill);
+                            if (m_ConfigUpdateCallback)
+                                m_ConfigUpdateCallback();
+                        }
                     }else
                     {
                         FMT_PRINT("Calibration was not running. Nothing to stop\n");
@@ -280,8 +390,14 @@ namespace ld2412
                     {
                         FMT_PRINT("Setting move sensitivity has failed: {}\n", te.error());
                     }
-                    else if (m_ConfigUpdateCallback)
-                        m_ConfigUpdateCallback();
+                    else
+                    {
+                        uint8_t still[14];
+                        for(uint8_t g = 0; g < 14; ++g) still[g] = d.GetStillThreshold(g);
+                        SetNoiseFloorBase(msg.m_Sensitivity, still);
+                        if (m_ConfigUpdateCallback)
+                            m_ConfigUpdateCallback();
+                    }
                 }
                 break;
             case QueueMsg::Type::SetStillSensitivity:
@@ -294,8 +410,14 @@ namespace ld2412
                     {
                         FMT_PRINT("Setting still sensitivity has failed: {}\n", te.error());
                     }
-                    else if (m_ConfigUpdateCallback)
-                        m_ConfigUpdateCallback();
+                    else
+                    {
+                        uint8_t move[14];
+                        for(uint8_t g = 0; g < 14; ++g) move[g] = d.GetMoveThreshold(g);
+                        SetNoiseFloorBase(move, msg.m_Sensitivity);
+                        if (m_ConfigUpdateCallback)
+                            m_ConfigUpdateCallback();
+                    }
                 }
                 break;
             case QueueMsg::Type::SetMinDistance:
@@ -324,6 +446,53 @@ namespace ld2412
                         m_ConfigUpdateCallback();
                 }
                 break;
+            case QueueMsg::Type::SetReportPolicy:
+                {
+                    memcpy(&m_ReportPolicy, msg.m_ReportPolicy, sizeof(m_ReportPolicy));
+                    FMT_PRINT("Report policy: distance=[db:{} min:{}ms max:{}s] energy=[db:{} min:{}ms max:{}s] adaptive:{}\n"
+                            , m_ReportPolicy.m_Distance.m_Deadband, m_ReportPolicy.m_Distance.m_MinIntervalMs, m_ReportPolicy.m_Distance.m_MaxIntervalS
+                            , m_ReportPolicy.m_Energy.m_Deadband, m_ReportPolicy.m_Energy.m_MinIntervalMs, m_ReportPolicy.m_Energy.m_MaxIntervalS
+                            , m_ReportPolicy.m_Adaptive
+                            );
+                }
+                break;
+            case QueueMsg::Type::SetZone:
+                {
+                    if (msg.m_SetZone.m_Index >= kMaxZones)
+                        break;
+                    auto const& z = msg.m_SetZone.m_Zone;
+                    FMT_PRINT("Zone {}: gates [{}..{}] move>{} still>{}\n", msg.m_SetZone.m_Index, z.m_FirstGate, z.m_LastGate, z.m_MoveThreshold, z.m_StillThreshold);
+                    m_Zones.m_Zones[msg.m_SetZone.m_Index] = z;
+                    const uint8_t prevOccupied = m_ZonesOccupied;
+                    RebuildZoneMasks();
+                    if (prevOccupied != m_ZonesOccupied)
+                    {
+                        QueueMsg zonesMsg{.m_Type = QueueMsg::Type::ZonesState, .m_ZonesOccupied = m_ZonesOccupied};
+                        xQueueSend(m_FastQueue, &zonesMsg, portMAX_DELAY);
+                    }
+                }
+                break;
+            case QueueMsg::Type::SetNoiseFloor:
+                {
+                    FMT_PRINT("Noise floor tracking: {}; max delta: {}\n", msg.m_NoiseFloor.m_Enabled, msg.m_NoiseFloor.m_MaxDelta);
+                    m_NoiseFloor.m_Enabled = msg.m_NoiseFloor.m_Enabled;
+                    m_NoiseFloor.m_MaxDelta = msg.m_NoiseFloor.m_MaxDelta;
+                    if (m_NoiseFloor.m_Enabled && !m_NoiseFloor.m_HaveBase)
+                    {
+                        //no explicit base yet: current thresholds are the base
+                        uint8_t move[14], still[14];
+                        for(uint8_t g = 0; g < 14; ++g)
+                        {
+                            move[g] = d.GetMoveThreshold(g);
+                            still[g] = d.GetStillThreshold(g);
+                        }
+                        SetNoiseFloorBase(move, still);
+                    }
+                    m_NoiseTracker.Reset();
+                    if (m_ConfigUpdateCallback)
+                        m_ConfigUpdateCallback();
+                }
+                break;
             default:
                 //don't care
                 //report
@@ -331,6 +500,132 @@ namespace ld2412
         }
     }
 
+    void Component::SetNoiseFloorBase(const uint8_t (&move)[14], const uint8_t (&still)[14])
+    {
+        memcpy(m_NoiseFloor.m_BaseMove, move, sizeof(move));
+        memcpy(m_NoiseFloor.m_BaseStill, still, sizeof(still));
+        m_NoiseFloor.m_HaveBase = true;
+        m_NoiseTracker.Reset();
+    }
+
+    //called by the manage task for every engineering frame, O(gates)
+    void Component::TrackNoiseFloor()
+    {
+        auto &nt = m_NoiseTracker;
+        const TickType_t t = xTaskGetTickCount();
+        //the sensor's own view is checked as well: confirmation from the zigbee side comes with a delay
+        const bool empty = m_ConfirmedEmpty.load(std::memory_order_relaxed) 
+                        && (m_Sensor.GetPresence().m_State == LD2412::TargetState::Clear);
+        if (!empty)
+        {
+            nt.m_Empty = false;
+            return;
+        }
+        if (!nt.m_Empty)
+        {
+            nt.m_Empty = true;
+            nt.m_EmptySince = t;
+            return;
+        }
+        if ((t - nt.m_EmptySince) < pdMS_TO_TICKS(NoiseFloorTracker::kSettleMs))
+            return;
+
+        for(uint8_t g = 0; g < 14; ++g)
+            nt.Update(g, GetMeasuredMoveEnergy(g), GetMeasuredStillEnergy(g));
+        if (nt.m_Frames < NoiseFloorTracker::kWarmupFrames)
+        {
+            ++nt.m_Frames;
+            return;
+        }
+        if ((t - nt.m_LastApply) < pdMS_TO_TICKS(NoiseFloorTracker::kApplyPeriodMs))
+            return;
+        nt.m_LastApply = t;
+
+        uint8_t move[14], still[14];
+        bool changed = false;
+        for(uint8_t g = 0; g < 14; ++g)
+        {
+            move[g] = NoiseFloorTracker::Nudge(GetMoveThreshold(g), nt.m_Move[g].Target(), m_NoiseFloor.m_BaseMove[g], m_NoiseFloor.m_MaxDelta);
+            still[g] = NoiseFloorTracker::Nudge(GetStillThreshold(g), nt.m_Still[g].Target(), m_NoiseFloor.m_BaseStill[g], m_NoiseFloor.m_MaxDelta);
+            changed = changed || (move[g] != GetMoveThreshold(g)) || (still[g] != GetStillThreshold(g));
+        }
+        if (!changed)
+            return;
+
+        auto cfg = m_Sensor.ChangeConfiguration();
+        for(uint8_t g = 0; g < 14; ++g)
+        {
+            if (move[g] != GetMoveThreshold(g))
+            {
+                FMT_PRINT("Noise floor: gate {} move threshold {}->{} (floor {})\n", g, GetMoveThreshold(g), move[g], nt.m_Move[g].m_Mean >> NoiseFloorTracker::kFrac);
+                cfg.SetMoveThreshold(g, move[g]);
+            }
+            if (still[g] != GetStillThreshold(g))
+            {
+                FMT_PRINT("Noise floor: gate {} still threshold {}->{} (floor {})\n", g, GetStillThreshold(g), still[g], nt.m_Still[g].m_Mean >> NoiseFloorTracker::kFrac);
+                cfg.SetStillThreshold(g, still[g]);
+            }
+        }
+        if (auto te = cfg.EndChange(); !te)
+        {
+            FMT_PRINT("Applying noise floor thresholds has failed: {}\n", te.error());
+        }
+        else if (m_ConfigUpdateCallback)
+            m_ConfigUpdateCallback();
+    }
+
+    void Component::RebuildZoneMasks()
+    {
+        m_ZonesEnabled = 0;
+        for(auto &m : m_GateZones) m = 0;
+        for(uint8_t z = 0; z < kMaxZones; ++z)
+        {
+            auto const& zone = m_Zones.m_Zones[z];
+            if (!zone.Enabled())
+                continue;
+            m_ZonesEnabled |= 1 << z;
+            for(uint8_t g = zone.m_FirstGate; (g <= zone.m_LastGate) && (g < 14); ++g)
+                m_GateZones[g] |= 1 << z;
+        }
+        m_ZonesOccupied &= m_ZonesEnabled;
+    }
+
+    //one pass over the gates, a gate is only checked against the zones covering it and not hit yet
+    uint8_t Component::EvaluateZones()
+    {
+        uint8_t hit = 0;
+        for(uint8_t g = 0; g < 14; ++g)
+        {
+            uint8_t zones = m_GateZones[g] & ~hit;
+            if (!zones)
+                continue;
+            const uint8_t move = GetMeasuredMoveEnergy(g);
+            const uint8_t still = GetMeasuredStillEnergy(g);
+            for(; zones; zones &= zones - 1)
+            {
+                const uint8_t z = __builtin_ctz(zones);
+                auto const& zone = m_Zones.m_Zones[z];
+                if ((zone.m_MoveThreshold && (move > zone.m_MoveThreshold)) || (zone.m_StillThreshold && (still > zone.m_StillThreshold)))
+                    hit |= 1 << z;
+            }
+        }
+
+        const TickType_t t = xTaskGetTickCount();
+        uint8_t occupied = 0;
+        for(uint8_t z = 0; z < kMaxZones; ++z)
+        {
+            const uint8_t bit = 1 << z;
+            if (hit & bit)
+            {
+                m_ZoneLastHit[z] = t;
+                occupied |= bit;
+            }
+            else if ((m_ZonesOccupied & bit) && ((t - m_ZoneLastHit[z]) < pdMS_TO_TICKS(kZoneHoldMs)))
+                occupied |= bit;
+        }
+        return occupied;
+    }
+
     void Component::fast_loop(Component *pC)
     {
         Component &c = *pC;
@@ -405,10 +700,10 @@ namespace ld2412
                             c.m_MovementCallback(lastCompositePresence, lastPresenceData, exState);
                     }
                     break;
-                    case QueueMsg::Type::GatesEnergyState:
+                    case QueueMsg::Type::ZonesState:
                     {
-                        if (c.m_MeasurementsUpdateCallback)
-                            c.m_MeasurementsUpdateCallback();
+                        if (c.m_ZonesCallback)
+                            c.m_ZonesCallback(msg.m_ZonesOccupied);
                     }
                     break;
                     case QueueMsg::Type::Presence: 
@@ -433,6 +728,7 @@ namespace ld2412
                             lastPresenceData.m_MoveDistance = msg.m_Presence.m_DistanceMove;
                             lastPresenceData.m_StillEnergy = msg.m_Presence.m_EnergyStill;
                             lastPresenceData.m_MoveEnergy = msg.m_Presence.m_EnergyMove;
+                            lastPresenceData.m_ApproachSpeed = msg.m_Presence.m_ApproachSpeed;
                             lastCompositePresence = lastPresence || lastPIRPresence;
                             lastPresenceData.mmPresence = lastPresence;
 
@@ -454,8 +750,14 @@ namespace ld2412
         Component &c = *pC;
         bool initial = true;
         LD2412::PresenceResult lastPresence;
+        //last report ticks: still distance, move distance, still energy, move energy
+        TickType_t lastReport[4] = {0, 0, 0, 0};
+        bool lastApproaching = false;
         auto &d = c.m_Sensor;
         QueueMsg msg;
+        //initial config publication, from this task as all the others
+        if (c.m_ConfigUpdateCallback)
+            c.m_ConfigUpdateCallback();
         if ((c.m_PresencePin != -1) && (d.GetSystemMode() == LD2412::SystemMode::Simple))
         {
             //need to read initial state
@@ -505,16 +807,30 @@ namespace ld2412
                             move.last = e;
                             changed = true;
                         }
-                        if (e > move.max) move.max = e;
-                        if (e < move.min) move.min = e;
+                        if (e > move.max) { move.max = e; changed = true; }
+                        if (e < move.min) { move.min = e; changed = true; }
                         e = c.GetMeasuredStillEnergy(g);
                         if (still.last != e)
                         {
                             still.last = e;
                             changed = true;
                         }
-                        if (e > still.max) still.max = e;
-                        if (e < still.min) still.min = e;
+                        if (e > still.max) { still.max = e; changed = true; }
+                        if (e < still.min) { still.min = e; changed = true; }
+                    }
+
+                    if (te && c.m_NoiseFloor.m_Enabled && c.m_NoiseFloor.m_HaveBase && !c.m_CalibrationStarted)
+                        c.TrackNoiseFloor();
+
+                    if (te && c.m_ZonesEnabled)
+                    {
+                        if (auto zones = c.EvaluateZones(); zones != c.m_ZonesOccupied)
+                        {
+                            c.m_ZonesOccupied = zones;
+                            msg.m_Type = QueueMsg::Type::ZonesState;
+                            msg.m_ZonesOccupied = zones;
+                            xQueueSend(c.m_FastQueue, &msg, portMAX_DELAY);
+                        }
                     }
 
                     if (c.m_MeasuredLight != d.GetMeasuredLight())
@@ -523,15 +839,43 @@ namespace ld2412
                         changed = true;
                     }
 
-                    if (changed)
-                    {
-                        msg.m_Type = QueueMsg::Type::GatesEnergyState;
-                        xQueueSend(c.m_FastQueue, &msg, portMAX_DELAY);
-                    }
+                    //from this task: the measurements are written here
+                    if (changed && c.m_MeasurementsUpdateCallback)
+                        c.m_MeasurementsUpdateCallback();
+                }
+                else if (c.m_ZonesOccupied)
+                {
+                    //no engineering data in simple mode: zones can't be evaluated
+                    c.m_ZonesOccupied = 0;
+                    msg.m_Type = QueueMsg::Type::ZonesState;
+                    msg.m_ZonesOccupied = 0;
+                    xQueueSend(c.m_FastQueue, &msg, portMAX_DELAY);
                 }
 
                 auto p = d.GetPresence();
+                if (te)
+                {
+                    //smooth the distances, raw ones jitter by several gates
+                    const TickType_t trackTick = xTaskGetTickCount();
+                    if (p.m_State & LD2412::TargetState::Move)
+                    {
+                        c.m_MoveTracker.Update(p.m_MoveDistance, trackTick);
+                        p.m_MoveDistance = c.m_MoveTracker.GetDistance();
+                    }else
+                        c.m_MoveTracker.Reset();
+
+                    if (p.m_State & LD2412::TargetState::Still)
+                    {
+                        c.m_StillTracker.Update(p.m_StillDistance, trackTick);
+                        p.m_StillDistance = c.m_StillTracker.GetDistance();
+                    }else
+                        c.m_StillTracker.Reset();
+                }
+                const int16_t approachSpeed = c.m_MoveTracker.m_Valid ? c.m_MoveTracker.GetApproachSpeed() : 0;
+                const bool approaching = approachSpeed >= kApproachMinSpeed;
                 msg.m_Type = QueueMsg::Type::Presence;
+                msg.m_Presence.m_ApproachSpeed = approachSpeed;
+                msg.m_Presence.m_ChangeApproaching = false;
                 msg.m_Presence.m_DistanceStill = p.m_StillDistance;
                 msg.m_Presence.m_DistanceMove = p.m_MoveDistance;
                 msg.m_Presence.m_EnergyMove = p.m_MoveEnergy;
@@ -556,6 +900,7 @@ namespace ld2412
                     msg.m_Presence.m_ChangeDistanceMove = true;
                     msg.m_Presence.m_ChangeEnergyMove = true;
                     msg.m_Presence.m_ChangeEnergyStill = true;
+                    lastApproaching = approaching;
                     initial = false;
                 }else
                 {
@@ -563,17 +908,31 @@ namespace ld2412
                     msg.m_Presence.m_ChangePresenceMove = (lastPresence.m_State & LD2412::TargetState::Move) != (p.m_State & LD2412::TargetState::Move);
                     lastPresence.m_State = p.m_State;
 
-                    msg.m_Presence.m_ChangeDistanceStill = std::abs((int)lastPresence.m_StillDistance - (int)p.m_StillDistance) > kDistanceReportChangeThreshold;
-                    if (msg.m_Presence.m_ChangeDistanceStill) lastPresence.m_StillDistance = p.m_StillDistance;
+                    //report governor: deadbands get wider while the fast queue is backlogged
+                    auto const& policy = c.m_ReportPolicy;
+                    uint8_t widen = 0;
+                    if (policy.m_Adaptive)
+                    {
+                        auto backlog = uxQueueMessagesWaiting(c.m_FastQueue);
+                        widen = backlog >= 64 ? 3 : backlog >= 16 ? 2 : backlog >= 4 ? 1 : 0;
+                    }
+                    const TickType_t t = xTaskGetTickCount();
+
+                    msg.m_Presence.m_ChangeDistanceStill = report_governor_check(lastPresence.m_StillDistance, p.m_StillDistance, policy.m_Distance, widen, lastReport[0], t);
+                    if (msg.m_Presence.m_ChangeDistanceStill) { lastPresence.m_StillDistance = p.m_StillDistance; lastReport[0] = t; }
 
-                    msg.m_Presence.m_ChangeDistanceMove = std::abs((int)lastPresence.m_MoveDistance - (int)p.m_MoveDistance) > kDistanceReportChangeThreshold;
-                    if (msg.m_Presence.m_ChangeDistanceMove) lastPresence.m_MoveDistance = p.m_MoveDistance;
+                    msg.m_Presence.m_ChangeDistanceMove = report_governor_check(lastPresence.m_MoveDistance, p.m_MoveDistance, policy.m_Distance, widen, lastReport[1], t);
+                    if (msg.m_Presence.m_ChangeDistanceMove) { lastPresence.m_MoveDistance = p.m_MoveDistance; lastReport[1] = t; }
 
-                    msg.m_Presence.m_ChangeEnergyMove = std::abs((int)lastPresence.m_MoveEnergy - (int)p.m_MoveEnergy) > kEnergyReportChangeThreshold;
-                    if (msg.m_Presence.m_ChangeEnergyMove) lastPresence.m_MoveEnergy = p.m_MoveEnergy;
+                    msg.m_Presence.m_ChangeEnergyStill = report_governor_check(lastPresence.m_StillEnergy, p.m_StillEnergy, policy.m_Energy, widen, lastReport[2], t);
+                    if (msg.m_Presence.m_ChangeEnergyStill) { lastPresence.m_StillEnergy = p.m_StillEnergy; lastReport[2] = t; }
 
-                    msg.m_Presence.m_ChangeEnergyStill = std::abs((int)lastPresence.m_StillEnergy - (int)p.m_StillEnergy) > kEnergyReportChangeThreshold;
-                    if (msg.m_Presence.m_ChangeEnergyStill) lastPresence.m_StillEnergy = p.m_StillEnergy;
+                    msg.m_Presence.m_ChangeEnergyMove = report_governor_check(lastPresence.m_MoveEnergy, p.m_MoveEnergy, policy.m_Energy, widen, lastReport[3], t);
+                    if (msg.m_Presence.m_ChangeEnergyMove) { lastPresence.m_MoveEnergy = p.m_MoveEnergy; lastReport[3] = t; }
+
+                    //approach start/end is not governed
+                    msg.m_Presence.m_ChangeApproaching = approaching != lastApproaching;
+                    lastApproaching = approaching;
                 }
 
 
@@ -583,7 +942,8 @@ namespace ld2412
                     | msg.m_Presence.m_ChangeEnergyStill 
                     | msg.m_Presence.m_ChangeEnergyMove
                     | msg.m_Presence.m_ChangeDistanceStill 
-                    | msg.m_Presence.m_ChangeDistanceMove;
+                    | msg.m_Presence.m_ChangeDistanceMove
+                    | msg.m_Presence.m_ChangeApproaching;
                 
                 if (anythingChanged)
                     xQueueSend(c.m_FastQueue, &msg, portMAX_DELAY);
@@ -674,6 +1034,25 @@ namespace ld2412
         xQueueSend(m_ManagingQueue, &msg, portMAX_DELAY);
     }
 
+    void Component::ChangeReportPolicy(ReportPolicy const& p)
+    {
+        QueueMsg msg{.m_Type = QueueMsg::Type::SetReportPolicy, .m_Dummy = 0};
+        memcpy(msg.m_ReportPolicy, &p, sizeof(msg.m_ReportPolicy));
+        xQueueSend(m_ManagingQueue, &msg, portMAX_DELAY);
+    }
+
+    void Component::ChangeNoiseFloorTracking(bool enabled, uint8_t maxDelta)
+    {
+        QueueMsg msg{.m_Type = QueueMsg::Type::SetNoiseFloor, .m_NoiseFloor = {.m_Enabled = enabled, .m_MaxDelta = maxDelta}};
+        xQueueSend(m_ManagingQueue, &msg, portMAX_DELAY);
+    }
+
+    void Component::ChangeZone(uint8_t idx, Zone const& z)
+    {
+        QueueMsg msg{.m_Type = QueueMsg::Type::SetZone, .m_SetZone = {.m_Index = idx, .m_Zone = z}};
+        xQueueSend(m_ManagingQueue, &msg, portMAX_DELAY);
+    }
+
     void Component::ChangeMinDistance(uint16_t d)
     {
         QueueMsg msg{.m_Type = QueueMsg::Type::SetMinDistance, .m_Distance = d};
@@ -772,6 +1151,7 @@ namespace ld2412
                 });
             }
 
+            m_Sensor.SetPort(args.port);
             auto e = m_Sensor.Init(args.txPin, args.rxPin);
             if (!!e)
                 e = m_Sensor.ReloadConfig();
@@ -785,6 +1165,10 @@ namespace ld2412
 
         m_PresencePin = args.presencePin;
         m_PIRPresencePin = args.presencePIRPin;
+        m_ReportPolicy = args.reportPolicy;
+        m_NoiseFloor = args.noiseFloor;
+        m_Zones = args.zones;
+        RebuildZoneMasks();
 
         {
             printf("Config\n");
@@ -834,8 +1218,6 @@ namespace ld2412
         m_Setup = true;
         FMT_PRINT("ld2412 component: setup done\n");
         fflush(stdout);
-        if (m_ConfigUpdateCallback)
-            m_ConfigUpdateCallback();
 
         {
             //initial read of the presence pins
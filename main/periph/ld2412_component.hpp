@@ -14,6 +14,7 @@ namespace ld2412
     {
         static constexpr const uint16_t kDistanceReportChangeThreshold = 10;//10cm
         static constexpr const uint16_t kEnergyReportChangeThreshold = 10;//10
+        static constexpr const uint16_t kDefaultMinReportIntervalMs = 250;
         struct QueueMsg;
     public:
         enum class ExtendedState: uint8_t
@@ -22,10 +23,37 @@ namespace ld2412
             RunningDynamicBackgroundAnalysis,
             RunningCalibration
         };
+        static constexpr const int16_t kApproachMinSpeed = 30;//cm/s
+
         struct PresenceResult: LD2412::PresenceResult
         {
             bool pirPresence = false;
             bool mmPresence = false;
+            int16_t m_ApproachSpeed = 0;//cm/s of the moving target, positive - towards the sensor
+
+            bool ApproachingWithin(uint16_t cm) const 
+            { 
+                return (m_State & LD2412::TargetState::Move) && (m_ApproachSpeed >= kApproachMinSpeed) && (m_MoveDistance <= cm); 
+            }
+        };
+
+        //Fixed point alpha-beta (steady state Kalman) filter of a target distance
+        struct DistanceTracker
+        {
+            static constexpr int32_t kFrac = 8;//Q8
+            static constexpr int32_t kAlpha = 96;//0.375 in Q8
+            static constexpr int32_t kBeta = 20;//~0.08 in Q8
+            static constexpr uint32_t kMaxGapMs = 1000;//restart tracking after a gap
+
+            int32_t m_Pos = 0;//cm, Q8
+            int32_t m_Vel = 0;//cm/s, Q8
+            TickType_t m_LastTick = 0;
+            bool m_Valid = false;
+
+            void Reset() { m_Valid = false; m_Vel = 0; }
+            void Update(uint16_t measured, TickType_t t);
+            uint16_t GetDistance() const { return uint16_t((m_Pos + (1 << (kFrac - 1))) >> kFrac); }
+            int16_t GetApproachSpeed() const { return int16_t(-m_Vel / (1 << kFrac)); }
         };
         using MovementCallback = GenericCallback<void(bool detected, PresenceResult const& p, ExtendedState exState)>;
         using ConfigUpdateCallback = GenericCallback<void()>;
@@ -42,6 +70,84 @@ namespace ld2412
             EnergyMinMax still;
         };
 
+        //Decides when distance/energy changes are worth a presence update.
+        //Presence state changes are always reported immediately.
+        struct ReportPolicy
+        {
+            struct Field
+            {
+                uint16_t m_Deadband;      //report only if changed by more than this
+                uint16_t m_MinIntervalMs; //no more often than this; 0 - no limit
+                uint16_t m_MaxIntervalS;  //report a pending change within deadband after this; 0 - never
+            };
+            Field m_Distance{kDistanceReportChangeThreshold, kDefaultMinReportIntervalMs, 0};
+            Field m_Energy{kEnergyReportChangeThreshold, kDefaultMinReportIntervalMs, 0};
+            bool m_Adaptive = true;//widen deadbands while the fast queue is backlogged
+        };
+
+        //Background noise floor tracking. While the room is confirmed empty the
+        //energy of every gate is followed and the thresholds are slowly nudged
+        //towards 'floor + margin', never further than m_MaxDelta from the base
+        //thresholds (the ones set explicitly or by calibration).
+        struct NoiseFloorConfig
+        {
+            bool m_Enabled = false;
+            uint8_t m_MaxDelta = 10;
+            bool m_HaveBase = false;
+            uint8_t m_BaseMove[14]{};
+            uint8_t m_BaseStill[14]{};
+        };
+
+        //Fixed point EWMA of the energy level and of its absolute deviation, per gate
+        struct NoiseFloorTracker
+        {
+            static constexpr int32_t kFrac = 8;//Q8
+            static constexpr int32_t kShift = 5;//alpha = 1/32
+            static constexpr int32_t kDevFactor = 3;
+            static constexpr uint8_t kMargin = 2;
+            static constexpr uint16_t kWarmupFrames = 64;
+            static constexpr uint32_t kSettleMs = 30 * 1000;//must be empty for that long before sampling
+            static constexpr uint32_t kApplyPeriodMs = 5 * 60 * 1000;//at most one step per gate that often
+
+            struct Stat
+            {
+                uint16_t m_Mean = 0;//Q8
+                uint16_t m_Dev = 0;//Q8
+
+                void Update(uint8_t e, bool first);
+                uint8_t Target() const;
+            };
+            Stat m_Move[14];
+            Stat m_Still[14];
+            uint16_t m_Frames = 0;
+            TickType_t m_LastApply = 0;
+            TickType_t m_EmptySince = 0;
+            bool m_Empty = false;
+
+            void Reset() { m_Frames = 0; m_Empty = false; }
+            void Update(uint8_t gate, uint8_t move, uint8_t still);
+            static uint8_t Nudge(uint8_t current, uint8_t target, uint8_t base, uint8_t maxDelta);
+        };
+
+        //Gate range with its own energy thresholds, evaluated on engineering frames.
+        //A threshold of 0 means the energy type is not used, both 0 - zone disabled.
+        static constexpr uint8_t kMaxZones = 4;
+        static constexpr uint32_t kZoneHoldMs = 2000;//zone stays occupied that long after the last hit
+        struct Zone
+        {
+            uint8_t m_FirstGate;
+            uint8_t m_LastGate;
+            uint8_t m_MoveThreshold;
+            uint8_t m_StillThreshold;
+
+            bool Enabled() const { return m_MoveThreshold || m_StillThreshold; }
+        };
+        struct ZonesConfig
+        {
+            Zone m_Zones[kMaxZones]{};
+        };
+        using ZonesCallback = GenericCallback<void(uint8_t occupiedMask)>;
+
         ~Component();
 
         struct setup_args_t{
@@ -51,6 +157,9 @@ namespace ld2412
             int presencePin = -1;
             int presencePIRPin = -1;
             LD2412::SystemMode mode = LD2412::SystemMode::Simple;
+            ReportPolicy reportPolicy{};
+            NoiseFloorConfig noiseFloor{};
+            ZonesConfig zones{};
         };
 
         bool Setup(setup_args_t const& args);
@@ -62,6 +171,11 @@ namespace ld2412
         void ChangeMaxDistance(uint16_t d);
         void ChangeMoveSensitivity(const uint8_t (&sensitivity)[14]);
         void ChangeStillSensitivity(const uint8_t (&sensitivity)[14]);
+        void ChangeReportPolicy(ReportPolicy const& p);
+        void ChangeNoiseFloorTracking(bool enabled, uint8_t maxDelta);
+        void ChangeZone(uint8_t idx, Zone const& z);
+        //set by the presence logic: no presence from any source and all timeouts elapsed
+        void SetConfirmedEmpty(bool empty) { m_ConfirmedEmpty.store(empty, std::memory_order_relaxed); }
 
         void StartCalibration();
         void StopCalibration();
@@ -91,14 +205,22 @@ namespace ld2412
         auto GetMeasuredLight() const { return m_MeasuredLight; }
 
         uint16_t GetTimeout() const;
+        //config, measurements and the noise floor config: manage task only (e.g. from the update callbacks)
+        const auto& GetNoiseFloorConfig() const { return m_NoiseFloor; }
                                                          //
         void SetCallbackOnMovement(MovementCallback cb) { m_MovementCallback = std::move(cb); }
+        //the config and measurements callbacks are called by the manage task
         void SetCallbackOnConfigUpdate(ConfigUpdateCallback cb) { m_ConfigUpdateCallback = std::move(cb); }
         void SetCallbackOnMeasurementsUpdate(MeasurementsUpdateCallback cb) { m_MeasurementsUpdateCallback = std::move(cb); }
+        void SetCallbackOnZones(ZonesCallback cb) { m_ZonesCallback = std::move(cb); }
 
     private:
         void ConfigurePresenceIsr();
         void HandleMessage(QueueMsg &msg);
+        void SetNoiseFloorBase(const uint8_t (&move)[14], const uint8_t (&still)[14]);
+        void TrackNoiseFloor();
+        void RebuildZoneMasks();
+        uint8_t EvaluateZones();
 
         static void presence_pin_isr(void *param);
         static void presence_pir_pin_isr(void *param);
@@ -109,10 +231,12 @@ namespace ld2412
         LD2412 m_Sensor;
         int m_PresencePin = -1;
         int m_PIRPresencePin = -1;
+        int m_LastPIRLevel = -1;//accessed only by the PIR isr
 
         MovementCallback m_MovementCallback;
         ConfigUpdateCallback m_ConfigUpdateCallback;
         MeasurementsUpdateCallback m_MeasurementsUpdateCallback;
+        ZonesCallback m_ZonesCallback;
 
         QueueHandle_t m_FastQueue = 0;
         std::atomic<QueueHandle_t> m_ManagingQueue{0};
@@ -123,6 +247,20 @@ namespace ld2412
         EnergyReading m_MeasuredMinMax[14];
         uint8_t m_MeasuredLight = 0;
 
+        ReportPolicy m_ReportPolicy;//owned by the manage task
+        DistanceTracker m_MoveTracker;//owned by the manage task
+        DistanceTracker m_StillTracker;//owned by the manage task
+        NoiseFloorConfig m_NoiseFloor;//owned by the manage task
+        NoiseFloorTracker m_NoiseTracker;//owned by the manage task
+        std::atomic<bool> m_ConfirmedEmpty{false};
+
+        //zones, owned by the manage task
+        ZonesConfig m_Zones;
+        uint8_t m_GateZones[14] = {};//per gate: bitmask of the zones covering it
+        uint8_t m_ZonesEnabled = 0;
+        uint8_t m_ZonesOccupied = 0;
+        TickType_t m_ZoneLastHit[kMaxZones] = {};
+
         bool m_CalibrationStarted = false;
         bool m_DynamicBackgroundAnalysis = false;
         LD2412::SystemMode m_ModeBeforeCalibration;
@@ -135,9 +273,10 @@ struct tools::formatter_t<ld2412::Component::PresenceResult>
     template<FormatDestination Dest>
     static std::expected<size_t, FormatError> format_to(Dest &&dst, std::string_view const& fmtStr, ld2412::Component::PresenceResult const& p)
     {
-        return tools::format_to(std::forward<Dest>(dst), "{}; PIR={}"
+        return tools::format_to(std::forward<Dest>(dst), "{}; PIR={}; Approach={}cm/s"
                 , (LD2412::PresenceResult const&)p
                 , p.pirPresence
+                , p.m_ApproachSpeed
             );
     }
 };
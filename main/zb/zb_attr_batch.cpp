@@ -0,0 +1,160 @@
+#include "zb_attr_batch.hpp"
+#include "esp_zigbee_core.h"
+#include "zcl/esp_zigbee_zcl_common.h"
+
+namespace zb
+{
+    AttrBatch::Entry AttrBatch::g_Entries[kMaxEntries];
+
+    namespace
+    {
+        //ZCL header of a Report Attributes command:
+        //general command, server to client, default response disabled
+        constexpr uint8_t kReportFrameControl = 0x18;
+        constexpr uint8_t kReportAttributesCmd = 0x0a;
+
+        //the stack attribute, if it's reported to someone. Otherwise the batch
+        //keeps away from it and the usual Set path takes care
+        esp_zb_zcl_attr_t* reported_attr(BatchReportDesc const& d)
+        {
+            esp_zb_zcl_attr_location_info_t loc{};
+            loc.endpoint_id = d.m_Ep;
+            loc.cluster_id = d.m_Cluster;
+            loc.cluster_role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE;
+            loc.manuf_code = ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC;
+            loc.attr_id = d.m_AttrId;
+            auto *pInfo = esp_zb_zcl_find_reporting_info(loc);
+            if (!pInfo || pInfo->u.send_info.max_interval == 0xffff)//0xffff - reporting disabled
+                return nullptr;
+            return esp_zb_zcl_get_attribute(d.m_Ep, d.m_Cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, d.m_AttrId);
+        }
+    }
+
+    bool AttrBatch::Add(Shadow *pShadow, apply_t a, const BatchReportDesc *pReport, const void *pVal, size_t sz, const char *pWhat)
+    {
+        Entry *pE = nullptr;
+        for(uint8_t i = 0; i < g_Count && !pE; ++i)
+        {
+            if (g_Entries[i].m_pShadow == pShadow)
+                pE = &g_Entries[i];
+        }
+
+        if (!pE)
+        {
+            if (g_Count == kMaxEntries)
+                return false;//full: caller sets it right away
+            pE = &g_Entries[g_Count++];
+            pE->m_pShadow = pShadow;
+            pE->m_Apply = a;
+            pE->m_pReport = pReport;
+        }
+        pE->m_pWhat = pWhat;
+        pE->m_Size = sz;
+        std::memcpy(pE->m_Value, pVal, sz);
+        return true;
+    }
+
+    void AttrBatch::Flush()
+    {
+        //only the entries that differ from their shadows reach the stack
+        static_assert(kMaxEntries <= 32, "dirty mask is 32 bit");
+        const uint8_t n = g_Count;
+        g_Count = 0;
+        uint32_t dirty = 0;
+        for(uint8_t i = 0; i < n; ++i)
+        {
+            auto const& e = g_Entries[i];
+            if (!e.m_pShadow->Same(e.m_Value, e.m_Size))
+                dirty |= 1u << i;
+        }
+
+        //the reported ones go out a cluster at a time, one frame each
+        uint32_t reported = 0;
+        for(uint8_t i = 0; i < n; ++i)
+        {
+            if ((dirty & (1u << i)) && g_Entries[i].m_pReport)
+                reported |= 1u << i;
+        }
+        while(reported)
+        {
+            const uint8_t first = __builtin_ctz(reported);
+            BatchReportDesc const& d = *g_Entries[first].m_pReport;
+            uint32_t cluster = 0;
+            for(uint32_t m = reported; m; m &= m - 1)
+            {
+                const uint8_t i = __builtin_ctz(m);
+                auto const& o = *g_Entries[i].m_pReport;
+                if (o.m_Ep == d.m_Ep && o.m_Cluster == d.m_Cluster)
+                    cluster |= 1u << i;
+            }
+            reported &= ~cluster;
+            dirty &= ~SendReport(cluster, first);
+        }
+
+        //the rest is applied in the order of the first update
+        for(uint8_t i = 0; dirty; ++i, dirty >>= 1)
+        {
+            if (dirty & 1)
+                g_Entries[i].m_Apply(g_Entries[i].m_Value, g_Entries[i].m_pWhat);
+        }
+    }
+
+    uint32_t AttrBatch::SendReport(uint32_t candidates, uint8_t first)
+    {
+        BatchReportDesc const& d = *g_Entries[first].m_pReport;
+        uint8_t frame[3 + kMaxReportPayload] = {kReportFrameControl, g_ReportSeq, kReportAttributesCmd};
+        size_t sz = 3;
+        uint32_t sent = 0;
+        esp_zb_zcl_attr_t *attrs[kMaxEntries];
+        uint8_t records = 0;
+        for(uint32_t m = candidates; m; m &= m - 1)
+        {
+            const uint8_t i = __builtin_ctz(m);
+            auto const& e = g_Entries[i];
+            auto *pAttr = reported_attr(*e.m_pReport);
+            if (!pAttr || (sz + 3 + e.m_Size) > sizeof(frame))
+                continue;//the stack reports it
+            frame[sz++] = e.m_pReport->m_AttrId & 0xff;
+            frame[sz++] = e.m_pReport->m_AttrId >> 8;
+            frame[sz++] = pAttr->type;
+            std::memcpy(frame + sz, e.m_Value, e.m_Size);//little endian, as ZCL wants it
+            sz += e.m_Size;
+            attrs[i] = pAttr;
+            sent |= 1u << i;
+            ++records;
+        }
+        if (!sent)
+            return 0;
+
+        //to the bound destinations of the cluster, same as the reports of the stack
+        esp_zb_apsde_data_req_t req{};
+        req.dst_addr_mode = ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT;
+        req.profile_id = ESP_ZB_AF_HA_PROFILE_ID;
+        req.cluster_id = d.m_Cluster;
+        req.src_endpoint = d.m_Ep;
+        req.asdu_length = sz;
+        req.asdu = frame;
+        req.tx_options = ESP_ZB_APSDE_TX_OPT_ACK_TX;
+        req.radius = 0;
+        if (esp_err_t e = esp_zb_aps_data_request(&req); e != ESP_OK)
+        {
+            FMT_PRINT("Batched report of cluster {:x} failed to send: {:x}; the stack reports them\n", d.m_Cluster, e);
+            return 0;
+        }
+        ++g_ReportSeq;
+
+        //the values are stored behind the back of the reporting engine: it
+        //would report each one on its own otherwise
+        for(uint32_t m = sent; m; m &= m - 1)
+        {
+            const uint8_t i = __builtin_ctz(m);
+            auto &e = g_Entries[i];
+            std::memcpy(attrs[i]->data_p, e.m_Value, e.m_Size);
+            e.m_pShadow->Store(e.m_Value, e.m_Size);
+        }
+        g_ReportStats.m_Frames++;
+        g_ReportStats.m_Records += records;
+        FMT_PRINT("Batched report: {} records of cluster {:x} in one frame ({} records in {} frames so far)\n", records, d.m_Cluster, g_ReportStats.m_Records, g_ReportStats.m_Frames);
+        return sent;
+    }
+}
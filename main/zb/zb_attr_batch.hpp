@@ -0,0 +1,147 @@
+#ifndef ZB_ATTR_BATCH_HPP_
+#define ZB_ATTR_BATCH_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "zbh_helpers.hpp"
+
+namespace zb
+{
+    struct BatchReportDesc
+    {
+        uint8_t m_Ep;
+        uint16_t m_Cluster;
+        uint16_t m_AttrId;
+    };
+    //specialized (see BATCH_REPORTED) for the attributes reported by AttrBatch itself
+    template<class Attr>
+    struct BatchReported
+    {
+        static constexpr bool kEnabled = false;
+    };
+#define BATCH_REPORTED(attr_t, ep, cluster, id) \
+    template<> struct BatchReported<attr_t> \
+    { \
+        static constexpr bool kEnabled = true; \
+        static constexpr BatchReportDesc kDesc{ep, cluster, id}; \
+    }
+
+    /**********************************************************************/
+    /* Attribute update batch                                             */
+    /**********************************************************************/
+    //Collects the attribute updates of one logical change (a presence change,
+    //a config update...) and applies them back to back when the outermost
+    //scope ends. Repeated updates of the same attribute within a scope are
+    //coalesced: only the last value is set.
+    //Attributes marked with BatchReported (discrete state attributes that change
+    //together) are not left to the reporting engine of the stack, which sends a
+    //Report Attributes command per attribute. All the dirty ones of a cluster
+    //go out in a single Report Attributes command to the bound destinations
+    //(the ones the stack reports to) and their values are stored without
+    //triggering the stack reports. Only attributes with reporting configured
+    //and enabled are reported this way, the rest take the usual path.
+    //Every attribute set through here has a shadow of its last set value.
+    //Setting the value it already holds is a no-op: no esp_zb_zcl_set_attribute_val,
+    //no reporting. Any write coming from the network invalidates all shadows.
+    //Zigbee task (or APILock) only. Scopes nest, only the outermost one applies.
+    class AttrBatch
+    {
+    public:
+        static constexpr size_t kMaxEntries = 16;
+        static constexpr size_t kMaxValueSize = 20;
+        //ZCL payload of a batched report, well within a single unfragmented frame
+        static constexpr size_t kMaxReportPayload = 48;
+
+        struct ReportStats
+        {
+            uint32_t m_Frames;//Report Attributes commands sent by the batch
+            uint32_t m_Records;//attribute records in them
+        };
+
+        AttrBatch() { ++g_Depth; }
+        ~AttrBatch() { if (!--g_Depth) Flush(); }
+        AttrBatch(AttrBatch const&) = delete;
+        AttrBatch& operator=(AttrBatch const&) = delete;
+
+        //outside of any scope the attribute is set right away
+        template<class Attr, class V>
+        static void Set(Attr const& attr, V const& v, const char *pWhat)
+        {
+            static_assert(sizeof(V) <= kMaxValueSize, "value too big to be batched");
+            static_assert(std::is_trivially_copyable_v<V>);
+            auto &shadow = g_Shadow<Attr>;
+            const BatchReportDesc *pReport = nullptr;
+            if constexpr (BatchReported<Attr>::kEnabled)
+                pReport = &BatchReported<Attr>::kDesc;
+            if (g_Depth && Add(&shadow, &apply<Attr, V>, pReport, &v, sizeof(V), pWhat))
+                return;
+            if (!shadow.Same(&v, sizeof(V)))
+                apply<Attr, V>(&v, pWhat);
+        }
+
+        static bool Active() { return g_Depth != 0; }
+        //the stack changed attribute values on its own (network write, command)
+        static void InvalidateShadows() { ++g_Epoch; }
+        static ReportStats const& GetReportStats() { return g_ReportStats; }
+    private:
+        using apply_t = void(*)(const void *pVal, const char *pWhat);
+        struct Shadow
+        {
+            alignas(4) uint8_t m_Value[kMaxValueSize];
+            uint8_t m_Size = 0;//0 - nothing set yet or the last set failed
+            uint32_t m_Epoch = 0;
+
+            bool Same(const void *pVal, size_t sz) const 
+            { 
+                return m_Size == sz && m_Epoch == g_Epoch && std::memcmp(m_Value, pVal, sz) == 0; 
+            }
+            void Store(const void *pVal, size_t sz) { std::memcpy(m_Value, pVal, sz); m_Size = sz; m_Epoch = g_Epoch; }
+        };
+
+        struct Entry
+        {
+            Shadow *m_pShadow;//identifies the attribute
+            apply_t m_Apply;
+            const BatchReportDesc *m_pReport;//null - left to the stack reporting
+            const char *m_pWhat;
+            uint8_t m_Size;
+            alignas(4) uint8_t m_Value[kMaxValueSize];
+        };
+
+        template<class Attr>
+        static inline Shadow g_Shadow{};
+
+        template<class Attr, class V>
+        static void apply(const void *pVal, const char *pWhat);
+
+        static bool Add(Shadow *pShadow, apply_t a, const BatchReportDesc *pReport, const void *pVal, size_t sz, const char *pWhat);
+        static void Flush();
+        //sends the dirty reported entries of the cluster of entry 'first', returns the sent ones
+        static uint32_t SendReport(uint32_t candidates, uint8_t first);
+
+        static inline uint8_t g_Depth = 0;
+        static inline uint8_t g_Count = 0;
+        static inline uint32_t g_Epoch = 1;
+        static inline uint8_t g_ReportSeq = 0;
+        static inline ReportStats g_ReportStats{};
+        static Entry g_Entries[kMaxEntries];
+    };
+
+    template<class Attr, class V>
+    void AttrBatch::apply(const void *pVal, const char *pWhat)
+    {
+        V v;
+        std::memcpy((void*)&v, pVal, sizeof(V));
+        auto &shadow = g_Shadow<Attr>;
+        if (auto status = Attr{}.Set(v); !status)
+        {
+            shadow.m_Size = 0;
+            FMT_PRINT("Failed to set {} with error {:x}\n", pWhat, (int)status.error());
+        }
+        else
+            shadow.Store(pVal, sizeof(V));
+    }
+}
+#endif
@@ -1,8 +1,10 @@
 #include "zb_binds.hpp"
+#include "zb_dev_def.hpp"
 #include "zb_dev_def_const.hpp"
 #include "zbh_types.hpp"
 #include "zbh_handlers_cmd.hpp"
 #include "zbh_bind_table.hpp"
+#include "esp_timer.h"
 
 
 template<>
@@ -44,6 +46,26 @@ namespace zb
 
     BindInfoPool g_BindInfoPool;
 
+    size_t BindInfo::MemoryPerBind()
+    {
+        return sizeof(BindInfoPool) / (kMaxBinds * 2) * 2 //2 pool slots per bind (tracked + scanned/cleaned up)
+            + sizeof(BindInfoPtr) * 3                    //tracked, cleanup and scan arrays
+            + sizeof(LocalConfig::BindCaps::Entry);      //persisted reporting capability
+    }
+
+    void BindInfo::LogMemoryFootprint()
+    {
+        FMT_PRINT("Binds: max {}; BindInfo: {} bytes (timer {}, response nodes {}, on/off cmd {}); pool: {} bytes; per additional bind: {} bytes\n"
+                , kMaxBinds
+                , sizeof(BindInfo)
+                , sizeof(m_Timer)
+                , sizeof(m_ReadReportConfigNode) + sizeof(m_ConfigReportNode) + sizeof(m_ReadAttrNode) + sizeof(m_SendStatusNode)
+                , sizeof(m_OnOffCmd)
+                , sizeof(BindInfoPool)
+                , MemoryPerBind()
+            );
+    }
+
     void BindInfo::Unbind()
     {
         TransitTo(State::Unbind);
@@ -56,11 +78,31 @@ namespace zb
         Do();
     }
 
+    void BindInfo::SkipChecks(bool reportConfigured)
+    {
+        m_BoundToMe = true;
+        m_ReportConfigured = reportConfigured;
+        m_Initial = false;//on/off state is unknown until the first report
+        TransitTo(State::Functional);
+    }
+
     bool BindInfo::IsPassive() const
     {
         return m_State == State::NonFunctional || m_State == State::Functional;
     }
 
+    void BindInfo::StateUpdated()
+    {
+        m_StateUpdatedMs = uint32_t(esp_timer_get_time() / 1000) | 1;//never 0
+    }
+
+    bool BindInfo::IsStateFresh(uint32_t maxAgeMs) const
+    {
+        if (!m_StateUpdatedMs)
+            return false;
+        return (uint32_t(esp_timer_get_time() / 1000) - m_StateUpdatedMs) < maxAgeMs;
+    }
+
     void BindInfo::RunCheckIfRequested()
     {
         if (m_CheckReporting && IsPassive())
@@ -74,12 +116,7 @@ namespace zb
     {
         switch(m_State)
         {
-            case State::New:
-                {
-                    TransitTo(State::VerifyBinds);
-                    return Do();
-                }
-                break;
+            case State::New: return StartChecks();
             case State::VerifyBinds: return GetBindTable();
             case State::SendBindToMeReq: return SendBindRequest();
             case State::CheckConfigureReport: return CheckReportConfiguration();
@@ -100,6 +137,24 @@ namespace zb
         }
     }
 
+    void BindInfo::StartChecks()
+    {
+        if (g_ChecksInFlight >= kMaxParallelChecks)
+        {
+            //stay 'New' and try again a bit later
+            m_Timer.Setup([](void *user_ctx){
+                    BindInfo *pBind = static_cast<BindInfo *>(user_ctx);
+                    if (!g_BindInfoPool.IsValid(pBind)) 
+                        return;//we're dead
+                    if (pBind->m_State == State::New)
+                        pBind->Do();
+                }, this, kCheckSlotRetryMs);
+            return;
+        }
+        TransitTo(State::VerifyBinds);
+        Do();
+    }
+
     void BindInfo::TransitTo(State s)
     {
         m_Timer.Cancel();
@@ -109,10 +164,24 @@ namespace zb
         m_ReadAttrNode.RemoveFromList();
 
         if (m_State == State::CheckReportingAbility && s != m_State)
+        {
             SendCmdToSetInitialValue();
+            //the test is over: a delivery requested meanwhile goes after the restored state
+            if (m_DeliveryQueued)
+                StartDelivery();
+        }
+
+        if (IsChecking(s) != IsChecking(m_State))
+        {
+            if (IsChecking(s))
+                ++g_ChecksInFlight;
+            else
+                --g_ChecksInFlight;
+        }
 
         FMT_PRINT("({:x})State change: {} => {}\n", m_ShortAddr, m_State, s);
         m_State = s;
+        g_State.BindsChanged();
     }
 
     template<BindInfo::State expectedState>
@@ -177,6 +246,39 @@ namespace zb
         }
     }
 
+    zb::seq_nr_t BindInfo::SendOnOffCmd(void *pCtx)
+    {
+        BindInfo *pBind = static_cast<BindInfo *>(pCtx);
+        if (!g_BindInfoPool.IsValid(pBind)) 
+            return kInvalidTSN;//we're dead
+        return pBind->m_ProbeCmd ? SendTryOnOffCmd(pCtx) : SendDeliveryCmd(pCtx);
+    }
+
+    void BindInfo::OnOnOffSuccess(void *pCtx)
+    {
+        BindInfo *pBind = static_cast<BindInfo *>(pCtx);
+        if (!g_BindInfoPool.IsValid(pBind)) 
+            return;//we're dead
+        return pBind->m_ProbeCmd ? OnTryOnOffSuccess(pCtx) : OnDeliverySuccess(pCtx);
+    }
+
+    void BindInfo::OnOnOffFail(void *pCtx, esp_zb_zcl_status_t status, esp_err_t e)
+    {
+        BindInfo *pBind = static_cast<BindInfo *>(pCtx);
+        if (!g_BindInfoPool.IsValid(pBind)) 
+            return;//we're dead
+        return pBind->m_ProbeCmd ? OnTryOnOffFail(pCtx, status, e) : OnDeliveryFail(pCtx, status, e);
+    }
+
+    void BindInfo::OnOnOffRetry(void *pCtx, esp_zb_zcl_status_t status, esp_err_t e)
+    {
+        BindInfo *pBind = static_cast<BindInfo *>(pCtx);
+        if (!g_BindInfoPool.IsValid(pBind)) 
+            return;//we're dead
+        if (!pBind->m_ProbeCmd)
+            OnDeliveryRetry(pCtx, status, e);
+    }
+
     zb::seq_nr_t BindInfo::SendTryOnOffCmd(void*pCtx)
     {
         BindInfo *pBind = static_cast<BindInfo *>(pCtx);
@@ -234,13 +336,124 @@ namespace zb
         }
     }
 
+    void BindInfo::Deliver(uint8_t cmdId)
+    {
+        const bool pending = IsDelivering();
+        if (pending && cmdId == m_DeliveryCmdId)
+            return;//already on its way
+        if (!pending)
+            ++m_Delivery.m_Sent;
+        m_DeliveryCmdId = cmdId;
+        m_DeliveryStartMs = uint32_t(esp_timer_get_time() / 1000);
+        if (m_State == State::CheckReportingAbility && m_ProbeCmd)
+        {
+            //the device is being toggled by the reporting test right now and
+            //its state gets restored at the end of it: deliver after that
+            m_DeliveryQueued = true;
+            FMT_PRINT("({:x})Reporting test in progress, cmd {:x} queued\n", m_ShortAddr, cmdId);
+            return;
+        }
+        StartDelivery();
+    }
+
+    void BindInfo::StartDelivery()
+    {
+        m_DeliveryQueued = false;
+        m_ProbeCmd = false;
+        m_OnOffCmd.Send(m_DeliveryCmdId);
+    }
+
+    zb::seq_nr_t BindInfo::SendDeliveryCmd(void *pCtx)
+    {
+        BindInfo *pBind = static_cast<BindInfo *>(pCtx);
+        if (!g_BindInfoPool.IsValid(pBind)) 
+        {
+            FMT_PRINT("Target BindInfo object is dead\n");
+            return kInvalidTSN;//we're dead
+        }
+        if (pBind->m_DeliveryCmdId == ESP_ZB_ZCL_CMD_ON_OFF_ON_WITH_TIMED_OFF_ID)
+        {
+            esp_zb_zcl_on_off_on_with_timed_off_cmd_t cmd_req{};
+            cmd_req.zcl_basic_cmd.src_endpoint = PRESENCE_EP;
+            cmd_req.zcl_basic_cmd.dst_endpoint = pBind->m_EP;
+            cmd_req.zcl_basic_cmd.dst_addr_u.addr_short = pBind->m_ShortAddr;
+            cmd_req.on_off_control = 0;//process unconditionally
+            cmd_req.on_time = g_Config.GetOnOffTimeout() * 10;
+            cmd_req.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+            return esp_zb_zcl_on_off_on_with_timed_off_cmd_req(&cmd_req);
+        }
+        esp_zb_zcl_on_off_cmd_t cmd_req{};
+        cmd_req.zcl_basic_cmd.src_endpoint = PRESENCE_EP;
+        cmd_req.zcl_basic_cmd.dst_endpoint = pBind->m_EP;
+        cmd_req.zcl_basic_cmd.dst_addr_u.addr_short = pBind->m_ShortAddr;
+        cmd_req.on_off_cmd_id = pBind->m_DeliveryCmdId;
+        cmd_req.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+        return esp_zb_zcl_on_off_cmd_req(&cmd_req);
+    }
+
+    void BindInfo::OnDeliverySuccess(void *pCtx)
+    {
+        BindInfo *pBind = static_cast<BindInfo *>(pCtx);
+        if (!g_BindInfoPool.IsValid(pBind)) 
+            return;//we're dead
+
+        auto &d = pBind->m_Delivery;
+        ++d.m_Delivered;
+        uint32_t latency = uint32_t(esp_timer_get_time() / 1000) - pBind->m_DeliveryStartMs;
+        d.m_LastLatencyMs = latency > 0xffff ? 0xffff : latency;
+        if (d.m_LastLatencyMs > d.m_MaxLatencyMs)
+            d.m_MaxLatencyMs = d.m_LastLatencyMs;
+        d.m_TotalLatencyMs += d.m_LastLatencyMs;
+        g_State.m_DeliveryStatsChanged = true;
+        g_State.RequestService();
+        FMT_PRINT("({:x})Delivered cmd {:x} in {}ms\n", pBind->m_ShortAddr, pBind->m_DeliveryCmdId, d.m_LastLatencyMs);
+    }
+
+    void BindInfo::OnDeliveryRetry(void *pCtx, esp_zb_zcl_status_t status, esp_err_t e)
+    {
+        BindInfo *pBind = static_cast<BindInfo *>(pCtx);
+        if (!g_BindInfoPool.IsValid(pBind)) 
+            return;//we're dead
+
+        ++pBind->m_Delivery.m_Retries;
+        g_State.m_DeliveryStatsChanged = true;
+        g_State.RequestService();
+        FMT_PRINT("({:x})Delivery of cmd {:x} failed: status {:x}; err {:x}. Retrying\n", pBind->m_ShortAddr, pBind->m_DeliveryCmdId, (int)status, e);
+    }
+
+    void BindInfo::OnDeliveryFail(void *pCtx, esp_zb_zcl_status_t status, esp_err_t e)
+    {
+        BindInfo *pBind = static_cast<BindInfo *>(pCtx);
+        if (!g_BindInfoPool.IsValid(pBind)) 
+            return;//we're dead
+
+        ++pBind->m_Delivery.m_Failed;
+        g_State.m_DeliveryStatsChanged = true;
+        g_State.RequestService();
+        FMT_PRINT("({:x})Could not deliver cmd {:x}: status {:x}; err {:x}\n", pBind->m_ShortAddr, pBind->m_DeliveryCmdId, (int)status, e);
+        cmd_total_failure(nullptr, status, e);
+    }
+
     void BindInfo::CheckReportingAbility()
     {
         m_AttemptsLeft = 0;//no re-tries on this side
+        if (!m_ProbeCmd && m_OnOffCmd.IsActive())
+        {
+            //a delivery is still in flight, test after it
+            m_Timer.Setup([](void *user_ctx){
+                    BindInfo *pBind = static_cast<BindInfo *>(user_ctx);
+                    if (!g_BindInfoPool.IsValid(pBind)) 
+                        return;//we're dead
+                    if (pBind->m_State == State::CheckReportingAbility)
+                        pBind->Do();
+                }, this, kCheckSlotRetryMs);
+            return;
+        }
+        m_ProbeCmd = true;
         if (m_InitialValue)
-            m_TryReportCmd.Send(ESP_ZB_ZCL_CMD_ON_OFF_OFF_ID);
+            m_OnOffCmd.Send(ESP_ZB_ZCL_CMD_ON_OFF_OFF_ID);
         else
-            m_TryReportCmd.Send(ESP_ZB_ZCL_CMD_ON_OFF_ON_ID);
+            m_OnOffCmd.Send(ESP_ZB_ZCL_CMD_ON_OFF_ON_ID);
     }
 
     void BindInfo::SendCmdToSetInitialValue()
@@ -346,14 +559,18 @@ namespace zb
         {
             FMT_PRINT("({:x})Read Attribute done. Attribute found, value {}. All good.\n", pBind->m_ShortAddr, value);
             pBind->m_InitialValue = value;
-            pBind->m_ReportConfigured = !pBind->m_CheckReporting;
-            if (pBind->m_CheckReporting)
+            if (pBind->m_CheckReporting && g_Config.GetActiveReportingCheck())
             {
-                FMT_PRINT("({:x})Reporting check is requested so doing that.\n", pBind->m_ShortAddr);
+                FMT_PRINT("({:x})Active reporting check is requested so doing that.\n", pBind->m_ShortAddr);
+                pBind->m_ReportConfigured = false;
                 pBind->TransitTo(State::CheckReportingAbility);
             }
             else
             {
+                //we only get here if the device either had a reporting config for on/off
+                //or accepted ours and it answers attribute reads: that's good enough
+                //without toggling the device
+                pBind->m_ReportConfigured = true;
                 pBind->TransitTo(State::Functional);
             }
             pBind->Do();
@@ -400,7 +617,8 @@ namespace zb
             if (pVar->attribute_id == ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID)
             {
                 FMT_PRINT("({:x})Got attribute {:x}; Status {:x}\n", pBind->m_ShortAddr, pVar->attribute_id, pVar->status);
-                if (pVar->status == ESP_ZB_ZCL_STATUS_SUCCESS)
+                //max interval of 0xffff means reporting is switched off
+                if (pVar->status == ESP_ZB_ZCL_STATUS_SUCCESS && pVar->send_info.max_interval != 0xffff)
                 {
                     found = true;
                     break;
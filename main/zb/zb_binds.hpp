@@ -8,8 +8,10 @@
 #include "lib_object_pool.hpp"
 #include "lib_array_count.hpp"
 #include "zbh_alarm.hpp"
+#include "zb_timer_wheel.hpp"
 #include "zbh_cmd_sender.hpp"
 #include "zb_main.hpp"
+#include "zb_dev_def_const.hpp"
 
 namespace zb
 {
@@ -50,47 +52,110 @@ namespace zb
         };
         static constexpr uint16_t kMaxConfigAttempts = 3;
         static constexpr uint32_t kTimeout = 2000;
+        //binds going through the checks (VerifyBinds..TryReadAttribute) at the same time
+        static constexpr uint8_t kMaxParallelChecks = 3;
+        static constexpr uint32_t kCheckSlotRetryMs = 250;
         BindInfo(esp_zb_ieee_addr_t const &a, uint16_t sh):m_ShortAddr(sh)
         {
             std::memcpy(m_IEEE, a, sizeof(esp_zb_ieee_addr_t));
             m_SendStatusNode.user_ctx = this;
         }
+        ~BindInfo()
+        {
+            if (IsChecking(m_State))
+                --g_ChecksInFlight;
+        }
 
         esp_zb_ieee_addr_t m_IEEE;
         uint16_t m_ShortAddr;
         struct{
-            uint16_t m_EP              : 8 = 0;
-            uint16_t m_ReportConfigured: 1 = 0;
-            uint16_t m_BoundToMe       : 1 = 0;
-            uint16_t m_BindChecked     : 1 = 0;
-            uint16_t m_AttemptsLeft    : 2 = 0;
-            uint16_t m_InitialValue    : 1 = 0;//valid only if m_Initial is true
-            uint16_t m_Initial         : 1 = 1;
-            uint16_t m_CheckReporting  : 1 = 0;
+            uint32_t m_EP              : 8 = 0;
+            uint32_t m_ReportConfigured: 1 = 0;
+            uint32_t m_BoundToMe       : 1 = 0;
+            uint32_t m_BindChecked     : 1 = 0;
+            uint32_t m_AttemptsLeft    : 2 = 0;
+            uint32_t m_InitialValue    : 1 = 0;//valid only if m_Initial is true
+            uint32_t m_Initial         : 1 = 1;
+            uint32_t m_CheckReporting  : 1 = 0;
+            uint32_t m_ProbeCmd        : 1 = 0;//m_OnOffCmd carries the reporting test toggle, not a delivery
+            uint32_t m_DeliveryQueued  : 1 = 0;//requested during the reporting test, sent once the test restored the state
+        };
+
+        //outcome of the on/off commands delivered directly to this bind (per bind delivery)
+        //m_Sent = m_Delivered + m_Failed + the one in flight, if any
+        struct DeliveryStats
+        {
+            uint16_t m_Sent = 0;//a request while one is in flight is coalesced into it, not counted
+            uint16_t m_Delivered = 0;
+            uint16_t m_Failed = 0;//all attempts failed
+            uint16_t m_Retries = 0;
+            uint16_t m_LastLatencyMs = 0;
+            uint16_t m_MaxLatencyMs = 0;
+            uint32_t m_TotalLatencyMs = 0;//of the delivered ones
+
+            uint16_t AvgLatencyMs() const 
+            { 
+                return m_Delivered ? uint16_t(m_TotalLatencyMs / m_Delivered) : 0; 
+            }
         };
 
+        //time of the last known on/off state of the device (report or read), 0 - never
+        uint32_t m_StateUpdatedMs = 0;
+        DeliveryStats m_Delivery;
+
         void Do();
         void Unbind();
         void Failed();
+        //reporting is known to work (from an earlier check): straight to Functional
+        void SkipChecks(bool reportConfigured);
         void RunCheckIfRequested();
         bool IsPassive() const;
+        void StateUpdated();
+        bool IsStateFresh(uint32_t maxAgeMs) const;
         State GetState() const { return m_State; }
 
         void OnReport(const esp_zb_zcl_report_attr_message_t *pReport);
+
+        //on/off command to this bind only, with own TSN, timeout and retries.
+        //One at a time: a different command replaces the one in flight (only the latest state matters),
+        //the same one is left alone
+        void Deliver(uint8_t cmdId);
+        bool IsDelivering() const { return m_DeliveryQueued || (!m_ProbeCmd && m_OnOffCmd.IsActive()); }
+
+        //memory taken by one more bind (kMaxBinds + 1), see LogMemoryFootprint
+        static size_t MemoryPerBind();
+        static void LogMemoryFootprint();
     private:
+        //m_OnOffCmd is shared by the delivery and the reporting test: dispatch by m_ProbeCmd
+        static zb::seq_nr_t SendOnOffCmd(void*);
+        static void OnOnOffSuccess(void*);
+        static void OnOnOffFail(void*, esp_zb_zcl_status_t, esp_err_t);
+        static void OnOnOffRetry(void*, esp_zb_zcl_status_t, esp_err_t);
+
+        static zb::seq_nr_t SendDeliveryCmd(void*);
+        static void OnDeliverySuccess(void*);
+        static void OnDeliveryFail(void*, esp_zb_zcl_status_t, esp_err_t);
+        static void OnDeliveryRetry(void*, esp_zb_zcl_status_t, esp_err_t);
+
         static zb::seq_nr_t SendTryOnOffCmd(void*);
         static void OnTryOnOffSuccess(void*);
         static void OnTryOnOffFail(void*, esp_zb_zcl_status_t, esp_err_t);
 
+        static constexpr bool IsChecking(State s) { return s >= State::VerifyBinds && s <= State::TryReadAttribute; }
+        static inline uint8_t g_ChecksInFlight = 0;
+
         State m_State = State::New;
-        ZbAlarm m_Timer;
+        WheelTimer m_Timer;
         ReadReportConfigNode m_ReadReportConfigNode;
         ConfigReportNode m_ConfigReportNode;
         ReadAttrRespNode m_ReadAttrNode;
-        CmdWithRetries<ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_CMD_ON_OFF_ON_ID, 2> m_TryReportCmd{SendTryOnOffCmd, OnTryOnOffSuccess, OnTryOnOffFail, nullptr, this};
         ZbCmdSend::Node m_SendStatusNode;
+        CmdWithRetries<ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_CMD_ON_OFF_ON_ID, 2> m_OnOffCmd{SendOnOffCmd, OnOnOffSuccess, OnOnOffFail, OnOnOffRetry, this};
+        uint8_t m_DeliveryCmdId = ESP_ZB_ZCL_CMD_ON_OFF_ON_ID;
+        uint32_t m_DeliveryStartMs = 0;
 
         void TransitTo(State s);
+        void StartDelivery();
 
         void SendCmdToSetInitialValue();
         void SendBindRequest();
@@ -106,6 +171,7 @@ namespace zb
         static void OnBindTableFinished(const esp_zb_zdo_binding_table_info_t *table_info, void *user_ctx);
         static void OnBindTableFailure(const esp_zb_zdo_binding_table_info_t *table_info, void *pCtx);
 
+        void StartChecks();
         void CheckReportingAbility();
         void ReadAttribute();
         void CheckReportConfiguration();
@@ -116,7 +182,6 @@ namespace zb
         template<State expectedState>
         static void OnSendStatus(esp_zb_zcl_command_send_status_message_t *pSendStatus, void *user_ctx);
     };
-    constexpr size_t kMaxBinds = 6;
     using BindInfoPool = ObjectPool<BindInfo, kMaxBinds * 2>;
     extern BindInfoPool g_BindInfoPool;
 
@@ -0,0 +1,107 @@
+#include "zb_boot_timeline.hpp"
+#include "zb_dev_def.hpp"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "nvs.h"
+#include <cstring>
+
+namespace zb
+{
+    static const char *kNvsNamespace = "diag";
+    static const char *kNvsKey = "boot_tl";
+
+    static BootTimeline::Record g_Current = []{
+        BootTimeline::Record r{};
+        for(auto &ms : r.m_Ms)
+            ms = BootTimeline::kNotReached;
+        return r;
+    }();
+    //previous boots, newest first
+    static BootTimeline::Record g_History[BootTimeline::kBoots - 1];
+    static bool g_Finalized = false;
+    static WheelTimer g_FinalizeTimer;
+
+    static void update_attr()
+    {
+        BootTimelineBufType buf;
+        buf.data[0] = BootTimeline::kFormatVersion;
+        buf.data[1] = BootTimeline::kPhases;
+        std::memcpy(buf.data + 2, &g_Current, sizeof(g_Current));
+        std::memcpy(buf.data + 2 + sizeof(g_Current), g_History, sizeof(g_History));
+        if (auto status = g_BootTimeline.Set(buf); !status)
+        {
+            FMT_PRINT("Failed to set boot timeline attribute with error {:x}\n", (int)status.error());
+        }
+    }
+
+    void BootTimeline::Mark(Phase p)
+    {
+        auto &ms = g_Current.m_Ms[size_t(p)];
+        if (ms != kNotReached)
+            return;
+        const int64_t t = esp_timer_get_time() / 1000;
+        ms = t < kNotReached ? uint16_t(t) : uint16_t(kNotReached - 1);
+    }
+
+    void BootTimeline::SensorAttempt()
+    {
+        if (g_Current.m_SensorAttempts < 0xff)
+            ++g_Current.m_SensorAttempts;
+    }
+
+    void BootTimeline::Load()
+    {
+        std::memset(g_History, 0xff, sizeof(g_History));
+        g_Current.m_ResetReason = uint8_t(esp_reset_reason());
+
+        nvs_handle_t h;
+        if (nvs_open(kNvsNamespace, NVS_READONLY, &h) != ESP_OK)
+            return;//first boot
+        size_t sz = sizeof(g_History);
+        //a different size means a different set of phases or boots: start over
+        if (nvs_get_blob(h, kNvsKey, g_History, &sz) != ESP_OK || sz != sizeof(g_History))
+            std::memset(g_History, 0xff, sizeof(g_History));
+        nvs_close(h);
+    }
+
+    void BootTimeline::Start()
+    {
+        update_attr();
+        if (!g_Finalized)
+            g_FinalizeTimer.Setup([](void *){ Finalize(); }, nullptr, kFinalizeTimeoutMs);
+    }
+
+    void BootTimeline::Finalize()
+    {
+        if (g_Finalized)
+            return;
+        g_Finalized = true;
+        g_FinalizeTimer.Cancel();
+
+        //the current boot goes first
+        Record boots[kBoots - 1];
+        boots[0] = g_Current;
+        std::memcpy(&boots[1], g_History, sizeof(boots) - sizeof(boots[0]));
+
+        nvs_handle_t h;
+        esp_err_t e = nvs_open(kNvsNamespace, NVS_READWRITE, &h);
+        if (e == ESP_OK)
+        {
+            e = nvs_set_blob(h, kNvsKey, boots, sizeof(boots));
+            if (e == ESP_OK)
+                e = nvs_commit(h);
+            nvs_close(h);
+        }
+        if (e != ESP_OK)
+            FMT_PRINT("Failed to persist boot timeline: {:x}\n", (int)e);
+
+        auto const& ms = g_Current.m_Ms;
+        FMT_PRINT("Boot timeline: zb started {}ms; joined {}ms; sensor ready {}ms ({} attempts); first presence {}ms\n"
+                , ms[size_t(Phase::ZbStarted)]
+                , ms[size_t(Phase::Joined)]
+                , ms[size_t(Phase::SensorReady)]
+                , g_Current.m_SensorAttempts
+                , ms[size_t(Phase::FirstPresence)]);
+        update_attr();
+    }
+}
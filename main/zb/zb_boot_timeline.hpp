@@ -0,0 +1,64 @@
+#ifndef ZB_BOOT_TIMELINE_HPP_
+#define ZB_BOOT_TIMELINE_HPP_
+
+#include <cstdint>
+#include <cstddef>
+
+namespace zb
+{
+    /**********************************************************************/
+    /* Boot timeline                                                      */
+    /**********************************************************************/
+    //Time from the chip start (esp_timer, the bootloader not included) to
+    //each boot phase. Once the first presence state is consumed (or after
+    //kFinalizeTimeoutMs) the boot is added to the last kBoots boots kept
+    //in NVS. All of them are exposed by the boot_timeline attribute,
+    //tools/boot_timeline.py renders it.
+    //Each phase is marked from a single task, the first mark wins.
+    struct BootTimeline
+    {
+        enum class Phase: uint8_t
+        {
+            AppMain,
+            NvsInit,
+            PlatformConfig,
+            ConfigLoaded,
+            ZbInit,
+            DeviceRegistered,
+            ZbStarted,
+            StackReady,     //device first start/reboot signal
+            Joined,         //steering done or rebooted into the known network
+            SensorSetup,    //first Component::Setup of the primary sensor
+            SensorReady,
+            FirstPresence,  //first movement state of the primary sensor consumed
+
+            Count
+        };
+        static constexpr size_t kPhases = size_t(Phase::Count);
+        //the current and the previous boot: more would not fit a single unfragmented frame
+        static constexpr size_t kBoots = 2;
+        static constexpr uint16_t kNotReached = 0xffff;
+        static constexpr uint32_t kFinalizeTimeoutMs = 60 * 1000;
+        static constexpr uint8_t kFormatVersion = 1;
+
+        struct Record
+        {
+            uint8_t m_ResetReason;//esp_reset_reason_t
+            uint8_t m_SensorAttempts;
+            uint16_t m_Ms[kPhases];//saturated at kNotReached - 1
+        };
+        //attribute: format version, phase count, then kBoots records, the current boot first.
+        //Records of boots that didn't happen are all 0xff
+        static constexpr size_t kAttrSize = 2 + kBoots * sizeof(Record);
+
+        static void Mark(Phase p);
+        static void SensorAttempt();
+        //previous boots from NVS, right after nvs_flash_init
+        static void Load();
+        //zigbee task: publishes the attribute and arms the finalize timeout
+        static void Start();
+        //zigbee task: persists the current boot and updates the attribute. Once per boot
+        static void Finalize();
+    };
+}
+#endif
@@ -5,6 +5,7 @@
 #include "zb_dev_def_attr.hpp"
 #include "../device_config.hpp"
 #include "zb_binds.hpp"
+#include "zb_presence_fusion.hpp"
 
 namespace zb
 {
@@ -34,6 +35,42 @@ namespace zb
     static constexpr int LD2412_PINS_PIR_PRESENCE = 5;
     static constexpr int PINS_RESET = 3;
 
+    /**********************************************************************/
+    /* Board description: one entry per LD2412 sensor                     */
+    /**********************************************************************/
+    struct SensorBoardDesc
+    {
+        uint8_t m_EP;
+        uart::Port m_Port;
+        int m_TxPin;
+        int m_RxPin;
+        int m_PresencePin = -1;
+        int m_PIRPin = -1;
+    };
+
+#if defined(ENABLE_SECOND_SENSOR)
+    //the 2nd sensor takes UART0, so the console must be on USB-Serial-JTAG
+#if defined(CONFIG_ESP_CONSOLE_UART_DEFAULT) || defined(CONFIG_ESP_CONSOLE_UART_CUSTOM)
+#error "Second sensor requires the console to be moved off UART0"
+#endif
+#if defined(CONFIG_IDF_TARGET_ESP32C6)
+    static constexpr int LD2412_2_PINS_TX = 21; 
+    static constexpr int LD2412_2_PINS_RX = 20;
+#elif defined(CONFIG_IDF_TARGET_ESP32H2)
+    static constexpr int LD2412_2_PINS_TX = 22; 
+    static constexpr int LD2412_2_PINS_RX = 12;
+#endif
+#endif
+
+    static constexpr SensorBoardDesc g_SensorBoard[kSensorCount] = {
+        {.m_EP = PRESENCE_EP, .m_Port = uart::Port::Port1, .m_TxPin = LD2412_PINS_TX, .m_RxPin = LD2412_PINS_RX, .m_PresencePin = LD2412_PINS_PRESENCE, .m_PIRPin = LD2412_PINS_PIR_PRESENCE},
+#if defined(ENABLE_SECOND_SENSOR)
+        //secondary sensor: radar only, presence is taken from the frames
+        {.m_EP = SECONDARY_PRESENCE_EP, .m_Port = uart::Port::Port0, .m_TxPin = LD2412_2_PINS_TX, .m_RxPin = LD2412_2_PINS_RX},
+#endif
+    };
+    static_assert(g_SensorBoard[0].m_EP == PRESENCE_EP, "First sensor is the primary one");
+
     static constexpr TickType_t FACTORY_RESET_TIMEOUT = 4;//4 seconds
     static constexpr TickType_t FACTORY_RESET_TIMEOUT_WAIT = 1000 * FACTORY_RESET_TIMEOUT / portTICK_PERIOD_MS;
 
@@ -54,6 +91,7 @@ namespace zb
     bool update_presence_state();
     void setup_sensor();
     void update_zb_occupancy_attr();
+    void update_engineering_telemetry_attr();
 
     struct OnWithTimedOffPayload;
 
@@ -127,6 +165,7 @@ namespace zb
 
 
         uint32_t GetVal() const { return *(uint32_t*)this; }
+        void SetBoundDevices(size_t n) { m_BoundDevices = n > 15 ? 15 : n; }//saturated
         uint32_t GetVal2() const { return *((uint32_t*)this + 1); }
         uint32_t GetVal3() const { return *((uint32_t*)this + 2); }
 
@@ -145,10 +184,15 @@ namespace zb
         bool m_LastPresenceMMWave = false;
         bool m_LastPresencePIRInternal = false;
         bool m_LastPresenceExternal = false;
+        bool m_LastApproaching = false;
+        int16_t m_LastApproachSpeed = 0;
         LD2412::TargetState m_LastLD2412State = LD2412::TargetState::Clear;
         ld2412::Component::ExtendedState m_LastLD2412ExtendedState = ld2412::Component::ExtendedState::Normal;
-        ZbAlarm m_RunningTimer{"m_RunningTimer"};
-        ZbAlarm m_ExternalRunningTimer{"m_ExternalRunningTimer"};
+        LD2412::PresenceResult m_LastTarget;//of the primary sensor
+        bool m_EngineeringTelemetry = false;//runtime only, off after restart
+        uint8_t m_DeliveryStatsPage = 0;//runtime only, see ATTRIB_BIND_DELIVERY_STATS_PAGE
+        WheelTimer m_RunningTimer;
+        WheelTimer m_ExternalRunningTimer;
 
         CmdWithRetries<ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_CMD_ON_OFF_ON_ID, 2>                m_OnSender{send_on_raw, nullptr, cmd_total_failure, cmd_failure, &m_OnSender};
         CmdWithRetries<ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_CMD_ON_OFF_OFF_ID, 2>               m_OffSender{send_off_raw, nullptr, cmd_total_failure, cmd_failure, &m_OffSender};
@@ -165,30 +209,95 @@ namespace zb
         static constexpr esp_zb_zcl_cluster_id_t g_RelevantBoundClusters[] = {ESP_ZB_ZCL_CLUSTER_ID_ON_OFF};
 
         Internals m_Internals;
-        ZbAlarm m_BindsCheck{"BindsCheck"};
+        WheelTimer m_BindsCheck;
 
         BindArray m_TrackedBinds;
         BindArray m_BindsToCleanup;
-        uint8_t m_ValidBinds = 0;
-        uint8_t m_BindStates = 0;//on/off, bit per bind
+        BindMask m_ValidBinds = 0;
+        BindMask m_BindStates = 0;//on/off, bit per bind
 
         BindArray m_TempNewBinds;
         uint8_t m_FoundExisting = 0;
 
-        TriState8Array m_BindsReportingCapable;
+        //A bind request is only tracked once it is in our binding table: the stack
+        //may still reject it (table full, unknown address). Requests are collected
+        //for a short while and confirmed by a single read of the table
+        static constexpr uint32_t kBindConfirmDelayMs = 200;
+        struct PendingBind
+        {
+            esp_zb_ieee_addr_t m_IEEE;
+            uint8_t m_EP;
+
+            bool Matches(esp_zb_ieee_addr_t const& ieee) const { return std::memcmp(m_IEEE, ieee, sizeof(m_IEEE)) == 0; }
+        };
+        using PendingBindArray = ArrayCount<PendingBind, kMaxBinds>;
+        PendingBindArray m_PendingBinds;//waiting for the next confirmation
+        PendingBindArray m_ConfirmingBinds;//looked up in the binding table right now
+        WheelTimer m_BindConfirm;
+
+        //unbind requests are applied right away, bind requests once confirmed (see above),
+        //the full scan of the binding table is just a consistency check then
+        static constexpr uint32_t kBindsConsistencyCheckMs = 30 * 60 * 1000;
+        uint32_t m_LastBindsScanMs = 0;
+
+        //group binds have no device behind them to check: just the group addresses
+        static constexpr size_t kMaxGroupBinds = 4;
+        using GroupArray = ArrayCount<uint16_t, kMaxGroupBinds>;
+        GroupArray m_TrackedGroups;
+        GroupArray m_TempNewGroups;
+
+        //bind states older than that are not trusted to skip a command
+        static constexpr uint32_t kBindStateMaxAgeMs = 15 * 60 * 1000;
+        uint16_t m_ElidedCommands = 0;
+
         struct{
-            uint8_t m_InitialBindsChecking : 1 = true;
-            uint8_t m_NeedBindsChecking    : 1 = true;
-            uint8_t m_FailedStatusUpdated  : 1 = false;
-            uint8_t m_FalsePIRProbe        : 1 = false;
+            uint16_t m_InitialBindsChecking : 1 = true;
+            uint16_t m_NeedBindsChecking    : 1 = true;
+            uint16_t m_FailedStatusUpdated  : 1 = false;
+            uint16_t m_FalsePIRProbe        : 1 = false;
+            uint16_t m_DeliveryStatsChanged : 1 = false;
+            uint16_t m_BindsScanActive      : 1 = false;
+            uint16_t m_BindsConfirmActive   : 1 = false;//pending binds are being confirmed
+            //dirty flags of RunService, see RequestService
+            uint16_t m_BindsDirty           : 1 = true;//a bind changed its state
+            uint16_t m_InternalsDirty       : 1 = true;
+            uint16_t m_LightDirty           : 1 = true;
+            uint16_t m_ServiceSoon          : 1 = false;//a run other than the heartbeat is scheduled
         };
 
+        //RunService is only scheduled when something above is dirty.
+        //The heartbeat is a backstop for anything changed behind our back
+        //and drives the periodic checks.
+        static constexpr uint32_t kServiceDelayMs = 100;//coalesces bursts of changes
+        static constexpr uint32_t kServiceRetryMs = 1000;//deferred while commands to binds are in flight
+        static constexpr uint32_t kServiceHeartbeatMs = 60 * 1000;
+        WheelTimer m_ServiceTimer;
+        uint8_t m_PublishedLight = 0;
+
+        //per sensor part of the state. The primary sensor is also reflected in the m_LastLD2412* fields
+        fusion::Sensors<kSensorCount, LD2412::TargetState> m_Sensors;
+        bool AnySensorPresence() const { return m_Sensors.Any(); }
+
         uint8_t m_ExternalIlluminance = 0;
         uint32_t m_LastPIRStartedTick = 0;
         uint32_t m_LastPIRTimeMS = 0;
 
         bool CommandsToBindInFlight() const;
         bool CanSendCommandsToBind() const;
+        //only group binds: a single groupcast per group instead of the binding table fan-out
+        bool GroupcastOnly() const { return m_TrackedGroups.size() && !m_TrackedBinds.size(); }
+        //bit per tracked bind that still needs to be switched to 'on'.
+        //All bits are set if the state of any target is not known for sure
+        BindMask BindsNeedingState(bool on) const;
+        void SendOn();
+        void SendOff();
+        void SendOnTimed();
+        //per bind delivery: a unicast to every bind in the mask plus a groupcast per group
+        //returns 'false' if not enabled or not possible (nothing is sent then)
+        bool DeliverPerBind(uint8_t cmdId, BindMask bindsMask);
+        void SendToGroups(uint8_t cmdId);
+        void UpdateDeliveryStatsAttr();
+        void UpdateConfigWriteStatsAttr();
         uint8_t GetIlluminance() const;
         static bool IsRelevant(esp_zb_zcl_cluster_id_t id)
         {
@@ -202,6 +311,23 @@ namespace zb
         void StartLocalTimer(esp_zb_user_callback_t cb, uint32_t time);
         void ScheduleBindsChecking();
         void RunBindsChecking();
+        //incremental changes from a bind/unbind request
+        //returns 'false' if it couldn't be applied: a full scan is needed then
+        bool ApplyBindDelta(bool bind, esp_zb_ieee_addr_t const& ieee, uint8_t ep);
+        void ConfirmPendingBinds();
+        void EndBindsConfirmation();
+        //a bind confirmed in the binding table: tracked and checked
+        bool TrackNewBind(esp_zb_ieee_addr_t const& ieee, uint8_t ep);
+        bool ApplyGroupBindDelta(bool bind, uint16_t group);
+        void RemoveTrackedBind(size_t idx);
+        //the device may have been re-paired or updated: its cached reporting capability is stale
+        void DeviceAnnounced(esp_zb_ieee_addr_t const& ieee);
+        //set the relevant dirty flag first
+        void RequestService();
+        void BindsChanged() { m_BindsDirty = true; RequestService(); }
+        void InternalsChanged() { m_InternalsDirty = true; RequestService(); }
+        void LightMeasured();
+        void ServiceBinds();
         void RunService();
     };
 
@@ -211,7 +337,8 @@ namespace zb
     /**********************************************************************/
     /* LD2412 Component                                                   */
     /**********************************************************************/
-    extern ld2412::Component g_ld2412;//THE presence sensor component
+    extern ld2412::Component g_Sensors[kSensorCount];//presence sensor components, see g_SensorBoard
+    inline ld2412::Component &g_ld2412 = g_Sensors[0];//THE (primary) presence sensor component
 
     /**********************************************************************/
     /* Storable data                                                      */
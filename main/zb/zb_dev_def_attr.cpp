@@ -1,21 +1,16 @@
 #include "zb_dev_def.hpp"
 #include "esp_check.h"
+#include "zb_attr_batch.hpp"
 
 namespace zb
 {
 
-    static ZbAlarmExt16 g_DelayedAttrUpdate;
+    static WheelTimerExt16 g_DelayedAttrUpdate;
     void update_zb_occupancy_attr()
     {
         esp_zb_zcl_occupancy_sensing_occupancy_t val = g_State.m_LastPresence ? ESP_ZB_ZCL_OCCUPANCY_SENSING_OCCUPANCY_OCCUPIED : ESP_ZB_ZCL_OCCUPANCY_SENSING_OCCUPANCY_UNOCCUPIED;
-        if (auto status = g_OccupancyState.Set(val); !status)
-        {
-            FMT_PRINT("Failed to set occupancy attribute with error {:x}\n", (int)status.error());
-        }
-        if (auto status = g_ArmedForTrigger.Set(g_State.m_TriggerAllowed); !status)
-        {
-            FMT_PRINT("Failed to set 'Armed for Trigger' attribute with error {:x}\n", (int)status.error());
-        }
+        AttrBatch::Set(g_OccupancyState, val, "occupancy attribute");
+        AttrBatch::Set(g_ArmedForTrigger, bool(g_State.m_TriggerAllowed), "'Armed for Trigger' attribute");
     }
     /**********************************************************************/
     /* Attributes                                                         */
@@ -153,6 +148,209 @@ namespace zb
                 return ESP_OK;
             }
         >{},
+        AttrDescr<ZclAttributeReportDistanceDeadband_t, 
+            [](const uint16_t &to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing distance report deadband to {}\n", to);
+                auto p = g_Config.GetReportPolicy();
+                p.m_Distance.m_Deadband = to;
+                g_Config.SetReportPolicy(p);
+                g_ld2412.ChangeReportPolicy(p);
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<ZclAttributeReportDistanceMinInterval_t, 
+            [](const uint16_t &to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing distance report min interval to {}ms\n", to);
+                auto p = g_Config.GetReportPolicy();
+                p.m_Distance.m_MinIntervalMs = to;
+                g_Config.SetReportPolicy(p);
+                g_ld2412.ChangeReportPolicy(p);
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<ZclAttributeReportDistanceMaxInterval_t, 
+            [](const uint16_t &to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing distance report max interval to {}s\n", to);
+                auto p = g_Config.GetReportPolicy();
+                p.m_Distance.m_MaxIntervalS = to;
+                g_Config.SetReportPolicy(p);
+                g_ld2412.ChangeReportPolicy(p);
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<ZclAttributeReportEnergyDeadband_t, 
+            [](const uint16_t &to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing energy report deadband to {}\n", to);
+                auto p = g_Config.GetReportPolicy();
+                p.m_Energy.m_Deadband = to;
+                g_Config.SetReportPolicy(p);
+                g_ld2412.ChangeReportPolicy(p);
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<ZclAttributeReportEnergyMinInterval_t, 
+            [](const uint16_t &to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing energy report min interval to {}ms\n", to);
+                auto p = g_Config.GetReportPolicy();
+                p.m_Energy.m_MinIntervalMs = to;
+                g_Config.SetReportPolicy(p);
+                g_ld2412.ChangeReportPolicy(p);
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<ZclAttributeReportEnergyMaxInterval_t, 
+            [](const uint16_t &to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing energy report max interval to {}s\n", to);
+                auto p = g_Config.GetReportPolicy();
+                p.m_Energy.m_MaxIntervalS = to;
+                g_Config.SetReportPolicy(p);
+                g_ld2412.ChangeReportPolicy(p);
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<ZclAttributeReportAdaptive_t, 
+            [](const bool &to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing adaptive report policy to {}\n", to);
+                auto p = g_Config.GetReportPolicy();
+                p.m_Adaptive = to;
+                g_Config.SetReportPolicy(p);
+                g_ld2412.ChangeReportPolicy(p);
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<ZclAttributeApproachDistance_t, 
+            [](const uint16_t &to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing approach trigger distance to {}cm\n", to);
+                g_Config.SetApproachDistance(to);
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<ZclAttributeNoiseFloorTracking_t, 
+            [](const bool &to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing noise floor tracking to {}\n", to);
+                auto nf = g_Config.GetNoiseFloor();
+                nf.m_Enabled = to;
+                g_Config.SetNoiseFloor(nf);
+                g_ld2412.ChangeNoiseFloorTracking(nf.m_Enabled, nf.m_MaxDelta);
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<ZclAttributeNoiseFloorMaxDelta_t, 
+            [](const uint8_t &to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing noise floor max threshold delta to {}\n", to);
+                auto nf = g_Config.GetNoiseFloor();
+                nf.m_MaxDelta = to;
+                g_Config.SetNoiseFloor(nf);
+                g_ld2412.ChangeNoiseFloorTracking(nf.m_Enabled, nf.m_MaxDelta);
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<ZclAttributeZonesConfig_t, 
+            [](ZonesBufType const& to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing zones to {}\n", to.sv());
+                ld2412::Component::ZonesConfig zones;
+                for(uint8_t i = 0; i < ld2412::Component::kMaxZones; ++i)
+                {
+                    auto &z = zones.m_Zones[i];
+                    z = {.m_FirstGate = to.data[i * 4], .m_LastGate = to.data[i * 4 + 1], .m_MoveThreshold = to.data[i * 4 + 2], .m_StillThreshold = to.data[i * 4 + 3]};
+                    if ((z.m_FirstGate > z.m_LastGate) || (z.m_LastGate > 13))
+                        return ESP_ERR_INVALID_ARG;
+                }
+                g_Config.SetZones(zones);
+                for(uint8_t i = 0; i < ld2412::Component::kMaxZones; ++i)
+                    g_ld2412.ChangeZone(i, zones.m_Zones[i]);
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<ZclAttributePerBindDelivery_t, 
+            [](const bool &to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing per bind delivery to {}\n", to);
+                g_Config.SetPerBindDelivery(to);
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<ZclAttributeBindDeliveryStatsPage_t, 
+            [](const uint8_t &to, const auto *message)->esp_err_t
+            {
+                if (to >= kBindDeliveryStatsPages)
+                    return ESP_ERR_INVALID_ARG;
+                FMT_PRINT("Changing bind delivery stats page to {}\n", to);
+                g_State.m_DeliveryStatsPage = to;
+                g_State.UpdateDeliveryStatsAttr();//ready for the read that follows
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<ZclAttributeEngineeringTelemetryEnabled_t, 
+            [](const bool &to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing engineering telemetry to {}\n", to);
+                g_State.m_EngineeringTelemetry = to;
+                update_engineering_telemetry_attr();
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<ZclAttributeActiveReportingCheck_t, 
+            [](const bool &to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing active reporting check to {}\n", to);
+                g_Config.SetActiveReportingCheck(to);
+                return ESP_OK;
+            }
+        >{},
+#if defined(ENABLE_SECOND_SENSOR)
+        AttrDescr<SecondarySensorAttributes::MoveSensitivity_t, 
+            [](SensitivityBufType const& to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing move sensitivity of ep {} to {}\n", SECONDARY_PRESENCE_EP, to.sv());
+                g_Sensors[1].ChangeMoveSensitivity(to.data);
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<SecondarySensorAttributes::StillSensitivity_t, 
+            [](SensitivityBufType const& to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing still sensitivity of ep {} to {}\n", SECONDARY_PRESENCE_EP, to.sv());
+                g_Sensors[1].ChangeStillSensitivity(to.data);
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<SecondarySensorAttributes::MaxDistance_t, 
+            [](const uint16_t &to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing max distance of ep {} to {}\n", SECONDARY_PRESENCE_EP, to);
+                g_Sensors[1].ChangeMaxDistance(to);
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<SecondarySensorAttributes::MinDistance_t, 
+            [](const uint16_t &to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing min distance of ep {} to {}\n", SECONDARY_PRESENCE_EP, to);
+                g_Sensors[1].ChangeMinDistance(to);
+                return ESP_OK;
+            }
+        >{},
+        AttrDescr<SecondarySensorAttributes::Mode_t, 
+            [](const LD2412::SystemMode &to, const auto *message)->esp_err_t
+            {
+                FMT_PRINT("Changing system mode of ep {} to {}\n", SECONDARY_PRESENCE_EP, to);
+                g_Sensors[1].ChangeMode(to);
+                return ESP_OK;
+            }
+        >{},
+#endif
         {}//last one
     };
 
@@ -4,6 +4,8 @@
 #include "zb_dev_def_const.hpp"
 #include "../device_common.hpp"
 #include "../periph/ld2412_component.hpp"
+#include "zb_boot_timeline.hpp"
+#include "zb_attr_batch.hpp"
 
 namespace zb
 {
@@ -13,33 +15,53 @@ namespace zb
         Failed = 0x81,
     };
     struct SensitivityBufType: ZigbeeOctetBuf<14> { SensitivityBufType(){sz=14;} };
-    struct EnergyBufType: ZigbeeOctetBuf<14> { EnergyBufType(){sz=14;} };
+    //per zone: first gate, last gate, move threshold, still threshold
+    struct ZonesBufType: ZigbeeOctetBuf<ld2412::Component::kMaxZones * 4> { ZonesBufType(){sz=ld2412::Component::kMaxZones * 4;} };
+    //One page of the tracked binds, selected by ATTRIB_BIND_DELIVERY_STATS_PAGE, so that
+    //the attribute fits a single unfragmented frame whatever kMaxBinds is.
+    //Header: index of the first bind of the page, tracked binds, max binds, memory per bind (uint16 LE)
+    //per tracked bind: short addr, sent, failed, retries, avg latency ms, max latency ms (all uint16 LE)
+    static constexpr size_t kBindDeliveryStatsHeader = 5;
+    static constexpr size_t kBindDeliveryStatsRecord = 12;
+    static constexpr size_t kBindDeliveryStatsPerPage = 4;
+    static constexpr size_t kBindDeliveryStatsPages = (kMaxBinds + kBindDeliveryStatsPerPage - 1) / kBindDeliveryStatsPerPage;
+    static constexpr size_t kBindDeliveryStatsSize = kBindDeliveryStatsHeader + kBindDeliveryStatsPerPage * kBindDeliveryStatsRecord;
+    static_assert(kBindDeliveryStatsSize <= 254, "delivery stats don't fit into an octet string");
+    static_assert(kBindDeliveryStatsSize <= 64, "a delivery stats page doesn't fit into a single frame");
+    struct BindDeliveryStatsBufType: ZigbeeOctetBuf<kBindDeliveryStatsSize> { BindDeliveryStatsBufType(){sz=0;} };
+    //config changes, file writes, bytes written, failed writes (all uint32 LE)
+    struct ConfigWriteStatsBufType: ZigbeeOctetBuf<16> { ConfigWriteStatsBufType(){sz=16;} };
+    //see BootTimeline
+    static_assert(BootTimeline::kAttrSize < 255, "boot timeline doesn't fit into an octet string");
+    static_assert(BootTimeline::kAttrSize <= 64, "boot timeline doesn't fit into a single frame");
+    struct BootTimelineBufType: ZigbeeOctetBuf<BootTimeline::kAttrSize> { BootTimelineBufType(){sz=BootTimeline::kAttrSize;} };
+    //Engineering telemetry, all in one attribute:
+    //version, target state, move distance (uint16 LE), move energy, still distance (uint16 LE), still energy,
+    //encodings (uint16 LE, 2 bits per gate array: move, still, move min, still min, move max, still max),
+    //then every present gate array in that order.
+    //Gate array encodings:
+    // delta  : first gate value + 13 signed 4-bit deltas to the previous gate (8 bytes, lossless)
+    // 4 bit  : 14 values >> 3 (7 bytes), used when the deltas don't fit
+    //Nibbles are packed low first.
+    static constexpr uint8_t kEngineeringTelemetryVersion = 1;
+    static constexpr uint8_t kEngineeringTelemetryHeader = 10;
+    static constexpr uint8_t kEngineeringTelemetryArrays = 6;
+    enum class GateArrayEncoding: uint8_t { None = 0, Delta = 1, Nibbles = 2 };
+    struct EngineeringTelemetryBufType: ZigbeeOctetBuf<kEngineeringTelemetryHeader + kEngineeringTelemetryArrays * 8> { EngineeringTelemetryBufType(){sz=0;} };
 
     /**********************************************************************/
     /* Custom attributes IDs                                              */
     /**********************************************************************/
     static constexpr const uint16_t LD2412_ATTRIB_MOVE_SENSITIVITY = 0;
     static constexpr const uint16_t LD2412_ATTRIB_STILL_SENSITIVITY = 1;
-#if defined(ENABLE_ENGINEERING_ATTRIBUTES)
-    static constexpr const uint16_t LD2412_ATTRIB_MOVE_ENERGY = 2;
-    static constexpr const uint16_t LD2412_ATTRIB_STILL_ENERGY = 3;
-    static constexpr const uint16_t LD2412_ATTRIB_MOVE_DISTANCE = 4;
-    static constexpr const uint16_t LD2412_ATTRIB_STILL_DISTANCE = 5;
-#endif
+    //2..5 - were separate target distance/energy attributes, see ATTRIB_ENGINEERING_TELEMETRY
     static constexpr const uint16_t LD2412_ATTRIB_STATE = 6;
     static constexpr const uint16_t LD2412_ATTRIB_MIN_DISTANCE = 7;
     static constexpr const uint16_t LD2412_ATTRIB_MAX_DISTANCE = 8;
     static constexpr const uint16_t LD2412_ATTRIB_EX_STATE = 9;
     static constexpr const uint16_t LD2412_ATTRIB_MODE = 10;
     static constexpr const uint16_t LD2412_ATTRIB_ENGINEERING_LIGHT = 11;
-#if defined(ENABLE_ENGINEERING_ATTRIBUTES)
-    static constexpr const uint16_t LD2412_ATTRIB_ENGINEERING_ENERGY_MOVE = 12;
-    static constexpr const uint16_t LD2412_ATTRIB_ENGINEERING_ENERGY_STILL = 13;
-    static constexpr const uint16_t LD2412_ATTRIB_ENGINEERING_ENERGY_MOVE_MIN = 14;
-    static constexpr const uint16_t LD2412_ATTRIB_ENGINEERING_ENERGY_STILL_MIN = 15;
-    static constexpr const uint16_t LD2412_ATTRIB_ENGINEERING_ENERGY_MOVE_MAX = 16;
-    static constexpr const uint16_t LD2412_ATTRIB_ENGINEERING_ENERGY_STILL_MAX = 17;
-#endif
+    //12..17 - were separate gate energy attributes, see ATTRIB_ENGINEERING_TELEMETRY
     static constexpr const uint16_t LD2412_ATTRIB_PIR_PRESENCE = 18;
     static constexpr const uint16_t ON_OFF_COMMAND_MODE = 19;
     static constexpr const uint16_t ON_OFF_COMMAND_TIMEOUT = 20;
@@ -53,6 +75,27 @@ namespace zb
     static constexpr const uint16_t ATTRIB_INTERNALS = 30;
     static constexpr const uint16_t ATTRIB_RESTARTS_COUNT = 31;
     static constexpr const uint16_t ATTRIB_INTERNALS2 = 33;
+    static constexpr const uint16_t ATTRIB_REPORT_DISTANCE_DEADBAND = 34;
+    static constexpr const uint16_t ATTRIB_REPORT_DISTANCE_MIN_INTERVAL = 35;
+    static constexpr const uint16_t ATTRIB_REPORT_DISTANCE_MAX_INTERVAL = 36;
+    static constexpr const uint16_t ATTRIB_REPORT_ENERGY_DEADBAND = 37;
+    static constexpr const uint16_t ATTRIB_REPORT_ENERGY_MIN_INTERVAL = 38;
+    static constexpr const uint16_t ATTRIB_REPORT_ENERGY_MAX_INTERVAL = 39;
+    static constexpr const uint16_t ATTRIB_REPORT_ADAPTIVE = 40;
+    static constexpr const uint16_t ATTRIB_APPROACH_DISTANCE = 41;
+    static constexpr const uint16_t ATTRIB_APPROACH_SPEED = 42;
+    static constexpr const uint16_t ATTRIB_NOISE_FLOOR_TRACKING = 43;
+    static constexpr const uint16_t ATTRIB_NOISE_FLOOR_MAX_DELTA = 44;
+    static constexpr const uint16_t ATTRIB_ZONES_CONFIG = 45;
+    static constexpr const uint16_t ATTRIB_ZONES_OCCUPANCY = 46;
+    static constexpr const uint16_t ATTRIB_PER_BIND_DELIVERY = 47;
+    static constexpr const uint16_t ATTRIB_BIND_DELIVERY_STATS = 48;
+    static constexpr const uint16_t ATTRIB_ENGINEERING_TELEMETRY_ENABLED = 49;
+    static constexpr const uint16_t ATTRIB_ENGINEERING_TELEMETRY = 50;
+    static constexpr const uint16_t ATTRIB_ACTIVE_REPORTING_CHECK = 51;
+    static constexpr const uint16_t ATTRIB_CONFIG_WRITE_STATS = 52;
+    static constexpr const uint16_t ATTRIB_BOOT_TIMELINE = 53;
+    static constexpr const uint16_t ATTRIB_BIND_DELIVERY_STATS_PAGE = 54;
 
     /**********************************************************************/
     /* Cluster type definitions                                           */
@@ -96,18 +139,108 @@ namespace zb
     using ZclAttributeInternals2_t                            = LD2412CustomCluster_t::Attribute<ATTRIB_INTERNALS2, uint32_t>;
     using ZclAttributeArmedForTrigger_t                       = LD2412CustomCluster_t::Attribute<ATTRIB_ARMED_FOR_TRIGGER, bool>;
     using ZclAttributeInternals3_t                            = LD2412CustomCluster_t::Attribute<ATTRIB_INTERNALS3, uint32_t>;
+    using ZclAttributeReportDistanceDeadband_t                = LD2412CustomCluster_t::Attribute<ATTRIB_REPORT_DISTANCE_DEADBAND, uint16_t>;
+    using ZclAttributeReportDistanceMinInterval_t             = LD2412CustomCluster_t::Attribute<ATTRIB_REPORT_DISTANCE_MIN_INTERVAL, uint16_t>;
+    using ZclAttributeReportDistanceMaxInterval_t             = LD2412CustomCluster_t::Attribute<ATTRIB_REPORT_DISTANCE_MAX_INTERVAL, uint16_t>;
+    using ZclAttributeReportEnergyDeadband_t                  = LD2412CustomCluster_t::Attribute<ATTRIB_REPORT_ENERGY_DEADBAND, uint16_t>;
+    using ZclAttributeReportEnergyMinInterval_t               = LD2412CustomCluster_t::Attribute<ATTRIB_REPORT_ENERGY_MIN_INTERVAL, uint16_t>;
+    using ZclAttributeReportEnergyMaxInterval_t               = LD2412CustomCluster_t::Attribute<ATTRIB_REPORT_ENERGY_MAX_INTERVAL, uint16_t>;
+    using ZclAttributeReportAdaptive_t                        = LD2412CustomCluster_t::Attribute<ATTRIB_REPORT_ADAPTIVE, bool>;
+    using ZclAttributeApproachDistance_t                      = LD2412CustomCluster_t::Attribute<ATTRIB_APPROACH_DISTANCE, uint16_t>;
+    using ZclAttributeApproachSpeed_t                         = LD2412CustomCluster_t::Attribute<ATTRIB_APPROACH_SPEED, int16_t>;
+    using ZclAttributeNoiseFloorTracking_t                    = LD2412CustomCluster_t::Attribute<ATTRIB_NOISE_FLOOR_TRACKING, bool>;
+    using ZclAttributeNoiseFloorMaxDelta_t                    = LD2412CustomCluster_t::Attribute<ATTRIB_NOISE_FLOOR_MAX_DELTA, uint8_t>;
+    using ZclAttributeZonesConfig_t                           = LD2412CustomCluster_t::Attribute<ATTRIB_ZONES_CONFIG, ZonesBufType>;
+    using ZclAttributeZonesOccupancy_t                        = LD2412CustomCluster_t::Attribute<ATTRIB_ZONES_OCCUPANCY, uint8_t>;
+    using ZclAttributePerBindDelivery_t                       = LD2412CustomCluster_t::Attribute<ATTRIB_PER_BIND_DELIVERY, bool>;
+    using ZclAttributeBindDeliveryStats_t                     = LD2412CustomCluster_t::Attribute<ATTRIB_BIND_DELIVERY_STATS, BindDeliveryStatsBufType>;
+    using ZclAttributeEngineeringTelemetryEnabled_t           = LD2412CustomCluster_t::Attribute<ATTRIB_ENGINEERING_TELEMETRY_ENABLED, bool>;
+    using ZclAttributeEngineeringTelemetry_t                  = LD2412CustomCluster_t::Attribute<ATTRIB_ENGINEERING_TELEMETRY, EngineeringTelemetryBufType>;
+    using ZclAttributeActiveReportingCheck_t                  = LD2412CustomCluster_t::Attribute<ATTRIB_ACTIVE_REPORTING_CHECK, bool>;
+    using ZclAttributeConfigWriteStats_t                      = LD2412CustomCluster_t::Attribute<ATTRIB_CONFIG_WRITE_STATS, ConfigWriteStatsBufType>;
+    using ZclAttributeBootTimeline_t                          = LD2412CustomCluster_t::Attribute<ATTRIB_BOOT_TIMELINE, BootTimelineBufType>;
+    using ZclAttributeBindDeliveryStatsPage_t                 = LD2412CustomCluster_t::Attribute<ATTRIB_BIND_DELIVERY_STATS_PAGE, uint8_t>;
+
+
+    /**********************************************************************/
+    /* Default reporting of the reportable custom attributes              */
+    /**********************************************************************/
+    //Applied at registration. Whatever the coordinator configures later takes
+    //precedence and is kept by the stack across reboots.
+    struct ReportingDefaults
+    {
+        uint8_t m_Ep;
+        uint16_t m_AttrId;
+        uint16_t m_MinIntervalS;
+        uint16_t m_MaxIntervalS;     //0 - no periodic reports
+        uint32_t m_ReportableChange; //analog values only, in attribute units
+        uint8_t m_Size;              //of the value, for the reportable change; 0 - discrete
+    };
+    template<class T>
+    constexpr ReportingDefaults analog_reporting(uint16_t id, uint16_t minS, uint16_t maxS, uint32_t change, uint8_t ep = PRESENCE_EP)
+    {
+        return {.m_Ep = ep, .m_AttrId = id, .m_MinIntervalS = minS, .m_MaxIntervalS = maxS, .m_ReportableChange = change, .m_Size = sizeof(T)};
+    }
+    constexpr ReportingDefaults discrete_reporting(uint16_t id, uint16_t minS, uint16_t maxS, uint8_t ep = PRESENCE_EP)
+    {
+        return {.m_Ep = ep, .m_AttrId = id, .m_MinIntervalS = minS, .m_MaxIntervalS = maxS, .m_ReportableChange = 0, .m_Size = 0};
+    }
+
+    constexpr ReportingDefaults g_ReportingDefaults[] = {
+        discrete_reporting(LD2412_ATTRIB_STATE, 0, 3600),
+        discrete_reporting(LD2412_ATTRIB_EX_STATE, 0, 3600),
+        discrete_reporting(LD2412_ATTRIB_PIR_PRESENCE, 0, 3600),
+        analog_reporting<uint8_t>(LD2412_ATTRIB_ENGINEERING_LIGHT, 10, 600, 5),
+        discrete_reporting(ATTRIB_FAILURE_STATUS, 1, 3600),
+        discrete_reporting(ATTRIB_INTERNALS, 30, 3600),
+        discrete_reporting(ATTRIB_INTERNALS2, 30, 3600),
+        discrete_reporting(ATTRIB_INTERNALS3, 30, 3600),
+        analog_reporting<uint16_t>(ATTRIB_RESTARTS_COUNT, 60, 0, 1),
+        analog_reporting<int16_t>(ATTRIB_APPROACH_SPEED, 1, 0, 10),
+        discrete_reporting(ATTRIB_ZONES_OCCUPANCY, 0, 3600),
+        discrete_reporting(ATTRIB_ENGINEERING_TELEMETRY, 1, 0),
+#if defined(ENABLE_SECOND_SENSOR)
+        discrete_reporting(LD2412_ATTRIB_STATE, 0, 3600, SECONDARY_PRESENCE_EP),
+#endif
+    };
+
+    /**********************************************************************/
+    /* Per sensor attributes                                              */
+    /**********************************************************************/
+    //Subset of attributes every sensor endpoint has. For PRESENCE_EP these
+    //are the very same types as the ones above
+    template<uint8_t EP>
+    struct SensorAttributes
+    {
+        using OccupancyCluster_t = ZclServerCluster<EP, ESP_ZB_ZCL_CLUSTER_ID_OCCUPANCY_SENSING>;
+        using CustomCluster_t    = ZclServerCluster<EP, CLUSTER_ID_LD2412>;
 
-#if defined(ENABLE_ENGINEERING_ATTRIBUTES)
-    using ZclAttributeStillDistance_t                         = LD2412CustomCluster_t::Attribute<LD2412_ATTRIB_STILL_DISTANCE, uint16_t>;
-    using ZclAttributeMoveDistance_t                          = LD2412CustomCluster_t::Attribute<LD2412_ATTRIB_MOVE_DISTANCE, uint16_t>;
-    using ZclAttributeMoveEnergy_t                            = LD2412CustomCluster_t::Attribute<LD2412_ATTRIB_MOVE_ENERGY, uint8_t>;
-    using ZclAttributeStillEnergy_t                           = LD2412CustomCluster_t::Attribute<LD2412_ATTRIB_STILL_ENERGY, uint8_t>;
-    using ZclAttributeEngineeringEnergyStill_t                = LD2412CustomCluster_t::Attribute<LD2412_ATTRIB_ENGINEERING_ENERGY_STILL, EnergyBufType>;
-    using ZclAttributeEngineeringEnergyMove_t                 = LD2412CustomCluster_t::Attribute<LD2412_ATTRIB_ENGINEERING_ENERGY_MOVE, EnergyBufType>;
-    using ZclAttributeEngineeringEnergyStillMin_t             = LD2412CustomCluster_t::Attribute<LD2412_ATTRIB_ENGINEERING_ENERGY_STILL_MIN, EnergyBufType>;
-    using ZclAttributeEngineeringEnergyMoveMin_t              = LD2412CustomCluster_t::Attribute<LD2412_ATTRIB_ENGINEERING_ENERGY_MOVE_MIN, EnergyBufType>;
-    using ZclAttributeEngineeringEnergyStillMax_t             = LD2412CustomCluster_t::Attribute<LD2412_ATTRIB_ENGINEERING_ENERGY_STILL_MAX, EnergyBufType>;
-    using ZclAttributeEngineeringEnergyMoveMax_t              = LD2412CustomCluster_t::Attribute<LD2412_ATTRIB_ENGINEERING_ENERGY_MOVE_MAX, EnergyBufType>;
+        using Occupancy_t        = typename OccupancyCluster_t::template Attribute<ESP_ZB_ZCL_ATTR_OCCUPANCY_SENSING_OCCUPANCY_ID, esp_zb_zcl_occupancy_sensing_occupancy_t>;
+        using State_t            = typename CustomCluster_t::template Attribute<LD2412_ATTRIB_STATE , LD2412State>;
+        using MoveSensitivity_t  = typename CustomCluster_t::template Attribute<LD2412_ATTRIB_MOVE_SENSITIVITY, SensitivityBufType>;
+        using StillSensitivity_t = typename CustomCluster_t::template Attribute<LD2412_ATTRIB_STILL_SENSITIVITY, SensitivityBufType>;
+        using MinDistance_t      = typename CustomCluster_t::template Attribute<LD2412_ATTRIB_MIN_DISTANCE, uint16_t>;
+        using MaxDistance_t      = typename CustomCluster_t::template Attribute<LD2412_ATTRIB_MAX_DISTANCE, uint16_t>;
+        using Mode_t             = typename CustomCluster_t::template Attribute<LD2412_ATTRIB_MODE, LD2412::SystemMode>;
+
+        static constexpr Occupancy_t        g_Occupancy{};
+        static constexpr State_t            g_State{};
+        static constexpr MoveSensitivity_t  g_MoveSensitivity{};
+        static constexpr StillSensitivity_t g_StillSensitivity{};
+        static constexpr MinDistance_t      g_MinDistance{};
+        static constexpr MaxDistance_t      g_MaxDistance{};
+        static constexpr Mode_t             g_Mode{};
+    };
+    using SecondarySensorAttributes = SensorAttributes<SECONDARY_PRESENCE_EP>;
+
+    //Discrete attributes that change together on a presence change: a batch
+    //reports the dirty ones in a single Report Attributes command (see AttrBatch).
+    //Analog ones stay with the stack, it respects their reportable change
+    BATCH_REPORTED(ZclAttributeState_t, PRESENCE_EP, CLUSTER_ID_LD2412, LD2412_ATTRIB_STATE);
+    BATCH_REPORTED(ZclAttributeExState_t, PRESENCE_EP, CLUSTER_ID_LD2412, LD2412_ATTRIB_EX_STATE);
+    BATCH_REPORTED(ZclAttributePIRPresence_t, PRESENCE_EP, CLUSTER_ID_LD2412, LD2412_ATTRIB_PIR_PRESENCE);
+#if defined(ENABLE_SECOND_SENSOR)
+    BATCH_REPORTED(SecondarySensorAttributes::State_t, SECONDARY_PRESENCE_EP, CLUSTER_ID_LD2412, LD2412_ATTRIB_STATE);
 #endif
 
     /**********************************************************************/
@@ -147,18 +280,26 @@ namespace zb
     constexpr ZclAttributeInternals2_t                            g_Internals2{};
     constexpr ZclAttributeArmedForTrigger_t                       g_ArmedForTrigger{};
     constexpr ZclAttributeInternals3_t                            g_Internals3{};
-
-#if defined(ENABLE_ENGINEERING_ATTRIBUTES)
-    constexpr ZclAttributeStillDistance_t                         g_LD2412StillDistance{};
-    constexpr ZclAttributeMoveDistance_t                          g_LD2412MoveDistance{};
-    constexpr ZclAttributeStillEnergy_t                           g_LD2412StillEnergy{};
-    constexpr ZclAttributeMoveEnergy_t                            g_LD2412MoveEnergy{};
-    constexpr ZclAttributeEngineeringEnergyMove_t                 g_LD2412EngineeringEnergyMove{};
-    constexpr ZclAttributeEngineeringEnergyStill_t                g_LD2412EngineeringEnergyStill{};
-    constexpr ZclAttributeEngineeringEnergyMoveMin_t              g_LD2412EngineeringEnergyMoveMin{};
-    constexpr ZclAttributeEngineeringEnergyStillMin_t             g_LD2412EngineeringEnergyStillMin{};
-    constexpr ZclAttributeEngineeringEnergyMoveMax_t              g_LD2412EngineeringEnergyMoveMax{};
-    constexpr ZclAttributeEngineeringEnergyStillMax_t             g_LD2412EngineeringEnergyStillMax{};
-#endif
+    constexpr ZclAttributeReportDistanceDeadband_t                g_ReportDistanceDeadband{};
+    constexpr ZclAttributeReportDistanceMinInterval_t             g_ReportDistanceMinInterval{};
+    constexpr ZclAttributeReportDistanceMaxInterval_t             g_ReportDistanceMaxInterval{};
+    constexpr ZclAttributeReportEnergyDeadband_t                  g_ReportEnergyDeadband{};
+    constexpr ZclAttributeReportEnergyMinInterval_t               g_ReportEnergyMinInterval{};
+    constexpr ZclAttributeReportEnergyMaxInterval_t               g_ReportEnergyMaxInterval{};
+    constexpr ZclAttributeReportAdaptive_t                        g_ReportAdaptive{};
+    constexpr ZclAttributeApproachDistance_t                      g_ApproachDistance{};
+    constexpr ZclAttributeApproachSpeed_t                         g_ApproachSpeed{};
+    constexpr ZclAttributeNoiseFloorTracking_t                    g_NoiseFloorTracking{};
+    constexpr ZclAttributeNoiseFloorMaxDelta_t                    g_NoiseFloorMaxDelta{};
+    constexpr ZclAttributeZonesConfig_t                           g_ZonesConfig{};
+    constexpr ZclAttributeZonesOccupancy_t                        g_ZonesOccupancy{};
+    constexpr ZclAttributePerBindDelivery_t                       g_PerBindDelivery{};
+    constexpr ZclAttributeBindDeliveryStats_t                     g_BindDeliveryStats{};
+    constexpr ZclAttributeEngineeringTelemetryEnabled_t           g_EngineeringTelemetryEnabled{};
+    constexpr ZclAttributeEngineeringTelemetry_t                  g_EngineeringTelemetry{};
+    constexpr ZclAttributeActiveReportingCheck_t                  g_ActiveReportingCheck{};
+    constexpr ZclAttributeConfigWriteStats_t                      g_ConfigWriteStats{};
+    constexpr ZclAttributeBootTimeline_t                          g_BootTimeline{};
+    constexpr ZclAttributeBindDeliveryStatsPage_t                 g_BindDeliveryStatsPage{};
 }
 #endif
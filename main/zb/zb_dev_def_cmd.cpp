@@ -1,5 +1,6 @@
 #include "zb_dev_def_cmd.hpp"
 #include "zb_dev_def.hpp"
+#include "zb_sensor_mailbox.hpp"
 
 namespace zb
 {
@@ -45,6 +46,93 @@ namespace zb
                 i->m_CheckReporting = true;
         }
         g_State.m_NeedBindsChecking = true;
+        g_State.RequestService();
+        return ESP_OK;
+    }
+
+    std::optional<ConfigSnapshotRequest> ConfigSnapshotRequest::from(const esp_zb_zcl_custom_cluster_command_message_t *message)
+    {
+        if (message->info.src_address.addr_type != ESP_ZB_ZCL_ADDR_TYPE_SHORT)
+            return std::nullopt;
+        return ConfigSnapshotRequest{.m_SrcAddr = message->info.src_address.u.short_addr, .m_SrcEp = message->info.src_endpoint};
+    }
+
+    static void send_config_snapshot_page(ConfigSnapshotRequest const& r, ConfigSnapshotBufType &buf)
+    {
+        esp_zb_zcl_custom_cluster_cmd_req_t req{};
+        req.zcl_basic_cmd.dst_addr_u.addr_short = r.m_SrcAddr;
+        req.zcl_basic_cmd.dst_endpoint = r.m_SrcEp;
+        req.zcl_basic_cmd.src_endpoint = PRESENCE_EP;
+        req.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+        req.profile_id = ESP_ZB_AF_HA_PROFILE_ID;
+        req.cluster_id = CLUSTER_ID_LD2412;
+        req.custom_cmd_id = CMD_CONFIG_SNAPSHOT_RESP;
+        req.direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI;
+        req.data.type = ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING;
+        req.data.size = buf.sz;
+        req.data.value = &buf;
+        esp_zb_zcl_custom_cluster_cmd_req(&req);
+    }
+
+    esp_err_t cmd_config_snapshot(ConfigSnapshotRequest const& r)
+    {
+        FMT_PRINT("Config snapshot requested by {:x} ep {}\n", r.m_SrcAddr, r.m_SrcEp);
+        SensorMailbox::ConfigSnapshot sensor;
+        g_SensorMailbox.GetConfig(0, sensor);
+        ConfigSnapshotBufType buf;
+        auto put = [&](auto v){ std::memcpy(&buf.data[buf.sz], &v, sizeof(v)); buf.sz += sizeof(v); };
+        auto start_page = [&](uint8_t page){
+            buf.sz = 0;
+            put(kConfigSnapshotVersion);
+            put(page);
+            put(kConfigSnapshotPages);
+        };
+
+        start_page(0);
+        put(uint8_t(g_State.m_LastLD2412State));
+        put(uint8_t(g_State.m_LastLD2412ExtendedState));
+        put(uint8_t(g_State.m_LastPresence));
+        put(uint8_t(g_State.m_LastPresencePIRInternal));
+        put(uint8_t(g_State.m_TriggerAllowed));
+        put(uint8_t(sensor.m_Mode));
+        put(uint8_t(sensor.m_DistanceRes));
+        put(uint16_t(sensor.m_MinDistance));
+        put(uint16_t(sensor.m_MaxDistance));
+        put(uint16_t(sensor.m_Timeout));
+        put(uint8_t(g_Config.GetOnOffMode()));
+        put(uint16_t(g_Config.GetOnOffTimeout()));
+        put(uint8_t(g_Config.GetIlluminanceThreshold()));
+        put(uint8_t(g_Config.GetPresenceDetectionMode().m_Raw));
+        put(uint16_t(g_Config.GetExternalOnOffTimeout()));
+        put(uint8_t(g_State.GetIlluminance()));
+        put(uint16_t(g_Config.GetApproachDistance()));
+        put(uint8_t(g_Config.GetNoiseFloor().m_Enabled));
+        put(uint8_t(g_Config.GetNoiseFloor().m_MaxDelta));
+        put(uint8_t(g_Config.GetPerBindDelivery()));
+        put(uint8_t(g_Config.GetActiveReportingCheck()));
+        auto const& policy = g_Config.GetReportPolicy();
+        for(auto const& f : {policy.m_Distance, policy.m_Energy})
+        {
+            put(uint16_t(f.m_Deadband));
+            put(uint16_t(f.m_MinIntervalMs));
+            put(uint16_t(f.m_MaxIntervalS));
+        }
+        put(uint8_t(policy.m_Adaptive));
+        send_config_snapshot_page(r, buf);
+
+        start_page(1);
+        for(uint8_t i = 0; i < 14; ++i)
+            put(sensor.m_MoveThreshold[i]);
+        for(uint8_t i = 0; i < 14; ++i)
+            put(sensor.m_StillThreshold[i]);
+        for(auto const& z : g_Config.GetZones().m_Zones)
+        {
+            put(z.m_FirstGate);
+            put(z.m_LastGate);
+            put(z.m_MoveThreshold);
+            put(z.m_StillThreshold);
+        }
+        send_config_snapshot_page(r, buf);
         return ESP_OK;
     }
 
@@ -54,6 +142,7 @@ namespace zb
         CmdDescr<PRESENCE_EP, CLUSTER_ID_LD2412, LD2412_CMD_RESET_ENERGY_STAT, &ld2412_cmd_reset_energy_stat>{},
         CmdDescr<PRESENCE_EP, CLUSTER_ID_LD2412, LD2412_CMD_BLUETOOTH, &ld2412_cmd_switch_bluetooth, bool>{},
         CmdDescr<PRESENCE_EP, CLUSTER_ID_LD2412, CMD_RECHECK_BINDS, &cmd_recheck_binds>{},
+        CmdDescr<PRESENCE_EP, CLUSTER_ID_LD2412, CMD_CONFIG_SNAPSHOT, &cmd_config_snapshot, ConfigSnapshotRequest>{},
         CmdDescr<PRESENCE_EP, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_CMD_ON_OFF_ON_ID, &cmd_on_off_external_on>{},
         CmdDescr<PRESENCE_EP, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_CMD_ON_OFF_OFF_ID, &cmd_on_off_external_off>{},
         CmdDescr<PRESENCE_EP, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_CMD_ON_OFF_ON_WITH_TIMED_OFF_ID, &cmd_on_off_external_on_with_timed_off, OnWithTimedOffPayload>{},
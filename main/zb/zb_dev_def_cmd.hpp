@@ -2,6 +2,9 @@
 #define ZB_DEV_DEF_CMD_HPP_
 
 #include "zb_dev_def_const.hpp"
+#include "../periph/ld2412_component.hpp"
+#include <optional>
+#include <algorithm>
 
 namespace zb
 {
@@ -13,6 +16,41 @@ namespace zb
     static constexpr const uint8_t LD2412_CMD_RESET_ENERGY_STAT = 2;
     static constexpr const uint8_t LD2412_CMD_BLUETOOTH = 3;
     static constexpr const uint8_t CMD_RECHECK_BINDS = 4;
+    static constexpr const uint8_t CMD_CONFIG_SNAPSHOT = 5;
+
+    //server -> client
+    static constexpr const uint8_t CMD_CONFIG_SNAPSHOT_RESP = 0;
+
+    /**********************************************************************/
+    /* Payloads                                                           */
+    /**********************************************************************/
+    //no payload, just who to send the snapshot to
+    struct ConfigSnapshotRequest
+    {
+        uint16_t m_SrcAddr;
+        uint8_t m_SrcEp;
+        static std::optional<ConfigSnapshotRequest> from(const esp_zb_zcl_custom_cluster_command_message_t *message);
+    };
+
+    //Configuration and state of the device in one request, answered with
+    //kConfigSnapshotPages responses so that each fits a single frame (all LE).
+    //Every page: version, page index, page count, then
+    //page 0: state, extended state, occupancy, PIR presence, armed for trigger,
+    //system mode, distance resolution, min distance (u16), max distance (u16), presence timeout (u16),
+    //on-off mode, on-off timeout (u16), illuminance threshold, presence detection config,
+    //external on time (u16), measured light, approach distance (u16),
+    //noise floor tracking, noise floor max delta, per bind delivery, active reporting check,
+    //report policy: distance deadband, min interval ms, max interval s, energy deadband,
+    //min interval ms, max interval s (all u16), adaptive
+    //page 1: move sensitivity (14), still sensitivity (14), zones config (4 per zone)
+    static constexpr uint8_t kConfigSnapshotVersion = 4;
+    static constexpr uint8_t kConfigSnapshotPages = 2;
+    static constexpr uint8_t kConfigSnapshotHeader = 3;
+    static constexpr uint8_t kConfigSnapshotPage0 = 26 + 1 + 6 * 2 + 1;
+    static constexpr uint8_t kConfigSnapshotPage1 = 14 * 2 + ld2412::Component::kMaxZones * 4;
+    static constexpr uint8_t kConfigSnapshotSize = kConfigSnapshotHeader + std::max(kConfigSnapshotPage0, kConfigSnapshotPage1);
+    static_assert(kConfigSnapshotSize <= 64, "a config snapshot page doesn't fit into a single frame");
+    struct ConfigSnapshotBufType: ZigbeeOctetBuf<kConfigSnapshotSize> { ConfigSnapshotBufType(){sz=0;} };
 
     /**********************************************************************/
     /* Commands                                                           */
@@ -22,5 +60,6 @@ namespace zb
     esp_err_t ld2412_cmd_reset_energy_stat();
     esp_err_t ld2412_cmd_switch_bluetooth(bool on);
     esp_err_t cmd_recheck_binds();
+    esp_err_t cmd_config_snapshot(ConfigSnapshotRequest const& r);
 }
 #endif
@@ -1,15 +1,35 @@
 #ifndef ZB_DEV_DEF_CONST_HPP_
 #define ZB_DEV_DEF_CONST_HPP_
 
+#include <type_traits>
 #include "zbh_helpers.hpp"
 
-//#define ENABLE_ENGINEERING_ATTRIBUTES
+//#define ENABLE_SECOND_SENSOR
+
+//max number of bound devices (group binds are tracked separately)
+#if !defined(MAX_BINDS)
+#define MAX_BINDS 6
+#endif
 
 namespace zb
 {
     constexpr uint8_t PRESENCE_EP = 1;
+    constexpr uint8_t SECONDARY_PRESENCE_EP = 2;
+#if defined(ENABLE_SECOND_SENSOR)
+    constexpr size_t kSensorCount = 2;
+#else
+    constexpr size_t kSensorCount = 1;
+#endif
     static constexpr const uint16_t CLUSTER_ID_LD2412 = kManufactureSpecificCluster;
     constexpr uint32_t kDelayedAttrChangeTimeout = 200;
     constexpr uint32_t kExternalTriggerCmdDelay = 50;
+    constexpr size_t kMaxBinds = MAX_BINDS;
+    static_assert(kMaxBinds > 0 && kMaxBinds <= 32, "bind masks are 32 bit at most");
+    //bit per bind
+    using BindMask = std::conditional_t<(kMaxBinds <= 8), uint8_t, std::conditional_t<(kMaxBinds <= 16), uint16_t, uint32_t>>;
+    constexpr BindMask kAllBinds = BindMask(~BindMask(0));
+    constexpr BindMask bind_bit(size_t i) { return BindMask(BindMask(1) << i); }
+    //bits of the first n binds. A shift by the full width would be UB
+    constexpr BindMask first_binds(size_t n) { return n >= sizeof(BindMask) * 8 ? kAllBinds : BindMask(bind_bit(n) - 1); }
 }
 #endif
@@ -1,4 +1,5 @@
 #include "zb_dev_def.hpp"
+#include "zb_attr_batch.hpp"
 #include "esp_check.h"
 
 namespace zb
@@ -25,10 +26,7 @@ namespace zb
                 if (g_Config.GetIlluminanceExternal())
                 {
                     g_State.m_ExternalIlluminance = (*pVal) >> 8;
-                    if (auto status = g_LD2412EngineeringLight.Set(g_State.m_ExternalIlluminance); !status)
-                    {
-                        FMT_PRINT("Failed to set measured light attribute with error {:x}\n", (int)status.error());
-                    }
+                    AttrBatch::Set(g_LD2412EngineeringLight, g_State.m_ExternalIlluminance, "measured light attribute");
                 }else
                 {
                     FMT_PRINT("Not configured to use external illuminance. Ignored\n");
@@ -60,12 +58,14 @@ namespace zb
                     }
                     size_t idx = bindIt - g_State.m_TrackedBinds.begin();
                     FMT_PRINT("Found a bind info at index {}\n", idx);
-                    if (g_State.m_ValidBinds & (1 << idx))
+                    if (g_State.m_ValidBinds & bind_bit(idx))
                     {
-                        g_State.m_BindStates &= ~(1 << idx);
+                        g_State.m_BindStates &= ~bind_bit(idx);
                         bool *pVal = (bool *)pReport->attribute.data.value;
                         FMT_PRINT("New state of the bind info: {}\n", *pVal);
-                        g_State.m_BindStates |= (int(*pVal) << idx);
+                        if (*pVal)
+                            g_State.m_BindStates |= bind_bit(idx);
+                        (*bindIt)->StateUpdated();
                         FMT_PRINT("New binds state: {:x}\n", g_State.m_BindStates);
 
                         if (!(g_State.m_BindStates & g_State.m_ValidBinds) && g_State.m_LastPresence)//we still have the presence
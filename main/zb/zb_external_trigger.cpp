@@ -1,13 +1,14 @@
 #include "zb_dev_def.hpp"
+#include "zb_attr_batch.hpp"
 
 namespace zb
 {
-    static ZbAlarmExt16 g_DelayedExternalUpdate;
+    static WheelTimerExt16 g_DelayedExternalUpdate;
 
     static void update_external_attributes()
     {
         //FMT_PRINT("update_external_attributes. ext to {}\n", (int)g_State.m_LastPresenceExternal);
-        g_ExternalOnOff.Set(g_State.m_LastPresenceExternal);
+        AttrBatch::Set(g_ExternalOnOff, g_State.m_LastPresenceExternal, "on/off state attribute");
         update_zb_occupancy_attr();
     };
 
@@ -26,10 +27,7 @@ namespace zb
         }else
         {
             //FMT_PRINT("on ext timeout no presence change. ext to {}\n", (int)g_State.m_LastPresenceExternal);
-            if (auto status = g_ExternalOnOff.Set(g_State.m_LastPresenceExternal); !status)
-            {
-                FMT_PRINT("Failed to set on/off state attribute with error {:x}\n", (int)status.error());
-            }
+            AttrBatch::Set(g_ExternalOnOff, g_State.m_LastPresenceExternal, "on/off state attribute");
         }
     }
 
@@ -53,7 +51,7 @@ namespace zb
             }, kExternalTriggerCmdDelay);
         }else
         {
-            g_ExternalOnOff.Set(g_State.m_LastPresenceExternal);
+            AttrBatch::Set(g_ExternalOnOff, g_State.m_LastPresenceExternal, "on/off state attribute");
         }
         return ESP_OK;
     }
@@ -73,7 +71,7 @@ namespace zb
                     }
             }, kExternalTriggerCmdDelay);
         }else
-            g_ExternalOnOff.Set(g_State.m_LastPresenceExternal);
+            AttrBatch::Set(g_ExternalOnOff, g_State.m_LastPresenceExternal, "on/off state attribute");
         return ESP_OK;
     }
 
@@ -113,7 +111,7 @@ namespace zb
                     }
             }, kExternalTriggerCmdDelay);
         }else
-            g_ExternalOnOff.Set(g_State.m_LastPresenceExternal);
+            AttrBatch::Set(g_ExternalOnOff, g_State.m_LastPresenceExternal, "on/off state attribute");
         return ESP_OK;
     }
 
@@ -143,7 +141,7 @@ namespace zb
                         }
                 }, kExternalTriggerCmdDelay);
             }else
-                g_ExternalOnOff.Set(g_State.m_LastPresenceExternal);
+                AttrBatch::Set(g_ExternalOnOff, g_State.m_LastPresenceExternal, "on/off state attribute");
         }
     }
 
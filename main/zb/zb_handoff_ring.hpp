@@ -0,0 +1,119 @@
+#ifndef ZB_HANDOFF_RING_HPP_
+#define ZB_HANDOFF_RING_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+//No ESP-IDF dependencies here on purpose: the sensor -> zigbee task handoff
+//primitives build on the host as is (see host_test).
+namespace zb
+{
+    //single writer, the reader retries until it gets a consistent copy
+    template<class T>
+    struct SeqLocked
+    {
+        void Write(T const& v)
+        {
+            const uint32_t seq = m_Seq.load(std::memory_order_relaxed);
+            m_Seq.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_Value = v;
+            m_Seq.store(seq + 2, std::memory_order_release);
+        }
+
+        void Read(T &dst) const
+        {
+            uint32_t s1, s2;
+            do
+            {
+                s1 = m_Seq.load(std::memory_order_acquire);
+                if (s1 & 1)
+                    continue;//writer in progress
+                dst = m_Value;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                s2 = m_Seq.load(std::memory_order_relaxed);
+            }while((s1 & 1) || (s1 != s2));
+        }
+    private:
+        T m_Value{};
+        std::atomic<uint32_t> m_Seq{0};
+    };
+
+    //Single producer/single consumer ring, every pushed item is seen in order.
+    //If the ring overflows the most recent item is kept in a seq-locked slot
+    //(and the ring is bypassed until the consumer takes it) so the consumer
+    //always converges to the latest state.
+    //Items are numbered by the producer and the consumer never goes back:
+    //ring entries that turn out to be older than a taken latest slot, or the
+    //same latest slot seen twice, are dropped.
+    template<class T, size_t N>
+    struct HandoffRing
+    {
+        static_assert((N & (N - 1)) == 0, "must be power of 2");
+
+        void Push(T const& v)
+        {
+            const Item item{v, ++m_Pushed};
+            const uint32_t head = m_Head.load(std::memory_order_relaxed);
+            const uint32_t tail = m_Tail.load(std::memory_order_acquire);
+            //once overflown everything goes to the latest slot until the consumer took it:
+            //the slot is read after the ring, so it must never be older than the ring content
+            if (!m_Overflow.load(std::memory_order_acquire) && (head - tail) < N)
+            {
+                m_Ring[head & (N - 1)] = item;
+                m_Head.store(head + 1, std::memory_order_release);
+            }
+            else
+            {
+                //consumer lags behind: keep only the latest state
+                m_Latest.Write(item);
+                //after the write: if the consumer cleared the flag meanwhile it comes back for this one
+                m_Overflow.store(true, std::memory_order_release);
+            }
+        }
+
+        bool Pop(T &dst)
+        {
+            Item item;
+            while(true)
+            {
+                const uint32_t tail = m_Tail.load(std::memory_order_relaxed);
+                const uint32_t head = m_Head.load(std::memory_order_acquire);
+                if (tail != head)
+                {
+                    item = m_Ring[tail & (N - 1)];
+                    m_Tail.store(tail + 1, std::memory_order_release);
+                }
+                else if (m_Overflow.exchange(false, std::memory_order_acq_rel))
+                    m_Latest.Read(item);
+                else
+                    return false;
+
+                //the ring may have been filled up behind an older 'head' before the latest slot was taken
+                if (int32_t(item.m_Idx - m_Taken) > 0)
+                {
+                    m_Taken = item.m_Idx;
+                    dst = item.m_Value;
+                    return true;
+                }
+            }
+        }
+    private:
+        struct Item
+        {
+            T m_Value;
+            uint32_t m_Idx;
+        };
+
+        Item m_Ring[N];
+        std::atomic<uint32_t> m_Head{0};//written by producer
+        std::atomic<uint32_t> m_Tail{0};//written by consumer
+
+        SeqLocked<Item> m_Latest;
+        std::atomic<bool> m_Overflow{false};
+        uint32_t m_Pushed = 0;//producer only
+        uint32_t m_Taken = 0;//consumer only
+    };
+}
+#endif
@@ -12,6 +12,7 @@
 #include "../colors_def.hpp"
 
 #include "zb_dev_def.hpp"
+#include "zb_attr_batch.hpp"
 
 
 namespace zb
@@ -20,7 +21,25 @@ namespace zb
     /* Bind/Unbind tracking                                               */
     /**********************************************************************/
     BindUnbind_Handler g_OnOffBindUnbindRequestTracker{
-        .cb = [](APSME_Commands cmd, APSME_BindUnbindReq &r) { g_State.m_NeedBindsChecking = true; },
+        .cb = [](APSME_Commands cmd, APSME_BindUnbindReq &r) {
+            //only binds of our own endpoint are of interest, anything unexpected gets a full scan
+            esp_zb_ieee_addr_t ownIeee;
+            esp_zb_get_long_address(ownIeee);
+            const bool bind = cmd == APSME_Commands::Bind;
+            bool applied = false;
+            if (std::memcmp(r.src_addr, ownIeee, sizeof(ownIeee)) == 0 && r.src_endpoint == PRESENCE_EP)
+            {
+                if (r.addr_mode == ESP_ZB_ZDO_BIND_DST_ADDR_MODE_16_BIT_GROUP)
+                    applied = g_State.ApplyGroupBindDelta(bind, r.dst_addr.addr_short);
+                else if (r.addr_mode == ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED)
+                    applied = g_State.ApplyBindDelta(bind, r.dst_addr.addr_long, r.dst_endpoint);
+            }
+            if (!applied)
+            {
+                g_State.m_NeedBindsChecking = true;
+                g_State.RequestService();
+            }
+        },
         .cluster_id = ESP_ZB_ZCL_CLUSTER_ID_ON_OFF
     };
 
@@ -78,6 +97,8 @@ namespace zb
                 led::blink(false, {});
                 //async setup
                 InitHelpers();
+                BootTimeline::Mark(BootTimeline::Phase::StackReady);
+                BootTimeline::Start();
                 thread::start_task({.pName="LD2412_Setup", .stackSize = 2*4096}, &setup_sensor).detach();
                 g_State.RunService();
 
@@ -87,6 +108,7 @@ namespace zb
                     esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_STEERING);
                 } else {
                     ESP_LOGI(TAG, "Device rebooted");
+                    BootTimeline::Mark(BootTimeline::Phase::Joined);
                     esp_zb_ieee_address_by_short(/*coordinator*/uint16_t(0), g_State.m_CoordinatorIeee);
                 }
             } else {
@@ -136,10 +158,18 @@ namespace zb
                 g_State.m_Internals.m_LastIndicationStatus = *(uint8_t *)pParam;
                 uint16_t addr = *((uint8_t *)pParam + 1) | ((*((uint8_t *)pParam + 2)) << 8);
                 ESP_LOGW(TAG, "%s, status: 0x%x; addr: 0x%x\n", esp_zb_zdo_signal_to_string(sig_type), g_State.m_Internals.m_LastIndicationStatus, addr);
+                g_State.InternalsChanged();
+            }
+            break;
+        case ESP_ZB_ZDO_SIGNAL_DEVICE_ANNCE:
+            {
+                auto *pAnnce = (esp_zb_zdo_signal_device_annce_params_t *)esp_zb_app_signal_get_params(p_sg_p);
+                g_State.DeviceAnnounced(pAnnce->ieee_addr);
             }
             break;
         case ESP_ZB_ZDO_DEVICE_UNAVAILABLE:
             ++g_State.m_Internals.m_DeviceUnavailable;
+            g_State.InternalsChanged();
             inc_failure("dev unavailable");
             led::blink_pattern(colors::kBlinkPatternZStackError, colors::kColorBlue, duration_ms_t(1000));
             break;
@@ -155,6 +185,7 @@ namespace zb
         case ESP_ZB_BDB_SIGNAL_STEERING:
             if (err_status == ESP_OK) {
                 reset_failure();
+                BootTimeline::Mark(BootTimeline::Phase::Joined);
                 led::blink(false, {});
                 esp_zb_ieee_addr_t extended_pan_id;
                 esp_zb_get_extended_pan_id(extended_pan_id);
@@ -210,18 +241,28 @@ namespace zb
         ESP_ERROR_CHECK(g_ArmedForTrigger.AddToCluster(custom_cluster, Access::RWP, true));
         ESP_ERROR_CHECK(g_Internals3.AddToCluster(custom_cluster, Access::Read | Access::Report));
 
-#if defined(ENABLE_ENGINEERING_ATTRIBUTES)
-        ESP_ERROR_CHECK(g_LD2412MoveDistance.AddToCluster(custom_cluster, Access::Read | Access::Report));
-        ESP_ERROR_CHECK(g_LD2412StillDistance.AddToCluster(custom_cluster, Access::Read | Access::Report));
-        ESP_ERROR_CHECK(g_LD2412MoveEnergy.AddToCluster(custom_cluster, Access::Read | Access::Report));
-        ESP_ERROR_CHECK(g_LD2412StillEnergy.AddToCluster(custom_cluster, Access::Read | Access::Report));
-        ESP_ERROR_CHECK(g_LD2412EngineeringEnergyStill.AddToCluster(custom_cluster, Access::Read));
-        ESP_ERROR_CHECK(g_LD2412EngineeringEnergyMove.AddToCluster(custom_cluster, Access::Read));
-        ESP_ERROR_CHECK(g_LD2412EngineeringEnergyMoveMin.AddToCluster(custom_cluster, Access::Read));
-        ESP_ERROR_CHECK(g_LD2412EngineeringEnergyStillMin.AddToCluster(custom_cluster, Access::Read));
-        ESP_ERROR_CHECK(g_LD2412EngineeringEnergyMoveMax.AddToCluster(custom_cluster, Access::Read));
-        ESP_ERROR_CHECK(g_LD2412EngineeringEnergyStillMax.AddToCluster(custom_cluster, Access::Read));
-#endif
+        auto const& reportPolicy = g_Config.GetReportPolicy();
+        ESP_ERROR_CHECK(g_ReportDistanceDeadband.AddToCluster(custom_cluster, Access::RW, reportPolicy.m_Distance.m_Deadband));
+        ESP_ERROR_CHECK(g_ReportDistanceMinInterval.AddToCluster(custom_cluster, Access::RW, reportPolicy.m_Distance.m_MinIntervalMs));
+        ESP_ERROR_CHECK(g_ReportDistanceMaxInterval.AddToCluster(custom_cluster, Access::RW, reportPolicy.m_Distance.m_MaxIntervalS));
+        ESP_ERROR_CHECK(g_ReportEnergyDeadband.AddToCluster(custom_cluster, Access::RW, reportPolicy.m_Energy.m_Deadband));
+        ESP_ERROR_CHECK(g_ReportEnergyMinInterval.AddToCluster(custom_cluster, Access::RW, reportPolicy.m_Energy.m_MinIntervalMs));
+        ESP_ERROR_CHECK(g_ReportEnergyMaxInterval.AddToCluster(custom_cluster, Access::RW, reportPolicy.m_Energy.m_MaxIntervalS));
+        ESP_ERROR_CHECK(g_ReportAdaptive.AddToCluster(custom_cluster, Access::RW, reportPolicy.m_Adaptive));
+        ESP_ERROR_CHECK(g_ApproachDistance.AddToCluster(custom_cluster, Access::RW, g_Config.GetApproachDistance()));
+        ESP_ERROR_CHECK(g_ApproachSpeed.AddToCluster(custom_cluster, Access::Read | Access::Report));
+        ESP_ERROR_CHECK(g_NoiseFloorTracking.AddToCluster(custom_cluster, Access::RW, g_Config.GetNoiseFloor().m_Enabled));
+        ESP_ERROR_CHECK(g_NoiseFloorMaxDelta.AddToCluster(custom_cluster, Access::RW, g_Config.GetNoiseFloor().m_MaxDelta));
+        ESP_ERROR_CHECK(g_ZonesConfig.AddToCluster(custom_cluster, Access::RW));
+        ESP_ERROR_CHECK(g_ZonesOccupancy.AddToCluster(custom_cluster, Access::Read | Access::Report));
+        ESP_ERROR_CHECK(g_PerBindDelivery.AddToCluster(custom_cluster, Access::RW, g_Config.GetPerBindDelivery()));
+        ESP_ERROR_CHECK(g_BindDeliveryStats.AddToCluster(custom_cluster, Access::Read));
+        ESP_ERROR_CHECK(g_BindDeliveryStatsPage.AddToCluster(custom_cluster, Access::RW, uint8_t(0)));
+        ESP_ERROR_CHECK(g_EngineeringTelemetryEnabled.AddToCluster(custom_cluster, Access::RW, false));
+        ESP_ERROR_CHECK(g_EngineeringTelemetry.AddToCluster(custom_cluster, Access::Read | Access::Report));
+        ESP_ERROR_CHECK(g_ActiveReportingCheck.AddToCluster(custom_cluster, Access::RW, g_Config.GetActiveReportingCheck()));
+        ESP_ERROR_CHECK(g_ConfigWriteStats.AddToCluster(custom_cluster, Access::Read));
+        ESP_ERROR_CHECK(g_BootTimeline.AddToCluster(custom_cluster, Access::Read));
 
         ESP_ERROR_CHECK(esp_zb_cluster_list_add_custom_cluster(cluster_list, custom_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
     }
@@ -334,6 +375,96 @@ namespace zb
     }
 
 
+#if defined(ENABLE_SECOND_SENSOR)
+    //additional sensor: occupancy + reduced custom cluster, no binding/trigger logic of its own
+    static void create_secondary_presence_ep(esp_zb_ep_list_t *ep_list, uint8_t ep_id)
+    {
+        using Attrs = SecondarySensorAttributes;
+        esp_zb_cluster_list_t *cluster_list = esp_zb_zcl_cluster_list_create();
+        {
+            esp_zb_basic_cluster_cfg_t basic_cfg = {
+                .zcl_version = ESP_ZB_ZCL_BASIC_ZCL_VERSION_DEFAULT_VALUE,                          
+                .power_source = 0x1,//mains                        
+            };
+            esp_zb_identify_cluster_cfg_t identify_cfg = {
+                .identify_time = ESP_ZB_ZCL_IDENTIFY_IDENTIFY_TIME_DEFAULT_VALUE,                   
+            };
+            ESP_ERROR_CHECK(esp_zb_cluster_list_add_basic_cluster(cluster_list, esp_zb_basic_cluster_create(&basic_cfg), ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+            ESP_ERROR_CHECK(esp_zb_cluster_list_add_identify_cluster(cluster_list, esp_zb_identify_cluster_create(&identify_cfg), ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+        }
+
+        {
+            esp_zb_occupancy_sensing_cluster_cfg_s presence_cfg =                                                                            
+            {                                                                                       
+                .occupancy = 0,
+                .sensor_type = ESP_ZB_ZCL_OCCUPANCY_SENSING_OCCUPANCY_SENSOR_TYPE_ULTRASONIC,
+                .sensor_type_bitmap = uint8_t(1) << ESP_ZB_ZCL_OCCUPANCY_SENSING_OCCUPANCY_SENSOR_TYPE_ULTRASONIC
+            };                                                                                      
+            ESP_ERROR_CHECK(esp_zb_cluster_list_add_occupancy_sensing_cluster(cluster_list, esp_zb_occupancy_sensing_cluster_create(&presence_cfg), ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+        }
+
+        {
+            esp_zb_attribute_list_t *custom_cluster = esp_zb_zcl_attr_list_create(CLUSTER_ID_LD2412);
+            ESP_ERROR_CHECK(Attrs::g_MoveSensitivity.AddToCluster(custom_cluster, Access::RW));
+            ESP_ERROR_CHECK(Attrs::g_StillSensitivity.AddToCluster(custom_cluster, Access::RW));
+            ESP_ERROR_CHECK(Attrs::g_State.AddToCluster(custom_cluster, Access::Read | Access::Report));
+            ESP_ERROR_CHECK(Attrs::g_MaxDistance.AddToCluster(custom_cluster, Access::RW));
+            ESP_ERROR_CHECK(Attrs::g_MinDistance.AddToCluster(custom_cluster, Access::RW));
+            ESP_ERROR_CHECK(Attrs::g_Mode.AddToCluster(custom_cluster, Access::RWP));
+            ESP_ERROR_CHECK(esp_zb_cluster_list_add_custom_cluster(cluster_list, custom_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+        }
+
+        esp_zb_endpoint_config_t endpoint_config = {
+            .endpoint = ep_id,
+            .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+            .app_device_id = ESP_ZB_HA_SIMPLE_SENSOR_DEVICE_ID,
+            .app_device_version = 0
+        };
+        esp_zb_ep_list_add_ep(ep_list, cluster_list, endpoint_config);
+    }
+#endif
+
+    /**********************************************************************/
+    /* Default reporting                                                  */
+    /**********************************************************************/
+    static void apply_reporting_defaults()
+    {
+        for(auto const& d : g_ReportingDefaults)
+        {
+            esp_zb_zcl_reporting_info_t info{};
+            info.direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV;
+            info.ep = d.m_Ep;
+            info.cluster_id = CLUSTER_ID_LD2412;
+            info.cluster_role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE;
+            info.attr_id = d.m_AttrId;
+            info.manuf_code = ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC;
+            info.dst.profile_id = ESP_ZB_AF_HA_PROFILE_ID;
+            info.u.send_info.min_interval = info.u.send_info.def_min_interval = d.m_MinIntervalS;
+            info.u.send_info.max_interval = info.u.send_info.def_max_interval = d.m_MaxIntervalS;
+            switch(d.m_Size)
+            {
+                case 1: info.u.send_info.delta.u8 = uint8_t(d.m_ReportableChange); break;
+                case 2: info.u.send_info.delta.u16 = uint16_t(d.m_ReportableChange); break;
+                case 4: info.u.send_info.delta.u32 = d.m_ReportableChange; break;
+                default: break;
+            }
+            if (auto e = esp_zb_zcl_update_reporting_info(&info); e != ESP_OK)
+            {
+                FMT_PRINT("Failed to set default reporting of attr {} on ep {} with error {:x}\n", d.m_AttrId, d.m_Ep, (int)e);
+            }
+        }
+    }
+
+    /**********************************************************************/
+    /* Attribute writes from the network                                  */
+    /**********************************************************************/
+    //the stack has already changed the value, attribute shadows can't be trusted anymore
+    static esp_err_t set_attr_value_shadowed_cb(const void *message)
+    {
+        AttrBatch::InvalidateShadows();
+        return set_attr_value_cb<g_AttributeHandlingDesc>(message);
+    }
+
     /**********************************************************************/
     /* Zigbee Task Entry Point                                            */
     /**********************************************************************/
@@ -353,12 +484,16 @@ namespace zb
             };
             esp_zb_init(&zb_nwk_cfg);
         }
+        BootTimeline::Mark(BootTimeline::Phase::ZbInit);
         ESP_LOGI(TAG, "ZB after init");
         fflush(stdout);
 
         //config clusters here
         esp_zb_ep_list_t *ep_list = esp_zb_ep_list_create();
         create_presence_ep(ep_list, PRESENCE_EP);
+#if defined(ENABLE_SECOND_SENSOR)
+        create_secondary_presence_ep(ep_list, SECONDARY_PRESENCE_EP);
+#endif
         ESP_LOGI(TAG, "ZB created ep");
         fflush(stdout);
 
@@ -374,7 +509,7 @@ namespace zb
                     ActionHandler{ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID, generic_node_list_handler<ReadAttrResponseNode>},
                     ActionHandler{ESP_ZB_CORE_REPORT_ATTR_CB_ID, report_attr_cb<g_ReportHandlingDesc>},
                     ActionHandler{ESP_ZB_CORE_CMD_IAS_ZONE_ZONE_STATUS_CHANGE_NOT_ID, ias_zone_state_change},
-                    ActionHandler{ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID, set_attr_value_cb<g_AttributeHandlingDesc>}
+                    ActionHandler{ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID, set_attr_value_shadowed_cb}
                 >
         );
 
@@ -382,9 +517,12 @@ namespace zb
         esp_zb_zcl_command_send_status_handler_register(&zb::ZbCmdSend::handler);
         setup_generic_absde_data_indication_handling();
         g_OnOffBindUnbindRequestTracker.Add();
+        BootTimeline::Mark(BootTimeline::Phase::DeviceRegistered);
         ESP_LOGI(TAG, "ZB registered device");
         fflush(stdout);
 
+        apply_reporting_defaults();
+        BindInfo::LogMemoryFootprint();
         ESP_LOGI(TAG, "ZB updated attribute reporting");
         fflush(stdout);
 
@@ -394,6 +532,7 @@ namespace zb
 
         led::blink(true, colors::kSteering);
         ESP_ERROR_CHECK(esp_zb_start(false));
+        BootTimeline::Mark(BootTimeline::Phase::ZbStarted);
         ESP_LOGI(TAG, "ZB started, looping...");
         esp_zb_stack_main_loop();
 
@@ -415,10 +554,14 @@ namespace zb
             .host_config = {.host_connection_mode = ZB_HOST_CONNECTION_MODE_NONE, .host_uart_config = {}},
         };
         ESP_ERROR_CHECK(nvs_flash_init());
+        BootTimeline::Mark(BootTimeline::Phase::NvsInit);
+        BootTimeline::Load();
         FMT_PRINT("nvs_flash_init done\n");
         ESP_ERROR_CHECK(esp_zb_platform_config(&config));
+        BootTimeline::Mark(BootTimeline::Phase::PlatformConfig);
         FMT_PRINT("esp_zb_platform_config done\n");
         ESP_ERROR_CHECK(g_Config.on_start());
+        BootTimeline::Mark(BootTimeline::Phase::ConfigLoaded);
         xTaskCreate(zigbee_main, "Zigbee_main", 2*4096, NULL, thread::kPrioDefault, NULL);
 
         reset_button_loop();
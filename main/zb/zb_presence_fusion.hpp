@@ -0,0 +1,190 @@
+#ifndef ZB_PRESENCE_FUSION_HPP_
+#define ZB_PRESENCE_FUSION_HPP_
+
+#include <cstdint>
+#include <cstddef>
+
+//No ESP-IDF dependencies here on purpose: the engine builds on the host as is
+//and can be fed with recorded event traces.
+namespace zb::fusion
+{
+    enum class Source: uint8_t
+    {
+        mmWave,
+        PIRInternal,
+        External,
+        Approach,//approaching target, keeps only for a short hold
+
+        Count
+    };
+    constexpr size_t kSources = size_t(Source::Count);
+
+    struct SourceRule
+    {
+        uint8_t m_EdgeWeight = 0;//contribution to the trigger score when active
+        uint8_t m_KeepWeight = 0;//contribution to the keep score when active
+        uint16_t m_HoldMs = 0;   //source stays active for the keep score for this long after it dropped
+    };
+
+    template<size_t N>
+    struct Rules
+    {
+        SourceRule m_Sources[N];
+        uint8_t m_EdgeThreshold = 1;//trigger when the edge score reaches it
+        uint8_t m_KeepThreshold = 1;//keep presence while the keep score reaches it
+
+        //disables edge/keep of the sources with the corresponding mask bit cleared
+        constexpr Rules Masked(uint32_t edgeMask, uint32_t keepMask) const
+        {
+            Rules r = *this;
+            for(size_t i = 0; i < N; ++i)
+            {
+                if (!(edgeMask & (1u << i))) r.m_Sources[i].m_EdgeWeight = 0;
+                if (!(keepMask & (1u << i))) r.m_Sources[i].m_KeepWeight = 0;
+            }
+            return r;
+        }
+    };
+
+    //an approach keeps the presence it triggered for this long after it ended:
+    //enough for the radar presence output or PIR to take over
+    constexpr uint16_t kApproachHoldMs = 3000;
+
+    //Weights of 1 and thresholds of 1 make both edge and keep a plain OR
+    constexpr Rules<kSources> kDefaultRules = {
+        .m_Sources = {
+            /*mmWave*/      {.m_EdgeWeight = 1, .m_KeepWeight = 1, .m_HoldMs = 0},
+            /*PIRInternal*/ {.m_EdgeWeight = 1, .m_KeepWeight = 1, .m_HoldMs = 0},
+            /*External*/    {.m_EdgeWeight = 1, .m_KeepWeight = 1, .m_HoldMs = 0},
+            /*Approach*/    {.m_EdgeWeight = 1, .m_KeepWeight = 1, .m_HoldMs = kApproachHoldMs},
+        },
+        .m_EdgeThreshold = 1,
+        .m_KeepThreshold = 1,
+    };
+
+    //Presence latch, owned by the caller
+    struct Latch
+    {
+        bool &m_Presence;
+        bool &m_FirstRun;
+        bool &m_TriggerAllowed;//a new edge is only accepted after presence was cleared (or re-armed)
+    };
+
+    template<size_t N>
+    struct Engine
+    {
+        struct Track
+        {
+            bool m_Active = false;
+            bool m_Dropped = false;//was active at least once
+            uint32_t m_DroppedAtMs = 0;
+        };
+        Track m_Tracks[N];
+
+        constexpr void Set(Source s, bool active, uint32_t nowMs) { Set(size_t(s), active, nowMs); }
+        constexpr void Set(size_t i, bool active, uint32_t nowMs)
+        {
+            auto &t = m_Tracks[i];
+            if (t.m_Active && !active)
+            {
+                t.m_Dropped = true;
+                t.m_DroppedAtMs = nowMs;
+            }
+            t.m_Active = active;
+        }
+
+        //returns 'true' if the presence has changed (or was re-triggered)
+        constexpr bool Evaluate(Rules<N> const& rules, Latch l, uint32_t nowMs) const
+        {
+            bool changed = false;
+            if (l.m_FirstRun || l.m_TriggerAllowed || !l.m_Presence)
+            {
+                //edge detection
+                uint32_t score = 0;
+                for(size_t i = 0; i < N; ++i)
+                    if (m_Tracks[i].m_Active)
+                        score += rules.m_Sources[i].m_EdgeWeight;
+
+                const bool trigger = score && (score >= rules.m_EdgeThreshold);
+                if (trigger)
+                {
+                    l.m_Presence = true;
+                    l.m_TriggerAllowed = false;
+                }
+                changed = trigger;
+                l.m_FirstRun = false;
+            }
+
+            if (!l.m_FirstRun && l.m_Presence)
+            {
+                //keep detection
+                uint32_t score = 0;
+                for(size_t i = 0; i < N; ++i)
+                    if (IsHeld(rules.m_Sources[i], m_Tracks[i], nowMs))
+                        score += rules.m_Sources[i].m_KeepWeight;
+
+                l.m_Presence = score && (score >= rules.m_KeepThreshold);
+                if (!l.m_Presence)
+                {
+                    changed = true;
+                    l.m_TriggerAllowed = true;
+                }
+            }
+            return changed;
+        }
+
+        //ms until the earliest hold expires (the presence may drop then), 0 - nothing is held
+        constexpr uint32_t NextHoldExpiry(Rules<N> const& rules, uint32_t nowMs) const
+        {
+            uint32_t next = 0;
+            for(size_t i = 0; i < N; ++i)
+            {
+                auto const& t = m_Tracks[i];
+                auto const& r = rules.m_Sources[i];
+                if (t.m_Active || !r.m_KeepWeight || !IsHeld(r, t, nowMs))
+                    continue;
+                uint32_t left = r.m_HoldMs - (nowMs - t.m_DroppedAtMs);
+                if (!next || left < next)
+                    next = left;
+            }
+            return next;
+        }
+
+    private:
+        static constexpr bool IsHeld(SourceRule const& r, Track const& t, uint32_t nowMs)
+        {
+            return t.m_Active || (r.m_HoldMs && t.m_Dropped && ((nowMs - t.m_DroppedAtMs) < r.m_HoldMs));
+        }
+    };
+
+    //Per radar sensor state. The mmWave source of the engine is the OR of all sensors
+    template<size_t N, class State>
+    struct Sensors
+    {
+        struct Sensor
+        {
+            bool m_Presence = false;
+            State m_State{};
+        };
+        Sensor m_Sensors[N];
+
+        constexpr Sensor const& operator[](size_t i) const { return m_Sensors[i]; }
+
+        //returns 'true' if the fused presence has changed
+        constexpr bool Update(size_t i, bool presence, State s)
+        {
+            const bool before = Any();
+            m_Sensors[i] = {.m_Presence = presence, .m_State = s};
+            return before != Any();
+        }
+
+        constexpr bool Any() const
+        {
+            for(auto const& s : m_Sensors)
+                if (s.m_Presence)
+                    return true;
+            return false;
+        }
+    };
+}
+#endif
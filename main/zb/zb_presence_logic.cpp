@@ -1,9 +1,14 @@
 #include "zb_dev_def.hpp"
+#include "zb_sensor_mailbox.hpp"
+#include "zb_presence_fusion.hpp"
+#include "zb_attr_batch.hpp"
+#include "esp_timer.h"
+#include "esp_system.h"
 #include "../colors_def.hpp"
 
 namespace zb
 {
-    static ZbAlarmExt16 g_DelayedAttrUpdate;
+    static WheelTimerExt16 g_DelayedAttrUpdate;
 
     static void on_local_on_timer_finished(void* param)
     {
@@ -23,7 +28,7 @@ namespace zb
             FMT_PRINT("{} Sending off command on timer\n", _n);
 #endif
             if (g_State.CanSendCommandsToBind())
-                g_State.m_OffSender.Send();
+                g_State.SendOff();
 
             ZbAlarm::check_counter_of_death();
         }
@@ -60,7 +65,7 @@ namespace zb
         {
             //g_State.m_Internals.m_LastSendOnOffResult = (uint8_t)Internals::SendOnOffResult::SentTimedOn;
             FMT_PRINT("Sending timed on command to binded with timeout: {};\n", t);
-            g_State.m_OnTimedSender.Send();
+            g_State.SendOnTimed();
             return true;
         }
         else if (m == OnOffMode::TimedOnLocal)
@@ -78,7 +83,7 @@ namespace zb
                 //set/reset the local timer
                 g_State.StartLocalTimer(&on_local_on_timer_finished, t * 1000);
             }
-            g_State.m_OnSender.Send();
+            g_State.SendOn();
             return true;
         }
         else
@@ -87,56 +92,62 @@ namespace zb
             if (on)
             {
                 //g_State.m_Internals.m_LastSendOnOffResult = (uint8_t)Internals::SendOnOffResult::SentOn;
-                g_State.m_OnSender.Send();
+                g_State.SendOn();
                 return true;
             }
             else
             {
                 //g_State.m_Internals.m_LastSendOnOffResult = (uint8_t)Internals::SendOnOffResult::SentOff;
-                g_State.m_OffSender.Send();
+                g_State.SendOff();
                 return true;
             }
         }
         return false;
     }
 
+    static fusion::Engine<fusion::kSources> g_Fusion;
+    static WheelTimerExt16 g_FusionHoldTimer;
+
+    //edge/keep bits of the config map 1:1 to the fusion sources
+    static fusion::Rules<fusion::kSources> get_fusion_rules(LocalConfig::PresenceDetectionMode cfg)
+    {
+        using fusion::Source;
+        auto bit = [](Source s, bool on) { return on ? (1u << uint32_t(s)) : 0u; };
+        const uint32_t edge = bit(Source::mmWave, cfg.m_Edge_mmWave)
+                            | bit(Source::PIRInternal, cfg.m_Edge_PIRInternal)
+                            | bit(Source::External, cfg.m_Edge_External)
+                            | bit(Source::Approach, true);//guarded by the approach distance itself
+        const uint32_t keep = bit(Source::mmWave, cfg.m_Keep_mmWave)
+                            | bit(Source::PIRInternal, cfg.m_Keep_PIRInternal)
+                            | bit(Source::External, cfg.m_Keep_External)
+                            | bit(Source::Approach, true);//otherwise the keep pass drops what the approach just triggered
+        return fusion::kDefaultRules.Masked(edge, keep);
+    }
+
     //returns 'true' if changed
     bool update_presence_state()
     {
-        bool changed = false;
-        auto cfg = g_Config.GetPresenceDetectionMode();
+        using fusion::Source;
+        const auto rules = get_fusion_rules(g_Config.GetPresenceDetectionMode());
+        const uint32_t now = uint32_t(esp_timer_get_time() / 1000);
         //FMT_PRINT("Upd Presence state. First: {}, Trigger allowed: {}, last pres: {}\n", g_State.m_FirstRun, g_State.m_TriggerAllowed, g_State.m_LastPresence);
 
-        if (g_State.m_FirstRun || g_State.m_TriggerAllowed || !g_State.m_LastPresence)
-        {
-            //edge detection
-            bool trigger = 
-                   (cfg.m_Edge_mmWave && g_State.m_LastPresenceMMWave)
-                || (cfg.m_Edge_PIRInternal && g_State.m_LastPresencePIRInternal)
-                || (cfg.m_Edge_External && g_State.m_LastPresenceExternal);
-
-            if (trigger)
-            {
-                g_State.m_LastPresence = true;
-                g_State.m_TriggerAllowed = false;
-            }
-            changed = trigger;
-            g_State.m_FirstRun = false;
-        }
+        g_Fusion.Set(Source::mmWave, g_State.m_LastPresenceMMWave, now);
+        g_Fusion.Set(Source::PIRInternal, g_State.m_LastPresencePIRInternal, now);
+        g_Fusion.Set(Source::External, g_State.m_LastPresenceExternal, now);
+        g_Fusion.Set(Source::Approach, g_State.m_LastApproaching, now);
+        bool changed = g_Fusion.Evaluate(rules, {g_State.m_LastPresence, g_State.m_FirstRun, g_State.m_TriggerAllowed}, now);
 
-        if (!g_State.m_FirstRun && g_State.m_LastPresence)
+        //a held source will expire without any new input: re-evaluate then
+        if (auto holdMs = g_Fusion.NextHoldExpiry(rules, now); g_State.m_LastPresence && holdMs)
         {
-            //keep detection
-            g_State.m_LastPresence = 
-                   (cfg.m_Keep_mmWave && g_State.m_LastPresenceMMWave)
-                || (cfg.m_Keep_PIRInternal && g_State.m_LastPresencePIRInternal)
-                || (cfg.m_Keep_External && g_State.m_LastPresenceExternal);
-
-            if (!g_State.m_LastPresence)
-            {
-                changed = true;
-                g_State.m_TriggerAllowed = true;
-            }
+            g_FusionHoldTimer.Setup([]{
+                    if (update_presence_state() && !g_State.m_SuppressedByIllulminance)
+                    {
+                        (void)send_on_off(g_State.m_LastPresence);
+                        update_zb_occupancy_attr();
+                    }
+            }, holdMs);
         }
 
         if (changed)
@@ -151,6 +162,11 @@ namespace zb
             }
         }
 
+        //background noise floor tracking is allowed only while nothing at all indicates presence
+        const bool confirmedEmpty = !g_State.m_LastPresence && !g_State.m_LastPresencePIRInternal && !g_State.m_LastPresenceExternal;
+        for(auto &s : g_Sensors)
+            s.SetConfirmedEmpty(confirmedEmpty);
+
         /**********************************************************************/
         /* Illuminance threshold logic                                        */
         /**********************************************************************/
@@ -167,50 +183,128 @@ namespace zb
         return changed;
     }
 
+    /**********************************************************************/
+    /* Engineering telemetry                                              */
+    /**********************************************************************/
+    //14 nibbles into 7 bytes, low nibble first
+    static void pack_nibbles(uint8_t *pDst, const uint8_t (&n)[14])
+    {
+        for(uint8_t i = 0; i < 14; i += 2)
+            *pDst++ = (n[i] & 0x0f) | (n[i + 1] << 4);
+    }
+
+    template<class Get>
+    static GateArrayEncoding encode_gate_array(EngineeringTelemetryBufType &buf, SensorMailbox::MeasurementsSnapshot const& m, Get &&get)
+    {
+        uint8_t v[14];
+        for(uint8_t i = 0; i < 14; ++i)
+            v[i] = std::min<uint16_t>(get(m.m_Gates[i]), 0xff);
+
+        uint8_t n[14] = {};
+        bool deltaFits = true;
+        for(uint8_t i = 1; i < 14 && deltaFits; ++i)
+        {
+            int d = int(v[i]) - int(v[i - 1]);
+            deltaFits = (d >= -8) && (d <= 7);
+            n[i - 1] = uint8_t(d);
+        }
+
+        if (deltaFits)
+        {
+            buf.data[buf.sz++] = v[0];
+            pack_nibbles(buf.data + buf.sz, n);
+            buf.sz += 7;
+            return GateArrayEncoding::Delta;
+        }
+
+        for(uint8_t i = 0; i < 14; ++i)
+            n[i] = std::min(v[i] >> 3, 0x0f);
+        pack_nibbles(buf.data + buf.sz, n);
+        buf.sz += 7;
+        return GateArrayEncoding::Nibbles;
+    }
+
+    void update_engineering_telemetry_attr()
+    {
+        if (!g_State.m_EngineeringTelemetry)
+            return;
+
+        EngineeringTelemetryBufType buf;
+        auto const& t = g_State.m_LastTarget;
+        buf.data[0] = kEngineeringTelemetryVersion;
+        buf.data[1] = uint8_t(t.m_State);
+        std::memcpy(&buf.data[2], &t.m_MoveDistance, 2);
+        buf.data[4] = t.m_MoveEnergy;
+        std::memcpy(&buf.data[5], &t.m_StillDistance, 2);
+        buf.data[7] = t.m_StillEnergy;
+        buf.sz = kEngineeringTelemetryHeader;
+
+        uint16_t encodings = 0;
+        SensorMailbox::MeasurementsSnapshot m;
+        g_SensorMailbox.GetMeasurements(0, m);
+        //gate energies are only there in the energy (engineering) mode of the radar
+        if (m.m_Mode == LD2412::SystemMode::Energy)
+        {
+            using M = ld2412::Component::EnergyReading;
+            uint8_t shift = 0;
+            auto add = [&](auto &&get){ encodings |= uint16_t(encode_gate_array(buf, m, get)) << shift; shift += 2; };
+            add([](M const& m){ return m.move.last; });
+            add([](M const& m){ return m.still.last; });
+            add([](M const& m){ return m.move.min; });
+            add([](M const& m){ return m.still.min; });
+            add([](M const& m){ return m.move.max; });
+            add([](M const& m){ return m.still.max; });
+        }
+        std::memcpy(&buf.data[8], &encodings, 2);
+
+        if (auto status = g_EngineeringTelemetry.Set(buf); !status)
+        {
+            FMT_PRINT("Failed to set engineering telemetry attribute with error {:x}\n", (int)status.error());
+        }
+    }
+
     static void update_on_movement_attr()
     {
+        AttrBatch batch;
         /**********************************************************************/
         /* Zigbee attributes update                                           */
         /**********************************************************************/
         update_zb_occupancy_attr();
         {
-            if (auto status = g_LD2412State.Set(LD2412State(g_State.m_LastLD2412State)); !status)
-            {
-                FMT_PRINT("Failed to set state attribute with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_LD2412ExState.Set(g_State.m_LastLD2412ExtendedState); !status)
-            {
-                FMT_PRINT("Failed to set extended state attribute with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_LD2412PIRPresence.Set(g_State.m_LastPresencePIRInternal); !status)
-            {
-                FMT_PRINT("Failed to set PIR presence attribute with error {:x}\n", (int)status.error());
-            }
+            AttrBatch::Set(g_LD2412State, LD2412State(g_State.m_LastLD2412State), "state attribute");
+            AttrBatch::Set(g_LD2412ExState, g_State.m_LastLD2412ExtendedState, "extended state attribute");
+            AttrBatch::Set(g_LD2412PIRPresence, g_State.m_LastPresencePIRInternal, "PIR presence attribute");
+            AttrBatch::Set(g_ApproachSpeed, g_State.m_LastApproachSpeed, "approach speed attribute");
+        }
+        update_engineering_telemetry_attr();
+    }
 
-#if defined(ENABLE_ENGINEERING_ATTRIBUTES)
-            if (auto status = g_LD2412MoveDistance.Set(p.m_MoveDistance); !status)
-            {
-                FMT_PRINT("Failed to set move dist attribute with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_LD2412StillDistance.Set(p.m_StillDistance); !status)
-            {
-                FMT_PRINT("Failed to set still dist attribute with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_LD2412MoveEnergy.Set(p.m_MoveEnergy); !status)
-            {
-                FMT_PRINT("Failed to set move dist attribute with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_LD2412StillEnergy.Set(p.m_StillEnergy); !status)
+    //re-evaluates presence after any of the inputs (g_State.m_LastPresence*) changed
+    static void react_on_presence_inputs(ld2412::Component::PresenceResult const& p)
+    {
+        bool presence_changed = update_presence_state();
+
+        if (g_State.m_SuppressedByIllulminance)
+            return;
+
+        FMT_PRINT("Presence: {}; Data: {}\n", (int)g_State.m_LastPresence, p);
+        if (presence_changed)
+        {
+            if (send_on_off(g_State.m_LastPresence))
             {
-                FMT_PRINT("Failed to set still dist attribute with error {:x}\n", (int)status.error());
+                FMT_PRINT("Delaying attribute on presence update\n");
+                g_DelayedAttrUpdate.Setup(update_on_movement_attr, kDelayedAttrChangeTimeout);
+                return;
             }
-#endif
         }
+        update_on_movement_attr();
     }
 
-    static void on_movement_callback(bool _presence, ld2412::Component::PresenceResult const& p, ld2412::Component::ExtendedState exState)
+    /**********************************************************************/
+    /* Zigbee task side of the sensor updates                             */
+    /**********************************************************************/
+    static void handle_primary_movement(ld2412::Component::PresenceResult const& p, ld2412::Component::ExtendedState exState)
     {
-        APILock l;
         using clock_t = std::chrono::system_clock;
         if (p.pirPresence && !g_State.m_LastPresencePIRInternal)
         {
@@ -232,188 +326,299 @@ namespace zb
                 g_State.m_Internals.m_LastFalsePIRDuration = std::chrono::time_point_cast<std::chrono::milliseconds>(clock_t::now()).time_since_epoch().count()
                     -
                     g_State.m_LastPIRTimeMS;
+                g_State.InternalsChanged();
             }
         }
 
         if (p.mmPresence && g_State.m_FalsePIRProbe)
             g_State.m_FalsePIRProbe = false;
 
-        g_State.m_LastPresenceMMWave = p.mmPresence;
+        //mmWave presence is the OR of all radar sensors
+        g_State.m_LastPresenceMMWave = g_State.AnySensorPresence();
         g_State.m_LastPresencePIRInternal = p.pirPresence;
         g_State.m_LastLD2412State = p.m_State;
         g_State.m_LastLD2412ExtendedState = exState;
+        g_State.m_LastTarget = p;
+        auto approachDistance = g_Config.GetApproachDistance();
+        g_State.m_LastApproaching = approachDistance && p.ApproachingWithin(approachDistance);
+        g_State.m_LastApproachSpeed = p.m_ApproachSpeed;
 
-        bool presence_changed = update_presence_state();
+        react_on_presence_inputs(p);
+    }
 
-        if (g_State.m_SuppressedByIllulminance)
-            return;
+#if defined(ENABLE_SECOND_SENSOR)
+    template<uint8_t EP>
+    static void update_sensor_movement_attr(ld2412::Component::PresenceResult const& p)
+    {
+        using Attrs = SensorAttributes<EP>;
+        AttrBatch::Set(Attrs::g_Occupancy, p.mmPresence ? ESP_ZB_ZCL_OCCUPANCY_SENSING_OCCUPANCY_OCCUPIED : ESP_ZB_ZCL_OCCUPANCY_SENSING_OCCUPANCY_UNOCCUPIED, "occupancy attribute of secondary ep");
+        AttrBatch::Set(Attrs::g_State, LD2412State(p.m_State), "state attribute of secondary ep");
+    }
 
-        FMT_PRINT("Presence: {}; Data: {}\n", (int)g_State.m_LastPresence, p);
-        if (presence_changed)
-        {
-            if (send_on_off(g_State.m_LastPresence))
-            {
-                FMT_PRINT("Delaying attribute on presence update\n");
-                g_DelayedAttrUpdate.Setup(update_on_movement_attr, kDelayedAttrChangeTimeout);
-                return;
-            }
-        }
-        update_on_movement_attr();
+    static void handle_secondary_movement(ld2412::Component::PresenceResult const& p, bool fusedChanged)
+    {
+        update_sensor_movement_attr<SECONDARY_PRESENCE_EP>(p);
+        if (!fusedChanged)
+            return;//fused mmWave presence did not change
+
+        g_State.m_LastPresenceMMWave = g_State.AnySensorPresence();
+        react_on_presence_inputs(p);
     }
+#endif
 
-    static void on_measurements_callback()
+    static void handle_movement(uint8_t sensor, bool _presence, ld2412::Component::PresenceResult const& p, ld2412::Component::ExtendedState exState)
     {
-#if defined(ENABLE_ENGINEERING_ATTRIBUTES)
-        EnergyBufType moveBuf, stillBuf;
-        EnergyBufType moveMinBuf, stillMinBuf;
-        EnergyBufType moveMaxBuf, stillMaxBuf;
-        for(uint8_t i = 0; auto const& m : g_ld2412.GetMeasurements())
+        [[maybe_unused]] const bool fusedChanged = g_State.m_Sensors.Update(sensor, p.mmPresence, p.m_State);
+        if (sensor == 0)
         {
-            moveBuf.data[i] = m.move.last;
-            stillBuf.data[i] = m.still.last;
-            moveMinBuf.data[i] = m.move.min;
-            stillMinBuf.data[i] = m.still.min;
-            moveMaxBuf.data[i] = m.move.max;
-            stillMaxBuf.data[i] = m.still.max;
-            ++i;
+            handle_primary_movement(p, exState);
+            BootTimeline::Mark(BootTimeline::Phase::FirstPresence);
+            BootTimeline::Finalize();
         }
+#if defined(ENABLE_SECOND_SENSOR)
+        else
+            handle_secondary_movement(p, fusedChanged);
+#endif
+    }
 
-        //FMT_PRINT("Measurements update: stillMax {};\n", stillMaxBuf.sv());
-        //FMT_PRINT("Measurements update: stillMin {};\n", stillMinBuf.sv());
-        //FMT_PRINT("Measurements update: move {};\n", moveBuf.sv());
+    static void handle_measurements()
+    {
+        update_engineering_telemetry_attr();
+        g_State.LightMeasured();
+    }
+
+    static void fill_sensitivity(SensitivityBufType &moveBuf, SensitivityBufType &stillBuf, SensorMailbox::ConfigSnapshot const& c)
+    {
+        for(uint8_t i = 0; i < 14; ++i)
         {
-            APILock l;
-            if (auto status = g_LD2412EngineeringEnergyMove.Set(moveBuf); !status)
-            {
-                FMT_PRINT("Failed to set measured move energy attribute with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_LD2412EngineeringEnergyStill.Set(stillBuf); !status)
-            {
-                FMT_PRINT("Failed to set measured still energy attribute with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_LD2412EngineeringEnergyMoveMin.Set(moveMinBuf); !status)
-            {
-                FMT_PRINT("Failed to set measured min move energy attribute with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_LD2412EngineeringEnergyStillMin.Set(stillMinBuf); !status)
-            {
-                FMT_PRINT("Failed to set measured min still energy attribute with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_LD2412EngineeringEnergyMoveMax.Set(moveMaxBuf); !status)
-            {
-                FMT_PRINT("Failed to set measured max move energy attribute with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_LD2412EngineeringEnergyStillMax.Set(stillMaxBuf); !status)
-            {
-                FMT_PRINT("Failed to set measured max still energy attribute with error {:x}\n", (int)status.error());
-            }
+            moveBuf.data[i] = c.m_MoveThreshold[i];
+            stillBuf.data[i] = c.m_StillThreshold[i];
         }
-#endif
     }
 
-    static void on_config_update_callback()
+#if defined(ENABLE_SECOND_SENSOR)
+    template<uint8_t EP>
+    static void update_sensor_config_attr(SensorMailbox::ConfigSnapshot const& c)
     {
+        using Attrs = SensorAttributes<EP>;
         SensitivityBufType moveBuf, stillBuf;
-        for(uint8_t i = 0; i < 14; ++i)
+        fill_sensitivity(moveBuf, stillBuf, c);
+        AttrBatch::Set(Attrs::g_MoveSensitivity, moveBuf, "move sensitivity attribute of secondary ep");
+        AttrBatch::Set(Attrs::g_StillSensitivity, stillBuf, "still sensitivity attribute of secondary ep");
+        AttrBatch::Set(Attrs::g_MinDistance, c.m_MinDistance, "min distance of secondary ep");
+        AttrBatch::Set(Attrs::g_MaxDistance, c.m_MaxDistance, "max distance of secondary ep");
+        AttrBatch::Set(Attrs::g_Mode, c.m_Mode, "system mode of secondary ep");
+    }
+#endif
+
+    static void handle_config_update(uint8_t sensor)
+    {
+        SensorMailbox::ConfigSnapshot c;
+        g_SensorMailbox.GetConfig(sensor, c);
+#if defined(ENABLE_SECOND_SENSOR)
+        if (sensor != 0)
         {
-            moveBuf.data[i] = g_ld2412.GetMoveThreshold(i);
-            stillBuf.data[i] = g_ld2412.GetStillThreshold(i);
+            update_sensor_config_attr<SECONDARY_PRESENCE_EP>(c);
+            return;
         }
-        auto timeout = g_ld2412.GetTimeout();
-        auto minDistance = g_ld2412.GetMinDistance();
-        auto maxDistance = g_ld2412.GetMaxDistance();
+#endif
+        SensitivityBufType moveBuf, stillBuf;
+        fill_sensitivity(moveBuf, stillBuf, c);
+        auto timeout = c.m_Timeout;
+        auto minDistance = c.m_MinDistance;
+        auto maxDistance = c.m_MaxDistance;
 
         FMT_PRINT("Setting move sensitivity attribute with {}\n", moveBuf.sv());
         FMT_PRINT("Setting still sensitivity attribute with {}\n", stillBuf.sv());
         FMT_PRINT("Setting timeout attribute with {}\n", timeout);
         {
-            APILock l;
-            if (auto status = g_LD2412MoveSensitivity.Set(moveBuf); !status)
-            {
-                FMT_PRINT("Failed to set move sensitivity attribute with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_LD2412StillSensitivity.Set(stillBuf); !status)
-            {
-                FMT_PRINT("Failed to set move sensitivity attribute with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_OccupiedToUnoccupiedTimeout.Set(timeout); !status)
+            AttrBatch::Set(g_LD2412MoveSensitivity, moveBuf, "move sensitivity attribute");
+            AttrBatch::Set(g_LD2412StillSensitivity, stillBuf, "still sensitivity attribute");
+            AttrBatch::Set(g_OccupiedToUnoccupiedTimeout, timeout, "occupied to unoccupied timeout");
+            AttrBatch::Set(g_LD2412MinDistance, minDistance, "min distance");
+            AttrBatch::Set(g_LD2412MaxDistance, maxDistance, "max distance");
+            AttrBatch::Set(g_LD2412Mode, c.m_Mode, "system mode");
+            AttrBatch::Set(g_LD2412DistanceRes, c.m_DistanceRes, "distance resolution");
+        }
+
+        g_Config.SetLD2412Mode(c.m_Mode);//save in the config
+        g_Config.SetNoiseFloor(c.m_NoiseFloor);//base thresholds may have changed
+    }
+
+    //runs in the context of the zigbee task, scheduled by the mailbox
+    static void consume_sensor_updates(uint8_t)
+    {
+        auto start = esp_timer_get_time();
+        g_SensorMailbox.BeginConsume();
+        {
+            //all attribute updates of this run are applied at once at the end of the scope
+            AttrBatch batch;
+
+            SensorMailbox::MovementSnapshot m;
+            for(uint8_t i = 0; i < kSensorCount; ++i)
             {
-                FMT_PRINT("Failed to set occupied to unoccupied timeout with error {:x}\n", (int)status.error());
+                while(g_SensorMailbox.PopMovement(i, m))
+                    handle_movement(i, m.m_Detected, m.m_Presence, m.m_ExState);
             }
-            if (auto status = g_LD2412MinDistance.Set(minDistance); !status)
+
+            uint8_t configMask = g_SensorMailbox.TakeConfig();
+            for(uint8_t i = 0; i < kSensorCount; ++i)
             {
-                FMT_PRINT("Failed to set min distance with error {:x}\n", (int)status.error());
+                if (configMask & (1 << i))
+                    handle_config_update(i);
             }
-            if (auto status = g_LD2412MaxDistance.Set(maxDistance); !status)
+
+            //zones are exposed only for the primary sensor
+            if (g_SensorMailbox.TakeZones() & 1)
             {
-                FMT_PRINT("Failed to set max distance with error {:x}\n", (int)status.error());
+                AttrBatch::Set(g_ZonesOccupancy, g_SensorMailbox.GetZones(0), "zones occupancy attribute");
             }
-            if (auto status = g_LD2412Mode.Set(g_ld2412.GetMode()); !status)
+
+            //engineering measurements exist only for the primary sensor
+            if (g_SensorMailbox.TakeMeasurements() & 1)
+                handle_measurements();
+        }
+
+        uint32_t took = esp_timer_get_time() - start;
+        if (g_SensorMailbox.m_Consume.Add(took))
+            FMT_PRINT("Sensor updates: new max processing time in zigbee task {}us (the APILock hold of a sensor task before the handoff); handoff APILock max {}us\n", took, g_SensorMailbox.m_HandoffLock.m_MaxUs);
+    }
+
+    /**********************************************************************/
+    /* Sensor task side: publish only, never take APILock                 */
+    /**********************************************************************/
+    template<uint8_t Sensor>
+    static void on_movement_callback(bool _presence, ld2412::Component::PresenceResult const& p, ld2412::Component::ExtendedState exState)
+    {
+        g_SensorMailbox.PublishMovement(Sensor, _presence, p, exState);
+    }
+
+    //called by the manage task of the sensor, the owner of the measurements
+    template<uint8_t Sensor>
+    static void on_measurements_callback()
+    {
+        auto const& sensor = g_Sensors[Sensor];
+        SensorMailbox::MeasurementsSnapshot m;
+        std::memcpy(m.m_Gates, sensor.GetMeasurements(), sizeof(m.m_Gates));
+        m.m_Light = sensor.GetMeasuredLight();
+        m.m_Mode = sensor.GetMode();
+        g_SensorMailbox.PublishMeasurements(Sensor, m);
+    }
+
+    //called by the manage task of the sensor, the owner of its config
+    template<uint8_t Sensor>
+    static void on_config_update_callback()
+    {
+        auto const& sensor = g_Sensors[Sensor];
+        SensorMailbox::ConfigSnapshot c;
+        for(uint8_t i = 0; i < 14; ++i)
+        {
+            c.m_MoveThreshold[i] = sensor.GetMoveThreshold(i);
+            c.m_StillThreshold[i] = sensor.GetStillThreshold(i);
+        }
+        c.m_Timeout = sensor.GetTimeout();
+        c.m_MinDistance = uint16_t(sensor.GetMinDistance());
+        c.m_MaxDistance = uint16_t(sensor.GetMaxDistance());
+        c.m_Mode = sensor.GetMode();
+        c.m_DistanceRes = sensor.GetDistanceRes();
+        c.m_NoiseFloor = sensor.GetNoiseFloorConfig();
+        g_SensorMailbox.PublishConfig(Sensor, c);
+    }
+
+    template<uint8_t Sensor>
+    static void on_zones_callback(uint8_t occupied)
+    {
+        g_SensorMailbox.PublishZones(Sensor, occupied);
+    }
+
+    template<uint8_t Sensor>
+    static void set_sensor_callbacks()
+    {
+        g_Sensors[Sensor].SetCallbackOnMovement(on_movement_callback<Sensor>);
+        g_Sensors[Sensor].SetCallbackOnMeasurementsUpdate(on_measurements_callback<Sensor>);
+        g_Sensors[Sensor].SetCallbackOnConfigUpdate(on_config_update_callback<Sensor>);
+        g_Sensors[Sensor].SetCallbackOnZones(on_zones_callback<Sensor>);
+    }
+
+    static bool setup_one_sensor(uint8_t idx)
+    {
+        auto const& desc = g_SensorBoard[idx];
+        auto &sensor = g_Sensors[idx];
+        //primary keeps its mode in the config, the rest start in the default one
+        auto mode = idx == 0 ? g_Config.GetLD2412Mode() : LD2412::SystemMode::Simple;
+        auto heapBefore = esp_get_free_heap_size();
+
+        if (idx == 0)
+            BootTimeline::Mark(BootTimeline::Phase::SensorSetup);
+        constexpr int kMaxTries = 3;
+        for(int tries = 0; tries < kMaxTries; ++tries)
+        {
+            if (idx == 0)
+                BootTimeline::SensorAttempt();
+            if (!sensor.Setup(ld2412::Component::setup_args_t{
+                        .txPin=desc.m_TxPin, 
+                        .rxPin=desc.m_RxPin, 
+                        .port=desc.m_Port,
+                        .presencePin=desc.m_PresencePin,
+                        .presencePIRPin=desc.m_PIRPin,
+                        .mode=mode,
+                        .reportPolicy=g_Config.GetReportPolicy(),
+                        .noiseFloor=idx == 0 ? g_Config.GetNoiseFloor() : ld2412::Component::NoiseFloorConfig{},
+                        .zones=idx == 0 ? g_Config.GetZones() : ld2412::Component::ZonesConfig{}
+                        }))
             {
-                FMT_PRINT("Failed to set initial system mode with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_LD2412DistanceRes.Set(g_ld2412.GetDistanceRes()); !status)
+                printf("Failed to configure ld2412 #%d (attempt %d)\n", idx, tries);
+                fflush(stdout);
+            }else
             {
-                FMT_PRINT("Failed to set initial distance resolution with error {:x}\n", (int)status.error());
+                FMT_PRINT("Sensor #{} (ep {}) costs: object {}b; heap taken by setup (queues+tasks) {}b\n"
+                        , idx, desc.m_EP
+                        , sizeof(ld2412::Component)
+                        , heapBefore - esp_get_free_heap_size());
+                if (idx == 0)
+                    BootTimeline::Mark(BootTimeline::Phase::SensorReady);
+                return true;
             }
         }
-
-        g_Config.SetLD2412Mode(g_ld2412.GetMode());//save in the config
+        return false;
     }
 
     void setup_sensor()
     {
-        g_ld2412.SetCallbackOnMovement(on_movement_callback);
-        g_ld2412.SetCallbackOnMeasurementsUpdate(on_measurements_callback);
-        g_ld2412.SetCallbackOnConfigUpdate(on_config_update_callback);
+        g_SensorMailbox.Start(consume_sensor_updates);
+        set_sensor_callbacks<0>();
+#if defined(ENABLE_SECOND_SENSOR)
+        set_sensor_callbacks<1>();
+#endif
 
         //set initial state of certain attributes
         {
             APILock l;
-            if (auto status = g_LD2412State.Set(LD2412State::Configuring); !status)
-            {
-                FMT_PRINT("Failed to set initial state with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_LD2412Mode.Set(g_ld2412.GetMode()); !status)
-            {
-                FMT_PRINT("Failed to set initial system mode with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_LD2412ExState.Set(ld2412::Component::ExtendedState::Normal); !status)
-            {
-                FMT_PRINT("Failed to set initial extended state with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_LD2412EngineeringLight.Set(0); !status)
-            {
-                FMT_PRINT("Failed to set initial measured light state with error {:x}\n", (int)status.error());
-            }
-            if (auto status = g_OnOffCommandMode.Set(g_Config.GetOnOffMode()); !status)
-            {
-                FMT_PRINT("Failed to set initial on-off mode {:x}\n", (int)status.error());
-            }
-            if (auto status = g_OnOffCommandTimeout.Set(g_Config.GetOnOffTimeout()); !status)
-            {
-                FMT_PRINT("Failed to set initial on-off timeout {:x}\n", (int)status.error());
-            }
-            if (auto status = g_PresenceDetectionIlluminanceThreshold.Set(g_Config.GetIlluminanceThreshold()); !status)
-            {
-                FMT_PRINT("Failed to set initial illuminance threshold {:x}\n", (int)status.error());
-            }
-            if (auto status = g_ExternalOnTime.Set(g_Config.GetExternalOnOffTimeout()); !status)
-            {
-                FMT_PRINT("Failed to set initial on time for external {:x}\n", (int)status.error());
-            }
-            if (auto status = g_FailureStatus.Set((uint16_t)g_State.m_LastFailedStatus); !status)
-            {
-                FMT_PRINT("Failed to set initial failure status {:x}\n", (int)status.error());
-            }
-            if (auto status = g_Internals.Set(g_State.m_Internals.GetVal()); !status)
-            {
-                FMT_PRINT("Failed to set initial internals {:x}\n", (int)status.error());
-            }
-            if (auto status = g_RestartsCount.Set(g_Config.GetRestarts()); !status)
-            {
-                FMT_PRINT("Failed to set initial internals {:x}\n", (int)status.error());
+            AttrBatch::Set(g_LD2412State, LD2412State::Configuring, "initial state");
+            AttrBatch::Set(g_LD2412Mode, g_Config.GetLD2412Mode(), "initial system mode");
+            AttrBatch::Set(g_LD2412ExState, ld2412::Component::ExtendedState::Normal, "initial extended state");
+            AttrBatch::Set(g_LD2412EngineeringLight, uint8_t(0), "initial measured light state");
+            AttrBatch::Set(g_OnOffCommandMode, g_Config.GetOnOffMode(), "initial on-off mode");
+            AttrBatch::Set(g_OnOffCommandTimeout, g_Config.GetOnOffTimeout(), "initial on-off timeout");
+            AttrBatch::Set(g_PresenceDetectionIlluminanceThreshold, g_Config.GetIlluminanceThreshold(), "initial illuminance threshold");
+            AttrBatch::Set(g_ExternalOnTime, g_Config.GetExternalOnOffTimeout(), "initial on time for external");
+            AttrBatch::Set(g_FailureStatus, (uint16_t)g_State.m_LastFailedStatus, "initial failure status");
+            AttrBatch::Set(g_Internals, g_State.m_Internals.GetVal(), "initial internals");
+            {
+                ZonesBufType zonesBuf;
+                for(uint8_t i = 0; auto const& z : g_Config.GetZones().m_Zones)
+                {
+                    zonesBuf.data[i++] = z.m_FirstGate;
+                    zonesBuf.data[i++] = z.m_LastGate;
+                    zonesBuf.data[i++] = z.m_MoveThreshold;
+                    zonesBuf.data[i++] = z.m_StillThreshold;
+                }
+                if (auto status = g_ZonesConfig.Set(zonesBuf); !status)
+                {
+                    FMT_PRINT("Failed to set initial zones config {:x}\n", (int)status.error());
+                }
             }
+            AttrBatch::Set(g_RestartsCount, g_Config.GetRestarts(), "initial restarts count");
             
             auto presenceDetectionMode = g_Config.GetPresenceDetectionMode();
             //FMT_PRINT("initial detection mode: edge: {} {} {}; keep: {} {} {}\n"
@@ -424,40 +629,30 @@ namespace zb
             //        , (bool)presenceDetectionMode.m_Keep_PIRInternal
             //        , (bool)presenceDetectionMode.m_Keep_External
             //        );
-            if (auto status = g_PresenceDetectionConfig.Set(presenceDetectionMode.m_Raw); !status)
-            {
-                FMT_PRINT("Failed to set initial detection config {:x}\n", (int)status.error());
-            }
+            AttrBatch::Set(g_PresenceDetectionConfig, presenceDetectionMode.m_Raw, "initial detection config");
         }
 
-        constexpr int kMaxTries = 3;
-        for(int tries = 0; tries < kMaxTries; ++tries)
+        if (!setup_one_sensor(0))
+        {
+            APILock l;
+            AttrBatch::Set(g_LD2412State, LD2412State::Failed, "initial state");
+            led::blink(true, colors::kLD2412ConfigError);
+            return;
+        }
+#if defined(ENABLE_SECOND_SENSOR)
         {
-            if (!g_ld2412.Setup(ld2412::Component::setup_args_t{
-                        .txPin=LD2412_PINS_TX, 
-                        .rxPin=LD2412_PINS_RX, 
-                        .presencePin=LD2412_PINS_PRESENCE,
-                        .presencePIRPin=LD2412_PINS_PIR_PRESENCE,
-                        .mode=g_Config.GetLD2412Mode()
-                        }))
             {
-                printf("Failed to configure ld2412 (attempt %d)\n", tries);
-                fflush(stdout);
-                if (tries == (kMaxTries - 1))
-                {
-                    APILock l;
-                    if (auto status = g_LD2412State.Set(LD2412State::Failed); !status)
-                    {
-                        FMT_PRINT("Failed to set initial state with error {:x}\n", (int)status.error());
-                        led::blink(true, colors::kLD2412ConfigError);
-                    }
-                    return;
-                }
-            }else
+                APILock l;
+                AttrBatch::Set(SecondarySensorAttributes::g_State, LD2412State::Configuring, "initial state of secondary ep");
+            }
+            //a failing secondary sensor doesn't stop the primary from working
+            if (!setup_one_sensor(1))
             {
-                break;
+                APILock l;
+                AttrBatch::Set(SecondarySensorAttributes::g_State, LD2412State::Failed, "state of secondary ep");
             }
         }
+#endif
         ESP_LOGI(TAG, "Sensor setup done");
     }
 
@@ -1,4 +1,7 @@
 #include "zb_dev_def.hpp"
+#include "zb_attr_batch.hpp"
+#include "zb_sensor_mailbox.hpp"
+#include "esp_timer.h"
 #include "../colors_def.hpp"
 
 namespace zb
@@ -9,6 +12,7 @@ namespace zb
         g_State.m_LastFailedStatus = status_code;
         g_State.m_FailedStatusUpdated = true;
         g_State.m_Internals.m_LastESP_ERR = e;
+        g_State.InternalsChanged();
 
         if (status_code == ESP_ZB_ZCL_STATUS_TIMEOUT)
         {
@@ -41,6 +45,7 @@ namespace zb
         g_State.m_LastFailedStatus = status_code;
         g_State.m_FailedStatusUpdated = true;
         g_State.m_Internals.m_LastESP_ERR = e;
+        g_State.InternalsChanged();
     }
 
     zb::seq_nr_t send_on_raw(void*)
@@ -72,6 +77,32 @@ namespace zb
         return esp_zb_zcl_on_off_on_with_timed_off_cmd_req(&cmd_req);
     }
 
+    //groupcasts are not acknowledged, so no retries/failure tracking here
+    static void send_on_timed_to_group(uint16_t group)
+    {
+        auto t = g_Config.GetOnOffTimeout();
+        esp_zb_zcl_on_off_on_with_timed_off_cmd_t cmd_req{};
+        cmd_req.zcl_basic_cmd.src_endpoint = PRESENCE_EP;
+        cmd_req.zcl_basic_cmd.dst_addr_u.addr_short = group;
+        cmd_req.on_off_control = 0;//process unconditionally
+        cmd_req.on_time = t * 10;
+        cmd_req.address_mode = ESP_ZB_APS_ADDR_MODE_16_GROUP_ENDP_NOT_PRESENT;
+        esp_zb_zcl_on_off_on_with_timed_off_cmd_req(&cmd_req);
+    }
+
+    static void send_on_off_to_group(uint16_t group, uint8_t cmdId)
+    {
+        if (cmdId == ESP_ZB_ZCL_CMD_ON_OFF_ON_WITH_TIMED_OFF_ID)
+            return send_on_timed_to_group(group);
+
+        esp_zb_zcl_on_off_cmd_t cmd_req{};
+        cmd_req.zcl_basic_cmd.src_endpoint = PRESENCE_EP;
+        cmd_req.zcl_basic_cmd.dst_addr_u.addr_short = group;
+        cmd_req.on_off_cmd_id = cmdId;
+        cmd_req.address_mode = ESP_ZB_APS_ADDR_MODE_16_GROUP_ENDP_NOT_PRESENT;
+        esp_zb_zcl_on_off_cmd_req(&cmd_req);
+    }
+
 
     /**********************************************************************/
     /* RuntimeState                                                       */
@@ -79,19 +110,151 @@ namespace zb
     RuntimeState g_State;
     bool RuntimeState::CanSendCommandsToBind() const
     {
-        return m_Internals.m_BoundDevices || m_InitialBindsChecking;
+        return m_TrackedBinds.size() || m_TrackedGroups.size() || m_InitialBindsChecking;
+    }
+
+    BindMask RuntimeState::BindsNeedingState(bool on) const
+    {
+        const BindMask all = first_binds(m_TrackedBinds.size());
+        //nothing is known about the group members
+        if (!all || m_TrackedGroups.size() || m_InitialBindsChecking)
+            return kAllBinds;
+
+        BindMask need = 0;
+        for(size_t i = 0, n = m_TrackedBinds.size(); i < n; ++i)
+        {
+            //a device without functional reporting may have been switched by anyone
+            if (!(m_ValidBinds & bind_bit(i)) || !m_TrackedBinds[i]->IsStateFresh(kBindStateMaxAgeMs))
+                return all;
+            if (bool(m_BindStates & bind_bit(i)) != on)
+                need |= bind_bit(i);
+        }
+        return need;
+    }
+
+    void RuntimeState::SendToGroups(uint8_t cmdId)
+    {
+        for(uint16_t g : m_TrackedGroups)
+            send_on_off_to_group(g, cmdId);
+    }
+
+    bool RuntimeState::DeliverPerBind(uint8_t cmdId, BindMask bindsMask)
+    {
+        if (!g_Config.GetPerBindDelivery() || !m_TrackedBinds.size())
+            return false;//not known yet whom to send to: binding table send
+
+        for(size_t i = 0, n = m_TrackedBinds.size(); i < n; ++i)
+        {
+            if (bindsMask & bind_bit(i))
+                m_TrackedBinds[i]->Deliver(cmdId);
+        }
+        SendToGroups(cmdId);
+        return true;
+    }
+
+    //With device binds present the binding table send is kept: the stack delivers
+    //the group entries of the table as groupcasts anyway.
+    void RuntimeState::SendOn()
+    {
+        const BindMask need = BindsNeedingState(true);
+        if (!need)
+        {
+            ++m_ElidedCommands;
+            FMT_PRINT("All bound devices are already on. Not sending (elided: {})\n", m_ElidedCommands);
+            return;
+        }
+
+        if (DeliverPerBind(ESP_ZB_ZCL_CMD_ON_OFF_ON_ID, need))
+            return;
+        if (GroupcastOnly())
+            return SendToGroups(ESP_ZB_ZCL_CMD_ON_OFF_ON_ID);
+        m_OnSender.Send();
+    }
+
+    void RuntimeState::SendOff()
+    {
+        const BindMask need = BindsNeedingState(false);
+        if (!need)
+        {
+            ++m_ElidedCommands;
+            FMT_PRINT("All bound devices are already off. Not sending (elided: {})\n", m_ElidedCommands);
+            return;
+        }
+
+        if (DeliverPerBind(ESP_ZB_ZCL_CMD_ON_OFF_OFF_ID, need))
+            return;
+        if (GroupcastOnly())
+            return SendToGroups(ESP_ZB_ZCL_CMD_ON_OFF_OFF_ID);
+        m_OffSender.Send();
+    }
+
+    //never elided: it (re)starts the off timer on the target devices
+    void RuntimeState::SendOnTimed()
+    {
+        if (DeliverPerBind(ESP_ZB_ZCL_CMD_ON_OFF_ON_WITH_TIMED_OFF_ID, kAllBinds))
+            return;
+        if (GroupcastOnly())
+            return SendToGroups(ESP_ZB_ZCL_CMD_ON_OFF_ON_WITH_TIMED_OFF_ID);
+        m_OnTimedSender.Send();
+    }
+
+    void RuntimeState::UpdateDeliveryStatsAttr()
+    {
+        BindDeliveryStatsBufType buf;
+        auto put = [&](uint16_t v){ buf.data[buf.sz++] = v & 0xff; buf.data[buf.sz++] = v >> 8; };
+        const size_t first = m_DeliveryStatsPage * kBindDeliveryStatsPerPage;
+        const size_t last = std::min<size_t>(first + kBindDeliveryStatsPerPage, m_TrackedBinds.size());
+        buf.data[buf.sz++] = first;
+        buf.data[buf.sz++] = m_TrackedBinds.size();
+        buf.data[buf.sz++] = kMaxBinds;
+        put(BindInfo::MemoryPerBind());
+        for(size_t i = first; i < last; ++i)
+        {
+            auto &bi = m_TrackedBinds[i];
+            auto const& d = bi->m_Delivery;
+            put(bi->m_ShortAddr);
+            put(d.m_Sent);
+            put(d.m_Failed);
+            put(d.m_Retries);
+            put(d.AvgLatencyMs());
+            put(d.m_MaxLatencyMs);
+        }
+        if (auto status = g_BindDeliveryStats.Set(buf); !status)
+        {
+            FMT_PRINT("Failed to set bind delivery stats attribute with error {:x}\n", (int)status.error());
+        }
+    }
+
+    void RuntimeState::UpdateConfigWriteStatsAttr()
+    {
+        auto const& s = LocalConfig::GetWriteStats();
+        ConfigWriteStatsBufType buf;
+        uint8_t *pDst = buf.data;
+        for(uint32_t v : {s.m_Changes, s.m_Writes, s.m_Bytes, s.m_Failures})
+        {
+            for(int i = 0; i < 4; ++i, v >>= 8)
+                *pDst++ = v & 0xff;
+        }
+        AttrBatch::Set(g_ConfigWriteStats, buf, "config write stats");
     }
 
     bool RuntimeState::CommandsToBindInFlight() const
     {
-        return m_OnSender.IsActive() || m_OffSender.IsActive() || m_OnTimedSender.IsActive();
+        if (m_OnSender.IsActive() || m_OffSender.IsActive() || m_OnTimedSender.IsActive())
+            return true;
+        for(auto &bi : m_TrackedBinds)
+            if (bi->IsDelivering())
+                return true;
+        return false;
     }
 
     uint8_t RuntimeState::GetIlluminance() const
     {
         if (g_Config.GetIlluminanceExternal())
             return m_ExternalIlluminance;
-        return g_ld2412.GetMeasuredLight();
+        SensorMailbox::MeasurementsSnapshot m;
+        g_SensorMailbox.GetMeasurements(0, m);
+        return m.m_Light;
     }
 
     void RuntimeState::StartExternalTimer(esp_zb_user_callback_t cb, uint32_t time)
@@ -119,16 +282,32 @@ namespace zb
         BindIteratorConfig cfg;
         cfg.on_begin = [](const esp_zb_zdo_binding_table_info_t *table_info, void *pCtx)->bool{
             FMT_PRINT("New own binds check round\n");
+            g_State.m_BindsScanActive = true;
             g_State.m_TempNewBinds.clear();
+            g_State.m_TempNewGroups.clear();
             g_State.m_FoundExisting = 0;
-            g_State.m_BindsReportingCapable = g_Config.GetBindReporting();
-            FMT_PRINT("Bind report caps: {:x}\n", g_State.m_BindsReportingCapable.GetRaw());
             for(auto &bi : g_State.m_TrackedBinds)
                 bi->m_BindChecked = false;
             return true;
         };
         cfg.on_entry = [](esp_zb_zdo_binding_table_record_t *pRec, void *pCtx)->bool{
             auto &newBinds = g_State.m_TempNewBinds;
+            if (pRec->dst_addr_mode == ESP_ZB_ZDO_BIND_DST_ADDR_MODE_16_BIT_GROUP)
+            {
+                //no reporting checks for groups: there's no single device to ask
+                if (RuntimeState::IsRelevant(esp_zb_zcl_cluster_id_t(pRec->cluster_id)))
+                {
+                    uint16_t group = pRec->dst_address.addr_short;
+                    FMT_PRINT("Group bind. Group={:x} to cluster {:x}\n", group, pRec->cluster_id);
+                    auto &newGroups = g_State.m_TempNewGroups;
+                    bool known = false;
+                    for(uint16_t g : newGroups)
+                        known = known || (g == group);
+                    if (!known && !newGroups.emplace_back(group))
+                        FMT_PRINT("Group bind {:x} ignored: too many groups\n", group);
+                }
+                return true;
+            }
             uint16_t shortAddr = esp_zb_address_short_by_ieee(pRec->dst_address.addr_long);
             esp_zb_zcl_addr_t addr;
             addr.addr_type = pRec->dst_addr_mode;
@@ -153,18 +332,23 @@ namespace zb
                             bi.m_AttemptsLeft = BindInfo::kMaxConfigAttempts;
                             if (g_State.m_InitialBindsChecking)
                             {
-                                auto repCapable = g_State.m_BindsReportingCapable.Get(newBinds.size() - 1);
-                                if (repCapable == TriState::Undefined)
+                                auto *pCaps = g_Config.GetBindCaps().Find(bi.m_IEEE, bi.m_EP, g_Config.GetRestarts());
+                                if (!pCaps)
                                 {
                                     bi.m_CheckReporting = true;
-                                    FMT_PRINT("{:x}: Requesting reporting check as this one is saved as undefined\n", shortAddr);
+                                    FMT_PRINT("{:x}: Requesting reporting check as this one is not known (or expired)\n", shortAddr);
                                 }
-                                else if (repCapable == TriState::False)
+                                else if (pCaps->m_Reporting == TriState::False)
                                 {
                                     FMT_PRINT("{:x}: Skipping check as this one is saved as non-functional\n", shortAddr);
                                     //no need to do any checks
                                     bi.Failed();//put into failed state, skip all the checks
                                 }
+                                else
+                                {
+                                    FMT_PRINT("{:x}: Skipping check as this one is saved as functional (checked at boot {})\n", shortAddr, pCaps->m_CheckedAtBoot);
+                                    bi.SkipChecks(pCaps->m_ReportConfigured);
+                                }
                             }
                             else
                             {
@@ -190,6 +374,7 @@ namespace zb
                 {
                     //request another one
                     g_State.m_NeedBindsChecking = true;
+                    g_State.RequestService();
                 }
             }
             return true;
@@ -197,19 +382,22 @@ namespace zb
         cfg.on_error = [](const esp_zb_zdo_binding_table_info_t *pTable, void *pCtx){
             //arm the next timer
             FMT_PRINT("Binds check error: {:x}; Next round\n", pTable->status);
+            g_State.m_BindsScanActive = false;
             g_State.m_NeedBindsChecking = true;
+            g_State.RequestService();
         };
         cfg.on_end = [](const esp_zb_zdo_binding_table_info_t *pTable, void *pCtx){
-            uint8_t newStates = 0;
-            uint8_t newValidity = 0;
+            BindMask newStates = 0;
+            BindMask newValidity = 0;
             if (g_State.m_FoundExisting != g_State.m_TrackedBinds.size())
             {
-                TriState8Array newReportingStates;
+                auto caps = g_Config.GetBindCaps();
                 int nextOldIdx = 0, nextNewIdx = 0;
                 for(auto i = g_State.m_TrackedBinds.begin(), e = g_State.m_TrackedBinds.end(); i != e; ++i, ++nextOldIdx)
                 {
                     if (!(*i)->m_BindChecked)
                     {
+                        caps.Remove((*i)->m_IEEE, (*i)->m_EP);
                         (*i)->Unbind();
                         g_State.m_BindsToCleanup.push_back(std::move(*i));
                         g_State.m_TrackedBinds.erase(i--);
@@ -217,18 +405,12 @@ namespace zb
                     }
                     else
                     {
-                        newReportingStates.Set(nextNewIdx, g_State.m_BindsReportingCapable.Get(nextOldIdx));
-                        newStates |= (g_State.m_BindStates & (1 << nextOldIdx)) >> (nextNewIdx - nextOldIdx);
-                        newValidity |= (g_State.m_ValidBinds & (1 << nextOldIdx)) >> (nextNewIdx - nextOldIdx);
+                        newStates |= (g_State.m_BindStates & bind_bit(nextOldIdx)) >> (nextOldIdx - nextNewIdx);
+                        newValidity |= (g_State.m_ValidBinds & bind_bit(nextOldIdx)) >> (nextOldIdx - nextNewIdx);
                         ++nextNewIdx;
                     }
                 }
-                if (g_State.m_BindsReportingCapable.GetRaw() != newReportingStates.GetRaw())
-                {
-                    FMT_PRINT("After iterating binds: updating info about report capabilities: from {:x} to {:x}\n", g_State.m_BindsReportingCapable.GetRaw(), newReportingStates.GetRaw());
-                    g_State.m_BindsReportingCapable = newReportingStates;
-                    g_Config.SetBindReporting(g_State.m_BindsReportingCapable);
-                }
+                g_Config.SetBindCaps(caps);
             }else
             {
                 newStates = g_State.m_BindStates;
@@ -239,19 +421,277 @@ namespace zb
                 g_State.m_TrackedBinds.push_back(std::move(bi));
 
             g_State.m_TempNewBinds.clear();
+
+            if (g_State.m_TrackedGroups.size() != g_State.m_TempNewGroups.size())
+                FMT_PRINT("Group binds changed: {} => {}\n", g_State.m_TrackedGroups.size(), g_State.m_TempNewGroups.size());
+            g_State.m_TrackedGroups.clear();
+            for(uint16_t g : g_State.m_TempNewGroups)
+                g_State.m_TrackedGroups.push_back(g);
+            g_State.m_TempNewGroups.clear();
+
             g_State.m_BindStates = newStates;
             g_State.m_ValidBinds = newValidity;
-            g_State.m_Internals.m_BoundDevices = g_State.m_TrackedBinds.size();
+            g_State.m_Internals.SetBoundDevices(g_State.m_TrackedBinds.size());
+            g_State.m_DeliveryStatsChanged = true;
             g_State.m_InitialBindsChecking = false;
+            g_State.m_BindsScanActive = false;
+            g_State.m_LastBindsScanMs = uint32_t(esp_timer_get_time() / 1000);
+            g_State.m_InternalsDirty = true;
+            g_State.BindsChanged();
         };
         FMT_PRINT("Initiating own binds iteration\n");
         bind_table_iterate(esp_zb_get_short_address(), cfg);
     }
 
-    void RuntimeState::RunService()
+    bool RuntimeState::ApplyBindDelta(bool bind, esp_zb_ieee_addr_t const& ieee, uint8_t ep)
     {
-        ZbAlarm::check_death_count();
+        //the positions of the binds are not stable while scanning
+        if (m_BindsScanActive || m_InitialBindsChecking)
+            return false;
+
+        auto pendingI = m_PendingBinds.begin();
+        while(pendingI != m_PendingBinds.end() && !pendingI->Matches(ieee))
+            ++pendingI;
+
+        auto existingI = m_TrackedBinds.find(zb::ieee_addr{ieee}, &BindInfo::m_IEEE);
+        if (!bind)
+        {
+            //not confirmed yet: just forgotten
+            if (pendingI != m_PendingBinds.end())
+                m_PendingBinds.erase(pendingI);
+            for(auto i = m_ConfirmingBinds.begin(), e = m_ConfirmingBinds.end(); i != e; ++i)
+            {
+                if (i->Matches(ieee))
+                {
+                    m_ConfirmingBinds.erase(i);
+                    break;
+                }
+            }
+            if (existingI != m_TrackedBinds.end())
+            {
+                FMT_PRINT("Unbind request for {:x}\n", (*existingI)->m_ShortAddr);
+                RemoveTrackedBind(existingI - m_TrackedBinds.begin());
+            }
+            return true;
+        }
+
+        if (existingI != m_TrackedBinds.end())
+        {
+            (*existingI)->m_EP = ep;
+            return true;
+        }
+
+        uint16_t shortAddr = esp_zb_address_short_by_ieee(const_cast<uint8_t*>(ieee));
+        if (shortAddr == 0xffff)
+            return false;
+
+        if (pendingI != m_PendingBinds.end())
+            pendingI->m_EP = ep;
+        else if (m_TrackedBinds.size() + m_PendingBinds.size() + m_ConfirmingBinds.size() >= kMaxBinds)
+        {
+            FMT_PRINT("Bind request for {:x} ignored: too many binds\n", shortAddr);
+            return true;
+        }
+        else
+        {
+            PendingBind pb{.m_IEEE = {}, .m_EP = ep};
+            std::memcpy(pb.m_IEEE, ieee, sizeof(pb.m_IEEE));
+            m_PendingBinds.push_back(pb);
+        }
+
+        FMT_PRINT("Bind request for {:x} ep {}: tracking once it's in the binding table\n", shortAddr, ep);
+        if (!m_BindsConfirmActive && !m_BindConfirm.IsRunning())
+            m_BindConfirm.Setup([](void *p){ ((RuntimeState *)p)->ConfirmPendingBinds(); }, this, kBindConfirmDelayMs);
+        return true;
+    }
+
+    void RuntimeState::ConfirmPendingBinds()
+    {
+        //a full scan running or about to run picks them up on its own
+        if (m_BindsScanActive || m_InitialBindsChecking || m_BindsCheck.IsRunning())
+        {
+            m_PendingBinds.clear();
+            return;
+        }
+        if (!m_PendingBinds.size())
+            return;
+
+        //requests coming in meanwhile wait for the next round
+        m_BindsConfirmActive = true;
+        for(auto const& pb : m_PendingBinds)
+            m_ConfirmingBinds.push_back(pb);
+        m_PendingBinds.clear();
+
+        BindIteratorConfig cfg;
+        cfg.on_begin = [](const esp_zb_zdo_binding_table_info_t *table_info, void *pCtx)->bool{ return true; };
+        cfg.on_entry = [](esp_zb_zdo_binding_table_record_t *pRec, void *pCtx)->bool{
+            if (pRec->dst_addr_mode != ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED || !RuntimeState::IsRelevant(esp_zb_zcl_cluster_id_t(pRec->cluster_id)))
+                return true;
+            auto &confirming = g_State.m_ConfirmingBinds;
+            for(auto i = confirming.begin(), e = confirming.end(); i != e; ++i)
+            {
+                if (!i->Matches(pRec->dst_address.addr_long) || i->m_EP != pRec->dst_endp)
+                    continue;
+                if (!g_State.TrackNewBind(i->m_IEEE, i->m_EP))
+                {
+                    //no short address any more: let the full scan sort it out
+                    g_State.m_NeedBindsChecking = true;
+                }
+                confirming.erase(i);
+                break;
+            }
+            return true;
+        };
+        cfg.on_error = [](const esp_zb_zdo_binding_table_info_t *pTable, void *pCtx){
+            //the outcome is unknown
+            FMT_PRINT("Bind confirmation error: {:x}; full scan\n", pTable->status);
+            g_State.m_NeedBindsChecking = true;
+            g_State.EndBindsConfirmation();
+        };
+        cfg.on_end = [](const esp_zb_zdo_binding_table_info_t *pTable, void *pCtx){
+            //whatever is left was rejected by the stack
+            for(auto const& pb : g_State.m_ConfirmingBinds)
+                FMT_PRINT("Bind request for {:x} ep {} failed: not in the binding table, not tracked\n"
+                        , esp_zb_address_short_by_ieee(const_cast<uint8_t*>(pb.m_IEEE)), pb.m_EP);
+            g_State.EndBindsConfirmation();
+        };
+        FMT_PRINT("Confirming {} bind requests\n", m_ConfirmingBinds.size());
+        bind_table_iterate(esp_zb_get_short_address(), cfg);
+    }
+
+    void RuntimeState::EndBindsConfirmation()
+    {
+        m_ConfirmingBinds.clear();
+        m_BindsConfirmActive = false;
+        if (m_PendingBinds.size())
+            m_BindConfirm.Setup([](void *p){ ((RuntimeState *)p)->ConfirmPendingBinds(); }, this, kBindConfirmDelayMs);
+        //a full scan requested meanwhile
+        if (m_NeedBindsChecking)
+            RequestService();
+    }
+
+    bool RuntimeState::TrackNewBind(esp_zb_ieee_addr_t const& ieee, uint8_t ep)
+    {
+        if (m_TrackedBinds.find(zb::ieee_addr{ieee}, &BindInfo::m_IEEE) != m_TrackedBinds.end())
+            return true;
+
+        uint16_t shortAddr = esp_zb_address_short_by_ieee(const_cast<uint8_t*>(ieee));
+        if (shortAddr == 0xffff)
+            return false;
+
+        if (m_TrackedBinds.size() == kMaxBinds)
+        {
+            FMT_PRINT("Bind for {:x} ignored: too many binds\n", shortAddr);
+            return true;
+        }
 
+        auto r = m_TrackedBinds.emplace_back(ieee, shortAddr);
+        if (!r || !*r)
+            return false;
+
+        FMT_PRINT("Bind for {:x} ep {} confirmed: tracking\n", shortAddr, ep);
+        const size_t idx = m_TrackedBinds.size() - 1;
+        m_ValidBinds &= ~bind_bit(idx);
+        m_BindStates &= ~bind_bit(idx);
+        auto caps = g_Config.GetBindCaps();
+        caps.Remove(ieee, ep);
+        g_Config.SetBindCaps(caps);
+
+        BindInfo &bi = **r;
+        bi.m_BindChecked = true;
+        bi.m_EP = ep;
+        bi.m_AttemptsLeft = BindInfo::kMaxConfigAttempts;
+        bi.m_CheckReporting = true;
+        bi.Do();
+
+        m_Internals.SetBoundDevices(m_TrackedBinds.size());
+        m_DeliveryStatsChanged = true;
+        m_InternalsDirty = true;
+        BindsChanged();
+        return true;
+    }
+
+    bool RuntimeState::ApplyGroupBindDelta(bool bind, uint16_t group)
+    {
+        if (m_BindsScanActive || m_InitialBindsChecking)
+            return false;
+
+        auto i = m_TrackedGroups.begin(), e = m_TrackedGroups.end();
+        while(i != e && *i != group)
+            ++i;
+        if (bind && (i == e))
+        {
+            if (!m_TrackedGroups.emplace_back(group))
+                FMT_PRINT("Group bind {:x} ignored: too many groups\n", group);
+        }
+        else if (!bind && (i != e))
+            m_TrackedGroups.erase(i);
+        FMT_PRINT("Group {} request {:x}: {} groups\n", bind ? "bind" : "unbind", group, m_TrackedGroups.size());
+        return true;
+    }
+
+    void RuntimeState::RemoveTrackedBind(size_t idx)
+    {
+        auto i = m_TrackedBinds.begin() + idx;
+        auto caps = g_Config.GetBindCaps();
+        caps.Remove((*i)->m_IEEE, (*i)->m_EP);
+        g_Config.SetBindCaps(caps);
+        (*i)->Unbind();
+        m_BindsToCleanup.push_back(std::move(*i));
+        m_TrackedBinds.erase(i);
+
+        //binds after the removed one move one position down
+        const BindMask lowMask = bind_bit(idx) - 1;
+        auto compact = [&](BindMask v)->BindMask{ return (v & lowMask) | ((v >> 1) & ~lowMask); };
+        m_ValidBinds = compact(m_ValidBinds);
+        m_BindStates = compact(m_BindStates);
+
+        m_Internals.SetBoundDevices(m_TrackedBinds.size());
+        m_DeliveryStatsChanged = true;
+        m_InternalsDirty = true;
+        BindsChanged();
+    }
+
+    void RuntimeState::DeviceAnnounced(esp_zb_ieee_addr_t const& ieee)
+    {
+        auto caps = g_Config.GetBindCaps();
+        caps.RemoveDevice(ieee);
+        g_Config.SetBindCaps(caps);//writes only if changed
+
+        bool recheck = false;
+        for(auto &bi : m_TrackedBinds)
+        {
+            if (std::memcmp(bi->m_IEEE, ieee, sizeof(esp_zb_ieee_addr_t)) || !bi->IsPassive())
+                continue;
+            FMT_PRINT("{:x}: announced, requesting reporting check\n", bi->m_ShortAddr);
+            bi->m_CheckReporting = true;
+            recheck = true;
+        }
+        if (recheck)
+        {
+            m_NeedBindsChecking = true;
+            RequestService();
+        }
+    }
+
+    void RuntimeState::RequestService()
+    {
+        if (m_ServiceSoon)
+            return;
+        m_ServiceSoon = true;
+        m_ServiceTimer.Setup([](void *p){ ((RuntimeState *)p)->RunService(); }, this, kServiceDelayMs);
+    }
+
+    void RuntimeState::LightMeasured()
+    {
+        if (GetIlluminance() == m_PublishedLight)
+            return;
+        m_LightDirty = true;
+        RequestService();
+    }
+
+    void RuntimeState::ServiceBinds()
+    {
         for(auto i = m_BindsToCleanup.begin(); i != m_BindsToCleanup.end(); ++i)
         {
             if ((*i)->GetState() == BindInfo::State::NonFunctional)
@@ -263,8 +703,7 @@ namespace zb
 
         auto prevValidBinds = m_ValidBinds;
         auto prevBindStates = m_BindStates;
-        [[maybe_unused]]auto prevReportCaps = m_BindsReportingCapable;
-        bool updateReportingCapsInConfig = false;
+        auto caps = g_Config.GetBindCaps();
         //update validity of the binds
         for(size_t i = 0, n = m_TrackedBinds.size(); i < n; ++i)
         {
@@ -272,28 +711,27 @@ namespace zb
             auto s = bi->GetState();
             if (s == BindInfo::State::Functional)
             {
-                m_ValidBinds |= 1 << i;
+                m_ValidBinds |= bind_bit(i);
                 if (bi->m_Initial)
                 {
                     bi->m_Initial = false;
-                    m_BindStates = (m_BindStates & ~(1 << i)) | (bi->m_InitialValue << i);
+                    bi->StateUpdated();
+                    m_BindStates = (m_BindStates & ~bind_bit(i)) | (bi->m_InitialValue ? bind_bit(i) : 0);
                 }
 
                 if (bi->m_CheckReporting)
                 {
                     FMT_PRINT("Bind {:x} Is has functional reporting\n", bi->m_ShortAddr);
-                    updateReportingCapsInConfig = true;   
-                    m_BindsReportingCapable.Set(i, TriState::True);
+                    caps.Put(bi->m_IEEE, bi->m_EP, true, bi->m_ReportConfigured, g_Config.GetRestarts());
                 }
             }
             else
             {
-                m_ValidBinds &= ~(1 << i);
+                m_ValidBinds &= ~bind_bit(i);
                 if (s == BindInfo::State::NonFunctional && bi->m_CheckReporting && bi->m_BoundToMe)
                 {
                     FMT_PRINT("Bind {:x} Is has non-functional reporting\n", bi->m_ShortAddr);
-                    updateReportingCapsInConfig = true;   
-                    m_BindsReportingCapable.Set(i, TriState::False);
+                    caps.Put(bi->m_IEEE, bi->m_EP, false, false, g_Config.GetRestarts());
                 }
             }
 
@@ -301,59 +739,88 @@ namespace zb
                 bi->m_CheckReporting = false;
         }
 
-        m_Internals.m_ConfiguredReports = m_ValidBinds;
+        m_Internals.m_ConfiguredReports = m_ValidBinds & 0xff;//first 8 binds only
+        m_InternalsDirty = true;
+
+        if (prevValidBinds != m_ValidBinds)
+        {
+            FMT_PRINT("Valid binds changed: from {:x} to {:x}\n", prevValidBinds, m_ValidBinds);
+        }
+        if (prevBindStates != m_BindStates)
+        {
+            FMT_PRINT("Bind states changed: from {:x} to {:x}\n", prevBindStates, m_BindStates);
+        }
+
+        g_Config.SetBindCaps(caps);
+    }
+
+    void RuntimeState::RunService()
+    {
+        const bool heartbeat = !m_ServiceSoon;
+        m_ServiceSoon = false;
+        ZbAlarm::check_death_count();
+
+        if (heartbeat)
+        {
+            //re-check everything
+            m_BindsDirty = true;
+            m_InternalsDirty = true;
+            m_LightDirty = true;
+        }
+
+        if (m_BindsDirty)
+        {
+            m_BindsDirty = false;
+            ServiceBinds();
+        }
 
+        bool retry = false;
         if (!CommandsToBindInFlight())
         {
-            m_Internals.Update();
+            if (m_InternalsDirty)
+            {
+                m_InternalsDirty = false;
+                m_Internals.Update();
+                UpdateConfigWriteStatsAttr();
+            }
+
             if (g_State.m_FailedStatusUpdated)
             {
                 g_State.m_FailedStatusUpdated = false;
-                if (auto status = g_FailureStatus.Set((uint16_t)g_State.m_LastFailedStatus); !status)
-                {
-                    FMT_PRINT("Failed to set failure status {:x}\n", (int)status.error());
-                }
+                AttrBatch::Set(g_FailureStatus, (uint16_t)g_State.m_LastFailedStatus, "failure status");
             }
 
-            if (m_NeedBindsChecking)
+            if (m_DeliveryStatsChanged)
+            {
+                m_DeliveryStatsChanged = false;
+                UpdateDeliveryStatsAttr();
+            }
+
+            if (!m_NeedBindsChecking && !m_BindsScanActive && !m_BindsCheck.IsRunning()
+                    && (uint32_t(esp_timer_get_time() / 1000) - m_LastBindsScanMs) > kBindsConsistencyCheckMs)
+                m_NeedBindsChecking = true;
+
+            //a confirmation of bind requests reads the binding table as well: the flag stays set until it's done
+            if (m_NeedBindsChecking && !m_BindsConfirmActive)
             {
                 m_NeedBindsChecking = false;
                 ScheduleBindsChecking();
             }
 
+            if (m_LightDirty)
             {
-                static uint16_t g_LastIlluminance = 0xffff;
-                auto currentIll = g_State.GetIlluminance();
-                if (currentIll != g_LastIlluminance)
-                {
-                    g_LastIlluminance = currentIll;
-                    if (auto status = g_LD2412EngineeringLight.Set(currentIll); !status)
-                    {
-                        FMT_PRINT("Failed to set measured light attribute with error {:x}\n", (int)status.error());
-                    }
-                }
+                m_LightDirty = false;
+                m_PublishedLight = GetIlluminance();
+                AttrBatch::Set(g_LD2412EngineeringLight, m_PublishedLight, "measured light attribute");
             }
         }
+        else
+            retry = m_InternalsDirty || m_FailedStatusUpdated || m_DeliveryStatsChanged || m_NeedBindsChecking || m_LightDirty;//the flags stay set
 
-        if (prevValidBinds != m_ValidBinds)
-        {
-            FMT_PRINT("Valid binds changed: from {:x} to {:x}\n", prevValidBinds, m_ValidBinds);
-        }
-        if (prevBindStates != m_BindStates)
-        {
-            FMT_PRINT("Bind states changed: from {:x} to {:x}\n", prevBindStates, m_BindStates);
-        }
-
-        if (updateReportingCapsInConfig)
-        {
-            FMT_PRINT("Updating info about report capabilities: from {:x} to {:x}\n", prevReportCaps.GetRaw(), m_BindsReportingCapable.GetRaw());
-            g_Config.SetBindReporting(m_BindsReportingCapable);
-        }
+        if (m_ServiceSoon)
+            return;//something got dirty during this run and is already scheduled
 
-        static ZbAlarm rep{"InternalsReporting"};
-        rep.Setup([](void *p){
-                RuntimeState *pState = (RuntimeState *)p;
-                pState->RunService();
-                }, this, 1000);
+        m_ServiceSoon = retry;
+        m_ServiceTimer.Setup([](void *p){ ((RuntimeState *)p)->RunService(); }, this, retry ? kServiceRetryMs : kServiceHeartbeatMs);
     }
 }
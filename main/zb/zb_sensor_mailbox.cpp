@@ -0,0 +1,51 @@
+#include "zb_sensor_mailbox.hpp"
+#include "esp_timer.h"
+#include "lib_thread.hpp"
+#include "zbh_helpers.hpp"
+
+namespace zb
+{
+    SensorMailbox g_SensorMailbox;
+
+    void SensorMailbox::Start(consumer_t consumer)
+    {
+        if (m_Wake)
+            return;//already started
+        m_Consumer = consumer;
+        m_Wake = xSemaphoreCreateBinary();
+        thread::start_task({.pName="ZB_Handoff", .stackSize = 2*1024, .prio=thread::kPrioElevated}, &handoff_loop, this).detach();
+    }
+
+    void SensorMailbox::PublishMovement(uint8_t sensor, bool detected, ld2412::Component::PresenceResult const& p, ld2412::Component::ExtendedState exState)
+    {
+        m_Movement[sensor].Push({.m_Presence = p, .m_ExState = exState, .m_Detected = detected});
+        Kick();
+    }
+
+    void SensorMailbox::Kick()
+    {
+        //only one wake up is needed until the consumer actually runs
+        if (!m_Scheduled.exchange(true, std::memory_order_acq_rel))
+            xSemaphoreGive(m_Wake);
+    }
+
+    void SensorMailbox::handoff_loop(SensorMailbox *pMailbox)
+    {
+        while(true)
+        {
+            if (xSemaphoreTake(pMailbox->m_Wake, portMAX_DELAY) != pdTRUE)
+                continue;
+
+            //esp_zb_scheduler_alarm may only be called in the zigbee task or with the lock held.
+            //The lock is held only for the duration of scheduling, never by a sensor task.
+            auto start = esp_timer_get_time();
+            {
+                APILock l;
+                esp_zb_scheduler_alarm(pMailbox->m_Consumer, 0, 0);
+            }
+            uint32_t held = esp_timer_get_time() - start;
+            if (pMailbox->m_HandoffLock.Add(held))
+                FMT_PRINT("Handoff: new max APILock wait+hold {}us (after {} handoffs)\n", held, pMailbox->m_HandoffLock.m_Count);
+        }
+    }
+}
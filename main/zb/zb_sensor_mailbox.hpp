@@ -0,0 +1,141 @@
+#ifndef ZB_SENSOR_MAILBOX_HPP_
+#define ZB_SENSOR_MAILBOX_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_zigbee_core.h"
+#include "../periph/ld2412_component.hpp"
+#include "zb_dev_def_const.hpp"
+#include "zb_handoff_ring.hpp"
+
+namespace zb
+{
+    /**********************************************************************/
+    /* Sensor -> Zigbee task handoff                                      */
+    /**********************************************************************/
+    //The sensor tasks never take APILock. They publish snapshots here and
+    //the data is consumed later in the context of the zigbee task.
+    //Movement snapshots go through a HandoffRing so that every transition is
+    //seen (PIR false positive detection relies on that) and the consumer
+    //always converges to the latest state.
+    //Config and measurements are owned by the manage task of a sensor: it
+    //publishes complete copies into seq-locked slots and the zigbee task reads
+    //only those, never the live sensor data.
+    struct SensorMailbox
+    {
+        struct MovementSnapshot
+        {
+            ld2412::Component::PresenceResult m_Presence;
+            ld2412::Component::ExtendedState m_ExState;
+            bool m_Detected;
+        };
+
+        struct ConfigSnapshot
+        {
+            uint8_t m_MoveThreshold[14];
+            uint8_t m_StillThreshold[14];
+            uint16_t m_Timeout;
+            uint16_t m_MinDistance;
+            uint16_t m_MaxDistance;
+            LD2412::SystemMode m_Mode;
+            LD2412::DistanceRes m_DistanceRes;
+            ld2412::Component::NoiseFloorConfig m_NoiseFloor;
+        };
+
+        struct MeasurementsSnapshot
+        {
+            ld2412::Component::EnergyReading m_Gates[14];
+            uint8_t m_Light;
+            LD2412::SystemMode m_Mode;
+        };
+
+        struct LockStats
+        {
+            uint32_t m_LastUs = 0;
+            uint32_t m_MaxUs = 0;
+            uint32_t m_Count = 0;
+
+            bool Add(uint32_t us)
+            {
+                m_LastUs = us;
+                ++m_Count;
+                if (us > m_MaxUs)
+                {
+                    m_MaxUs = us;
+                    return true;
+                }
+                return false;
+            }
+        };
+
+        using consumer_t = void(*)(uint8_t);
+        static constexpr uint32_t kMovementSlots = 8;//must be power of 2
+        static_assert(kSensorCount <= 8, "pending masks are 8 bit");
+
+        //must be called before any Publish*
+        void Start(consumer_t consumer);
+
+        /**********************************************************************/
+        /* Producer side (sensor tasks, one per sensor)                       */
+        /**********************************************************************/
+        void PublishMovement(uint8_t sensor, bool detected, ld2412::Component::PresenceResult const& p, ld2412::Component::ExtendedState exState);
+        void PublishMeasurements(uint8_t sensor, MeasurementsSnapshot const& m)
+        {
+            m_Measurements[sensor].Write(m);
+            m_MeasurementsPending.fetch_or(1 << sensor, std::memory_order_release);
+            Kick();
+        }
+        void PublishConfig(uint8_t sensor, ConfigSnapshot const& c)
+        {
+            m_Config[sensor].Write(c);
+            m_ConfigPending.fetch_or(1 << sensor, std::memory_order_release);
+            Kick();
+        }
+        void PublishZones(uint8_t sensor, uint8_t occupied) 
+        { 
+            m_Zones[sensor].store(occupied, std::memory_order_relaxed); 
+            m_ZonesPending.fetch_or(1 << sensor, std::memory_order_release); 
+            Kick(); 
+        }
+
+        /**********************************************************************/
+        /* Consumer side (zigbee task)                                        */
+        /**********************************************************************/
+        //must be called first thing by the consumer so that new publications schedule another run
+        void BeginConsume() { m_Scheduled.store(false, std::memory_order_release); }
+        bool PopMovement(uint8_t sensor, MovementSnapshot &dst) { return m_Movement[sensor].Pop(dst); }
+        //bit per sensor
+        uint8_t TakeMeasurements() { return m_MeasurementsPending.exchange(0, std::memory_order_acq_rel); }
+        uint8_t TakeConfig() { return m_ConfigPending.exchange(0, std::memory_order_acq_rel); }
+        uint8_t TakeZones() { return m_ZonesPending.exchange(0, std::memory_order_acq_rel); }
+        uint8_t GetZones(uint8_t sensor) const { return m_Zones[sensor].load(std::memory_order_relaxed); }
+        //the latest published copies, zero initialized until the first publication
+        void GetConfig(uint8_t sensor, ConfigSnapshot &dst) const { m_Config[sensor].Read(dst); }
+        void GetMeasurements(uint8_t sensor, MeasurementsSnapshot &dst) const { m_Measurements[sensor].Read(dst); }
+
+        LockStats m_HandoffLock;//APILock held by the handoff task (scheduling only)
+        LockStats m_Consume;//time spent in the zigbee task by the consumer (the same work used to be done by the sensor task under APILock)
+    private:
+        using MovementRing = HandoffRing<MovementSnapshot, kMovementSlots>;
+
+        void Kick();
+        static void handoff_loop(SensorMailbox *pMailbox);
+
+        consumer_t m_Consumer = nullptr;
+        SemaphoreHandle_t m_Wake = nullptr;
+
+        MovementRing m_Movement[kSensorCount];
+        std::atomic<uint8_t> m_MeasurementsPending{0};
+        std::atomic<uint8_t> m_ConfigPending{0};
+        std::atomic<uint8_t> m_ZonesPending{0};
+        std::atomic<uint8_t> m_Zones[kSensorCount]{};//latest zone occupancy per sensor
+        SeqLocked<ConfigSnapshot> m_Config[kSensorCount];
+        SeqLocked<MeasurementsSnapshot> m_Measurements[kSensorCount];
+        std::atomic<bool> m_Scheduled{false};
+    };
+
+    extern SensorMailbox g_SensorMailbox;
+}
+#endif
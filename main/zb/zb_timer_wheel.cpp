@@ -0,0 +1,193 @@
+#include "zb_timer_wheel.hpp"
+#include <bit>
+#include "esp_timer.h"
+#include "zbh_alarm.hpp"
+
+namespace zb
+{
+    WheelTimer::Slot WheelTimer::g_Wheel[kLevels][kSlots];
+    uint64_t WheelTimer::g_Occupied[kLevels] = {};
+    uint32_t WheelTimer::g_Current = 0;
+    uint32_t WheelTimer::g_ArmedTick = 0;
+    bool WheelTimer::g_Armed = false;
+    bool WheelTimer::g_InAdvance = false;
+    size_t WheelTimer::g_Pending = 0;
+
+    //the only alarm handle the wheel ever takes
+    static ZbAlarm g_WheelAlarm{"TimerWheel"};
+
+    uint32_t WheelTimer::NowTick()
+    {
+        return uint32_t(esp_timer_get_time() / (1000 * kTickMs));
+    }
+
+    void WheelTimer::Setup(callback_t cb, void *param, uint32_t ms)
+    {
+        Cancel();
+        //the first tick boundary not earlier than the requested time: never fires early
+        constexpr int64_t kTickUs = kTickMs * 1000;
+        const int64_t nowUs = esp_timer_get_time();
+        const uint32_t now = uint32_t(nowUs / kTickUs);
+        uint32_t ticks = uint32_t((nowUs % kTickUs + int64_t(ms) * 1000 + kTickUs - 1) / kTickUs);
+        if (ticks < 1) ticks = 1;
+        if (ticks > kMaxDelayTicks) ticks = kMaxDelayTicks;
+
+        if (!g_Pending && !g_InAdvance)
+            g_Current = now;//nothing is placed relative to the old position
+        m_Callback = cb;
+        m_pParam = param;
+        m_Expiry = now + ticks;
+        Place(this);
+        ++g_Pending;
+
+        if (!g_InAdvance && (!g_Armed || int32_t(m_Expiry - g_ArmedTick) < 0))
+            Arm();
+    }
+
+    void WheelTimer::Cancel()
+    {
+        if (!IsRunning())
+            return;
+        Unlink(&m_Link);
+        if (g_Wheel[m_Level][m_Slot].Empty())
+            g_Occupied[m_Level] &= ~(uint64_t(1) << m_Slot);
+        --g_Pending;
+        //the alarm is left armed: one idle wake up is cheaper than re-arming
+    }
+
+    void WheelTimer::Place(WheelTimer *pT)
+    {
+        //the lowest level where the expiry is less than a full rotation away.
+        //From the delta, not from e >> shift: the tick counter wraps (~497 days)
+        const uint32_t e = pT->m_Expiry;
+        const uint32_t d = e - g_Current;//never in the past
+        uint32_t level = 0;
+        auto slots_away = [&](uint32_t shift){ return ((g_Current & ((uint32_t(1) << shift) - 1)) + d) >> shift; };
+        while(level < (kLevels - 1) && slots_away(kSlotBits * level) >= kSlots)
+            ++level;
+        const uint32_t slot = (e >> (kSlotBits * level)) & (kSlots - 1);
+        pT->m_Level = level;
+        pT->m_Slot = slot;
+
+        Slot &s = g_Wheel[level][slot];
+        Link *pL = &pT->m_Link;
+        pL->m_pPrev = s.m_pPrev;
+        pL->m_pNext = &s;
+        s.m_pPrev->m_pNext = pL;
+        s.m_pPrev = pL;
+        g_Occupied[level] |= uint64_t(1) << slot;
+    }
+
+    void WheelTimer::Unlink(Link *pL)
+    {
+        pL->m_pPrev->m_pNext = pL->m_pNext;
+        pL->m_pNext->m_pPrev = pL->m_pPrev;
+        pL->m_pPrev = pL->m_pNext = nullptr;
+    }
+
+    //the next tick when a level 0 slot fires or a higher level slot is spread down
+    bool WheelTimer::NextEvent(uint32_t &tick)
+    {
+        bool found = false;
+        for(uint32_t level = 0; level < kLevels; ++level)
+        {
+            if (!g_Occupied[level])
+                continue;
+            const uint32_t shift = kSlotBits * level;
+            const uint32_t cur = g_Current >> shift;
+            const uint64_t r = std::rotr(g_Occupied[level], int(cur & (kSlots - 1)));
+            uint32_t k = std::countr_zero(r);
+            if (!k && level)
+                k = (r >> 1) ? std::countr_zero(r >> 1) + 1 : kSlots;//current slot of a higher level: next rotation
+            const uint32_t t = (cur + k) << shift;
+            if (!found || int32_t(t - tick) < 0)
+                tick = t;
+            found = true;
+        }
+        return found;
+    }
+
+    void WheelTimer::Advance(uint32_t now)
+    {
+        auto detach = [](Slot &from, Slot &to, uint32_t level, uint32_t idx){
+            to.m_pNext = from.m_pNext;
+            to.m_pPrev = from.m_pPrev;
+            to.m_pNext->m_pPrev = &to;
+            to.m_pPrev->m_pNext = &to;
+            from.m_pNext = from.m_pPrev = &from;
+            g_Occupied[level] &= ~(uint64_t(1) << idx);
+        };
+
+        g_InAdvance = true;
+        uint32_t t;
+        while(NextEvent(t) && int32_t(t - now) <= 0)
+        {
+            if (int32_t(t - g_Current) > 0)
+                g_Current = t;
+
+            //spread down the higher level slots starting at this tick
+            for(uint32_t level = kLevels - 1; level > 0; --level)
+            {
+                const uint32_t shift = kSlotBits * level;
+                if (g_Current & ((uint32_t(1) << shift) - 1))
+                    continue;
+                const uint32_t idx = (g_Current >> shift) & (kSlots - 1);
+                Slot &s = g_Wheel[level][idx];
+                if (s.Empty())
+                    continue;
+                Slot local;
+                detach(s, local, level, idx);
+                while(!local.Empty())
+                {
+                    Link *pL = local.m_pNext;
+                    Unlink(pL);
+                    Place(FromLink(pL));
+                }
+            }
+
+            const uint32_t idx = g_Current & (kSlots - 1);
+            Slot &s = g_Wheel[0][idx];
+            if (s.Empty())
+                continue;
+            //callbacks may set up or cancel any timer, including the ones still in 'local'
+            Slot local;
+            detach(s, local, 0, idx);
+            while(!local.Empty())
+            {
+                Link *pL = local.m_pNext;
+                Unlink(pL);
+                --g_Pending;
+                WheelTimer *pT = FromLink(pL);
+                pT->m_Callback(pT->m_pParam);
+            }
+        }
+        if (int32_t(now - g_Current) > 0)
+            g_Current = now;
+        g_InAdvance = false;
+    }
+
+    void WheelTimer::Arm()
+    {
+        uint32_t t;
+        if (!NextEvent(t))
+        {
+            g_WheelAlarm.Cancel();
+            g_Armed = false;
+            return;
+        }
+        constexpr int64_t kTickUs = kTickMs * 1000;
+        const int64_t nowUs = esp_timer_get_time();
+        const int64_t delayUs = int64_t(int32_t(t - uint32_t(nowUs / kTickUs))) * kTickUs - nowUs % kTickUs;
+        g_WheelAlarm.Cancel();
+        g_WheelAlarm.Setup(on_alarm, nullptr, delayUs > 0 ? uint32_t((delayUs + 999) / 1000) : 0);
+        g_ArmedTick = t;
+        g_Armed = true;
+    }
+
+    void WheelTimer::on_alarm(void *)
+    {
+        g_Armed = false;
+        Advance(NowTick());
+        Arm();
+    }
+}
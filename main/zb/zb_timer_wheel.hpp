@@ -0,0 +1,106 @@
+#ifndef ZB_TIMER_WHEEL_HPP_
+#define ZB_TIMER_WHEEL_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace zb
+{
+    /**********************************************************************/
+    /* Timer wheel                                                        */
+    /**********************************************************************/
+    //Any number of logical timers on top of a single zigbee scheduler alarm.
+    //Hierarchical wheel: kLevels levels of kSlots slots, a slot of level L
+    //covers kSlots^L ticks. Timers are intrusive list nodes: insert and cancel
+    //are O(1), nothing is allocated and no alarm handle is taken per timer.
+    //The alarm is only armed for the next tick that has something to do
+    //(a timer to fire or a slot of a higher level to spread down).
+    //Zigbee task (or APILock) only.
+    class WheelTimer
+    {
+    public:
+        using callback_t = void(*)(void*);
+        static constexpr uint32_t kTickMs = 10;
+        static constexpr uint32_t kSlotBits = 6;
+        static constexpr uint32_t kSlots = 1 << kSlotBits;
+        static constexpr uint32_t kLevels = 4;
+        static constexpr uint32_t kMaxDelayTicks = (kSlots - 1) << (kSlotBits * (kLevels - 1));//~45h, longer is clamped
+
+        WheelTimer() = default;
+        ~WheelTimer() { Cancel(); }
+        WheelTimer(WheelTimer const&) = delete;
+        WheelTimer& operator=(WheelTimer const&) = delete;
+
+        //re-arms if already running
+        void Setup(callback_t cb, void *param, uint32_t ms);
+        void Cancel();
+        bool IsRunning() const { return m_Link.m_pNext != nullptr; }
+
+        //timers currently armed (diagnostics)
+        static size_t Pending() { return g_Pending; }
+    private:
+        struct Link
+        {
+            Link *m_pPrev = nullptr;
+            Link *m_pNext = nullptr;
+        };
+        //a slot is a circular list with itself as the sentinel
+        struct Slot: Link
+        {
+            Slot() { m_pPrev = m_pNext = this; }
+            bool Empty() const { return m_pNext == this; }
+        };
+
+        Link m_Link;//not linked - not running
+        uint32_t m_Expiry = 0;//tick
+        callback_t m_Callback = nullptr;
+        void *m_pParam = nullptr;
+        uint8_t m_Level = 0;
+        uint8_t m_Slot = 0;
+
+        static WheelTimer* FromLink(Link *pL) { return reinterpret_cast<WheelTimer*>(reinterpret_cast<uint8_t*>(pL) - offsetof(WheelTimer, m_Link)); }
+
+        static uint32_t NowTick();
+        static void Place(WheelTimer *pT);
+        static void Unlink(Link *pL);
+        static bool NextEvent(uint32_t &tick);
+        static void Advance(uint32_t now);
+        static void Arm();
+        static void on_alarm(void *);
+
+        static Slot g_Wheel[kLevels][kSlots];
+        static uint64_t g_Occupied[kLevels];//bit per non-empty slot
+        static uint32_t g_Current;//last processed tick
+        static uint32_t g_ArmedTick;
+        static bool g_Armed;
+        static bool g_InAdvance;
+        static size_t g_Pending;
+    };
+
+    //Same as WheelTimer but calls a small callable object (a lambda with up to 16 bytes of captures)
+    class WheelTimerExt16: WheelTimer
+    {
+    public:
+        static constexpr size_t kStorage = 16;
+
+        template<class F>
+        void Setup(F &&f, uint32_t ms)
+        {
+            using Fn = std::decay_t<F>;
+            static_assert(sizeof(Fn) <= kStorage, "captures are too big");
+            static_assert(std::is_trivially_copyable_v<Fn> && std::is_trivially_destructible_v<Fn>);
+            Cancel();
+            new (m_Storage) Fn(std::forward<F>(f));
+            WheelTimer::Setup([](void *p){ (*std::launder(reinterpret_cast<Fn*>(p)))(); }, m_Storage, ms);
+        }
+
+        using WheelTimer::Cancel;
+        using WheelTimer::IsRunning;
+    private:
+        alignas(void*) uint8_t m_Storage[kStorage];
+    };
+}
+#endif
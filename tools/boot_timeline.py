@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""Renders the boot_timeline attribute of the presence sensor (see main/zb/zb_boot_timeline.hpp).
+
+Input, from the command line or from stdin, is one of:
+  - the boot_timeline value published by Z2M (z2m/esp32c6.js), the text
+    "reset 3, 1 sensor attempts: app 0, nvs 12, ..., presence 5321ms; reset 1, ...",
+    or the whole MQTT payload holding it ({"boot_timeline": "reset 3, ..."});
+  - the raw attribute value as hex ("01 0c 01 00 ...") or as a JSON byte
+    array ([1, 12, 1, 0, ...]), e.g. read by other means than the converter.
+
+    tools/boot_timeline.py 'reset 3, 1 sensor attempts: app 0, nvs 12, presence 5321ms'
+    mosquitto_sub -C 1 -t zigbee2mqtt/<device> | tools/boot_timeline.py
+    tools/boot_timeline.py 010c0100...
+"""
+import json
+import re
+import struct
+import sys
+
+FORMAT_VERSION = 1
+NOT_REACHED = 0xFFFF
+BAR_WIDTH = 50
+
+# must match BootTimeline::Phase
+PHASES = [
+    "app_main",
+    "nvs_init",
+    "platform_config",
+    "config_loaded",
+    "zb_init",
+    "device_registered",
+    "zb_started",
+    "stack_ready",
+    "joined",
+    "sensor_setup",
+    "sensor_ready",
+    "first_presence",
+]
+
+# phase names used by the Z2M converter, same order
+Z2M_PHASES = [
+    "app", "nvs", "platform", "config", "zb_init", "registered", "zb_started",
+    "stack_ready", "joined", "sensor_setup", "sensor_ready", "presence",
+]
+
+# esp_reset_reason_t
+RESET_REASONS = [
+    "unknown", "power on", "external pin", "software", "panic", "interrupt wdt",
+    "task wdt", "other wdt", "deep sleep", "brownout", "sdio", "usb", "jtag",
+    "efuse", "power glitch", "cpu lockup",
+]
+
+
+Z2M_BOOT = re.compile(r"^reset (\d+), (\d+) sensor attempts: (.*?)(?:ms)?$")
+
+
+def parse_z2m(text):
+    """The converter drops the phases that were not reached."""
+    if text == "<none>":
+        return []
+    boots = []
+    for boot in text.split("; "):
+        m = Z2M_BOOT.match(boot.strip())
+        if not m:
+            raise ValueError("unexpected boot record: %r" % boot)
+        marks = {}
+        for mark in filter(None, m.group(3).split(", ")):
+            name, ms = mark.rsplit(" ", 1)
+            p = Z2M_PHASES.index(name) if name in Z2M_PHASES else int(name)
+            marks[p] = int(ms)
+        phases = max([len(PHASES)] + [p + 1 for p in marks])
+        boots.append((int(m.group(1)), int(m.group(2)),
+                      tuple(marks.get(p, NOT_REACHED) for p in range(phases))))
+    return boots
+
+
+def parse_input(text):
+    """Returns the boots: (reset reason, sensor attempts, marks), the current one first."""
+    text = text.strip()
+    if text.startswith("{"):
+        text = json.loads(text)["boot_timeline"]
+    if text.startswith("reset ") or text == "<none>":
+        return parse_z2m(text)
+    if text.startswith("["):
+        return parse(bytes(json.loads(text)))
+    return parse(bytes.fromhex(text.replace(" ", "").replace(":", "")))
+
+
+def parse(data):
+    if len(data) < 2 or data[0] != FORMAT_VERSION:
+        raise ValueError("unsupported boot timeline format")
+    phases = data[1]
+    record_size = 2 + phases * 2
+    boots = []
+    for off in range(2, len(data) - record_size + 1, record_size):
+        reset_reason, attempts = data[off], data[off + 1]
+        if reset_reason == 0xFF:
+            continue  # no such boot
+        marks = struct.unpack_from("<%dH" % phases, data, off + 2)
+        boots.append((reset_reason, attempts, marks))
+    return boots
+
+
+def render(boots):
+    lines = []
+    for i, (reset_reason, attempts, marks) in enumerate(boots):
+        reached = [ms for ms in marks if ms != NOT_REACHED]
+        total = max(reached) if reached else 0
+        reason = RESET_REASONS[reset_reason] if reset_reason < len(RESET_REASONS) else str(reset_reason)
+        lines.append("Boot %s: reset by %s, sensor setup attempts: %d, %d ms total"
+                     % ("current" if i == 0 else "-%d" % i, reason, attempts, total))
+        for p, ms in enumerate(marks):
+            name = PHASES[p] if p < len(PHASES) else "phase_%d" % p
+            if ms == NOT_REACHED:
+                lines.append("  %-18s %8s" % (name, "-"))
+                continue
+            # sensor setup runs in its own task: the phases are not strictly sequential,
+            # a bar starts at the latest mark before it
+            prev = max([t for t in reached if t < ms], default=0)
+            start = prev * BAR_WIDTH // total if total else 0
+            end = max(ms * BAR_WIDTH // total if total else 0, start + 1)
+            bar = " " * start + "#" * (end - start)
+            lines.append("  %-18s %6d ms +%6d ms |%-*s|" % (name, ms, ms - prev, BAR_WIDTH, bar))
+        lines.append("")
+    return "\n".join(lines)
+
+
+def main():
+    text = " ".join(sys.argv[1:]) if len(sys.argv) > 1 else sys.stdin.read()
+    boots = parse_input(text)
+    if not boots:
+        print("no boots recorded")
+        return
+    print(render(boots))
+
+
+if __name__ == "__main__":
+    main()
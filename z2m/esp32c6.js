@@ -17,6 +17,38 @@ const ea = exposes.access;
 
 const NS = 'zhc:orlangur';
 
+//Written config doesn't come back on its own (and the device may adjust
+//related settings): each config converter schedules a refresh after its write,
+//once a burst of writes is over everything comes with a single snapshot
+const kConfigRefreshDelayMs = 1000;
+const configRefreshTimers = new Map();
+const scheduleConfigRefresh = (device) => {
+    if (!device)
+        return;
+    clearTimeout(configRefreshTimers.get(device.ieeeAddr));
+    configRefreshTimers.set(device.ieeeAddr, setTimeout(async () => {
+        configRefreshTimers.delete(device.ieeeAddr);
+        try {
+            await device.getEndpoint(1).command('customOccupationConfig', 'config_snapshot', {}, {disableDefaultResponse: true});
+        } catch (error) {
+            logger.warning(`Config refresh of ${device.ieeeAddr} failed: ${error}`, NS);
+        }
+    }, kConfigRefreshDelayMs));
+};
+
+//config attributes defined with modernExtend: their convertSet followed by the refresh
+const withConfigRefresh = (ext) => ({
+    ...ext,
+    toZigbee: ext.toZigbee.map((c) => !c.convertSet ? c : {
+        ...c,
+        convertSet: async (entity, key, value, meta) => {
+            const result = await c.convertSet(entity, key, value, meta);
+            scheduleConfigRefresh(meta.device);
+            return result;
+        },
+    }),
+});
+
 const orlangurOccupactionExtended = {
     reset_energy_stat: () => {
         const exposes = [
@@ -57,9 +89,7 @@ const orlangurOccupactionExtended = {
                     {
                         await utils.sleep(5000);
                         const endpoint = meta.device.getEndpoint(1);
-                        await endpoint.read('msOccupancySensing', ['occupancy','ultrasonicOToUDelay']);
-                        await endpoint.read('customOccupationConfig', ['stillSensitivity','moveSensitivity','state']);
-                        await endpoint.read('customOccupationConfig', ['min_distance', 'max_distance']);
+                        await endpoint.command('customOccupationConfig', 'config_snapshot', {}, {disableDefaultResponse: true});
                     }
                 },
             },
@@ -118,6 +148,7 @@ const orlangurOccupactionExtended = {
                     const payload = {[key]: lookup[value]}
                     const endpoint = meta.device.getEndpoint(1);
                     await entity.write('customOccupationConfig', payload);
+                    scheduleConfigRefresh(meta.device);
                     return {state: {[key]: value}};
                 },
                 convertGet: async (entity, key, meta) => {
@@ -244,6 +275,7 @@ const orlangurOccupactionExtended = {
                 //update the requested bit
                 const newVal = (readResult.presence_detection_config & ~(1 << cfg_bits[key])) | (value << cfg_bits[key])
                 await entity.write('customOccupationConfig', {['presence_detection_config']: newVal});
+                scheduleConfigRefresh(meta.device);
                 return {state: {[key]: value}};
             },
             convertGet: async (entity, key, meta) => {
@@ -294,6 +326,7 @@ const orlangurOccupactionExtended = {
                 convertSet: async (entity, key, value, meta) => {
                     const payload = {[key]: value}
                     await entity.write('customOccupationConfig', payload);
+                    scheduleConfigRefresh(meta.device);
                     return {state: {[key]: value}};
                 },
                 convertGet: async (entity, key, meta) => {
@@ -578,6 +611,423 @@ const orlangurOccupactionExtended = {
             isModernExtend: true,
         };
     },
+    zones: () => {
+        const kZones = 4;
+        const fields = ['first_gate', 'last_gate', 'move_threshold', 'still_threshold'];
+        const exposes = [];
+        for(var z = 0; z < kZones; ++z)
+        {
+            const cfg = e.composite('zone' + (z + 1), 'zone' + (z + 1), ea.ALL)
+                            .withLabel('Zone ' + (z + 1)).withCategory('config')
+                            .withDescription('Gate range and energy thresholds of the zone (both thresholds 0 - disabled)');
+            cfg.withFeature(e.numeric('first_gate', ea.STATE_SET).withValueMin(0).withValueMax(13));
+            cfg.withFeature(e.numeric('last_gate', ea.STATE_SET).withValueMin(0).withValueMax(13));
+            cfg.withFeature(e.numeric('move_threshold', ea.STATE_SET).withValueMin(0).withValueMax(100));
+            cfg.withFeature(e.numeric('still_threshold', ea.STATE_SET).withValueMin(0).withValueMax(100));
+            exposes.push(cfg);
+            exposes.push(e.binary('zone' + (z + 1) + '_occupancy', ea.STATE_GET, true, false)
+                            .withLabel('Zone ' + (z + 1) + ' occupancy')
+                            .withDescription('Occupancy of the zone (energy mode only)'));
+        }
+
+        const fromZigbee = [{
+                cluster: 'customOccupationConfig',
+                type: ['attributeReport', 'readResponse'],
+                convert: (model, msg, publish, options, meta) => {
+                    const result = {};
+                    const data = msg.data;
+                    if ('zones_config' in data)
+                    {
+                        const buffer = Buffer.from(data['zones_config']);
+                        if (buffer.length == kZones * 4)
+                        {
+                            for(var z = 0; z < kZones; ++z)
+                            {
+                                const res = {};
+                                for(var f = 0; f < 4; ++f)
+                                    res[fields[f]] = buffer[z * 4 + f];
+                                result['zone' + (z + 1)] = res;
+                            }
+                        }
+                    }
+                    if (data['zones_occupancy'] !== undefined)
+                    {
+                        for(var z = 0; z < kZones; ++z)
+                            result['zone' + (z + 1) + '_occupancy'] = (data['zones_occupancy'] & (1 << z)) != 0;
+                    }
+                    return result;
+                }
+            }
+        ];
+
+        const toZigbee = [
+            {
+                key: ['zone1', 'zone2', 'zone3', 'zone4'],
+                convertSet: async (entity, key, value, meta) => {
+                    const payloadValue = [];
+                    for(var z = 0; z < kZones; ++z)
+                    {
+                        const zoneKey = 'zone' + (z + 1);
+                        const zone = zoneKey == key ? value : (meta.state[zoneKey] || {});
+                        for(var f = 0; f < 4; ++f)
+                            payloadValue[z * 4 + f] = zone[fields[f]] || 0;
+                    }
+                    await entity.write('customOccupationConfig', {zones_config: payloadValue});
+                    scheduleConfigRefresh(meta.device);
+                    return {state: {[key]: value}};
+                },
+                convertGet: async (entity, key, meta) => {
+                    await entity.read('customOccupationConfig', ['zones_config']);
+                },
+            },
+        ];
+
+        return {
+            exposes,
+            fromZigbee,
+            toZigbee,
+            isModernExtend: true,
+        };
+    },
+    bindDeliveryStats: () => {
+        const kHeaderSize = 5;
+        const kRecordSize = 12;
+        const kPerPage = 4;
+        //records of the pages read so far, per device
+        const pagesCache = {};
+        const exposes = [
+            e.text('bind_delivery_stats', ea.STATE_GET).withCategory('diagnostic')
+                .withDescription('Per bound device (per bind delivery only): sent/failed/retries commands, avg/max delivery latency'),
+        ];
+
+        const fromZigbee = [{
+                cluster: 'customOccupationConfig',
+                type: ['attributeReport', 'readResponse'],
+                convert: (model, msg, publish, options, meta) => {
+                    const data = msg.data;
+                    if (!('bind_delivery_stats' in data))
+                        return;
+                    const buffer = Buffer.from(data['bind_delivery_stats']);
+                    if (buffer.length < kHeaderSize)
+                        return;
+                    const first = buffer.readUInt8(0);
+                    const total = buffer.readUInt8(1);
+                    const maxBinds = buffer.readUInt8(2);
+                    const memPerBind = buffer.readUInt16LE(3);
+                    const key = msg.device.ieeeAddr;
+                    const binds = (pagesCache[key] || []).slice(0, total);
+                    for(var off = kHeaderSize, i = first; off + kRecordSize <= buffer.length; off += kRecordSize, ++i)
+                    {
+                        const addr = buffer.readUInt16LE(off).toString(16).padStart(4, '0');
+                        const sent = buffer.readUInt16LE(off + 2);
+                        const failed = buffer.readUInt16LE(off + 4);
+                        const retries = buffer.readUInt16LE(off + 6);
+                        const avg = buffer.readUInt16LE(off + 8);
+                        const max = buffer.readUInt16LE(off + 10);
+                        binds[i] = `0x${addr}: ${sent} sent, ${failed} failed, ${retries} retries, ${avg}/${max}ms`;
+                    }
+                    pagesCache[key] = binds;
+                    const known = binds.filter((b) => b !== undefined);
+                    const summary = `${total}/${maxBinds} binds, ${memPerBind} bytes per bind`;
+                    return {bind_delivery_stats: known.length ? `${summary}; ${known.join('; ')}` : `${summary}; <no binds>`};
+                }
+            }
+        ];
+
+        const toZigbee = [
+            {
+                key: ['bind_delivery_stats'],
+                convertGet: async (entity, key, meta) => {
+                    //one page per read, each fits a single frame
+                    for(var page = 0; ; ++page)
+                    {
+                        await entity.write('customOccupationConfig', {bind_delivery_stats_page: page});
+                        const r = await entity.read('customOccupationConfig', ['bind_delivery_stats']);
+                        const buffer = Buffer.from((r && r.bind_delivery_stats) || []);
+                        if (buffer.length < kHeaderSize || (page + 1) * kPerPage >= buffer.readUInt8(1))
+                            break;
+                    }
+                },
+            }
+        ];
+
+        return {
+            exposes,
+            fromZigbee,
+            toZigbee,
+            isModernExtend: true,
+        };
+    },
+    configWriteStats: () => {
+        const exposes = [
+            e.text('config_write_stats', ea.STATE_GET).withCategory('diagnostic')
+                .withDescription('Config changes and the flash writes they took (changes are written with a delay, several at once)'),
+        ];
+
+        const fromZigbee = [{
+                cluster: 'customOccupationConfig',
+                type: ['attributeReport', 'readResponse'],
+                convert: (model, msg, publish, options, meta) => {
+                    const data = msg.data;
+                    if (!('config_write_stats' in data))
+                        return;
+                    const buffer = Buffer.from(data['config_write_stats']);
+                    if (buffer.length < 16)
+                        return;
+                    const changes = buffer.readUInt32LE(0);
+                    const writes = buffer.readUInt32LE(4);
+                    const bytes = buffer.readUInt32LE(8);
+                    const failures = buffer.readUInt32LE(12);
+                    return {config_write_stats: `${changes} changes, ${writes} writes (${bytes} bytes), ${failures} failed`};
+                }
+            }
+        ];
+
+        const toZigbee = [
+            {
+                key: ['config_write_stats'],
+                convertGet: async (entity, key, meta) => {
+                    await entity.read('customOccupationConfig', ['config_write_stats']);
+                },
+            }
+        ];
+
+        return {
+            exposes,
+            fromZigbee,
+            toZigbee,
+            isModernExtend: true,
+        };
+    },
+    bootTimeline: () => {
+        //must match BootTimeline::Phase, tools/boot_timeline.py renders the full timeline
+        const kPhases = ['app', 'nvs', 'platform', 'config', 'zb_init', 'registered', 'zb_started', 'stack_ready', 'joined', 'sensor_setup', 'sensor_ready', 'presence'];
+        const kNotReached = 0xffff;
+        const exposes = [
+            e.text('boot_timeline', ea.STATE_GET).withCategory('diagnostic')
+                .withDescription('Time from power up to each boot phase for the current and the previous boot'),
+        ];
+
+        const fromZigbee = [{
+                cluster: 'customOccupationConfig',
+                type: ['attributeReport', 'readResponse'],
+                convert: (model, msg, publish, options, meta) => {
+                    const data = msg.data;
+                    if (!('boot_timeline' in data))
+                        return;
+                    const buffer = Buffer.from(data['boot_timeline']);
+                    if (buffer.length < 2 || buffer[0] != 1)
+                        return;
+                    const phases = buffer[1];
+                    const recordSize = 2 + phases * 2;
+                    const boots = [];
+                    for(var off = 2; off + recordSize <= buffer.length; off += recordSize)
+                    {
+                        const resetReason = buffer[off];
+                        if (resetReason == 0xff)
+                            continue;//no such boot
+                        const marks = [];
+                        for(var p = 0; p < phases; ++p)
+                        {
+                            const ms = buffer.readUInt16LE(off + 2 + p * 2);
+                            if (ms != kNotReached)
+                                marks.push(`${p < kPhases.length ? kPhases[p] : p} ${ms}`);
+                        }
+                        boots.push(`reset ${resetReason}, ${buffer[off + 1]} sensor attempts: ${marks.join(', ')}ms`);
+                    }
+                    return {boot_timeline: boots.length ? boots.join('; ') : '<none>'};
+                }
+            }
+        ];
+
+        const toZigbee = [
+            {
+                key: ['boot_timeline'],
+                convertGet: async (entity, key, meta) => {
+                    await entity.read('customOccupationConfig', ['boot_timeline']);
+                },
+            }
+        ];
+
+        return {
+            exposes,
+            fromZigbee,
+            toZigbee,
+            isModernExtend: true,
+        };
+    },
+    engineeringTelemetry: () => {
+        const kVersion = 1;
+        const kHeaderSize = 10;
+        const arrays = ['move_energy_last', 'still_energy_last', 'move_energy_min', 'still_energy_min', 'move_energy_max', 'still_energy_max'];
+        const exposes = [
+            e.numeric('target_move_distance', ea.STATE).withUnit('cm').withCategory('diagnostic').withDescription('Distance to the moving target'),
+            e.numeric('target_move_energy', ea.STATE).withCategory('diagnostic').withDescription('Energy of the moving target'),
+            e.numeric('target_still_distance', ea.STATE).withUnit('cm').withCategory('diagnostic').withDescription('Distance to the still target'),
+            e.numeric('target_still_energy', ea.STATE).withCategory('diagnostic').withDescription('Energy of the still target'),
+        ];
+        for(const a of arrays)
+            exposes.push(e.text(a, ea.STATE).withCategory('diagnostic').withDescription('Per gate energies (radar in the energy mode only)'));
+
+        //14 values: either first value + 13 4-bit deltas (8 bytes) or 4-bit values >> 3 (7 bytes)
+        const decodeGates = (buffer, off, encoding) => {
+            const nibble = (i) => (buffer[off + (i >> 1)] >> ((i & 1) * 4)) & 0x0f;
+            const values = [];
+            if (encoding == 1)
+            {
+                values.push(buffer[off]);
+                off += 1;
+                for(var i = 0; i < 13; ++i)
+                {
+                    const n = nibble(i);
+                    values.push(values[i] + (n >= 8 ? n - 16 : n));
+                }
+                return [values, 8];
+            }
+            for(var i = 0; i < 14; ++i)
+                values.push(nibble(i) << 3);
+            return [values, 7];
+        };
+
+        const fromZigbee = [{
+                cluster: 'customOccupationConfig',
+                type: ['attributeReport', 'readResponse'],
+                convert: (model, msg, publish, options, meta) => {
+                    const data = msg.data;
+                    if (!('engineering_telemetry' in data))
+                        return;
+                    const buffer = Buffer.from(data['engineering_telemetry']);
+                    if (buffer.length < kHeaderSize || buffer[0] != kVersion)
+                        return;
+                    const result = {
+                        target_move_distance: buffer.readUInt16LE(2),
+                        target_move_energy: buffer[4],
+                        target_still_distance: buffer.readUInt16LE(5),
+                        target_still_energy: buffer[7],
+                    };
+                    const encodings = buffer.readUInt16LE(8);
+                    var off = kHeaderSize;
+                    for(var i = 0; i < arrays.length; ++i)
+                    {
+                        const encoding = (encodings >> (i * 2)) & 3;
+                        if (!encoding)
+                            continue;
+                        const [values, size] = decodeGates(buffer, off, encoding);
+                        result[arrays[i]] = values.join(',');
+                        off += size;
+                    }
+                    return result;
+                }
+            }
+        ];
+
+        return {
+            exposes,
+            fromZigbee,
+            toZigbee: [],
+            isModernExtend: true,
+        };
+    },
+    configSnapshot: () => {
+        //must match kConfigSnapshotVersion: one response per page, each page on its own
+        const kVersion = 4;
+        const exposes = [
+            e.enum('refresh_config', ea.SET, ['Refresh']).withLabel('Refresh configuration').withCategory('config')
+                .withDescription('Get the whole configuration and state in one go'),
+        ];
+
+        const fromZigbee = [{
+                cluster: 'customOccupationConfig',
+                type: ['commandConfigSnapshot'],
+                convert: (model, msg, publish, options, meta) => {
+                    const buffer = Buffer.from(msg.data.data);
+                    if (buffer.length < 3 || buffer[0] != kVersion)
+                        return;
+                    const page = buffer[1];
+                    var off = 3;
+                    const u8 = () => buffer.readUInt8(off++);
+                    const u16 = () => { const v = buffer.readUInt16LE(off); off += 2; return v; };
+                    const bytes = (n) => { const v = buffer.subarray(off, off + n); off += n; return v; };
+
+                    const custom = {};
+                    const occupancySensing = {};
+                    if (page == 0)
+                    {
+                        custom.state = u8();
+                        custom.ex_state = u8();
+                        occupancySensing.occupancy = u8();
+                        custom.pir_presence = u8();
+                        custom.armed_for_trigger = u8();
+                        custom.presence_mode = u8();
+                        custom.distance_resolution = u8();
+                        custom.min_distance = u16();
+                        custom.max_distance = u16();
+                        occupancySensing.ultrasonicOToUDelay = u16();
+                        custom.on_off_mode = u8();
+                        custom.on_off_timeout = u16();
+                        custom.illuminance_threshold = u8();
+                        custom.presence_detection_config = u8();
+                        custom.external_on_time = u16();
+                        custom.measured_light = u8();
+                        custom.approach_distance = u16();
+                        custom.noise_floor_tracking = u8();
+                        custom.noise_floor_max_delta = u8();
+                        custom.per_bind_delivery = u8();
+                        custom.active_reporting_check = u8();
+                        custom.report_distance_deadband = u16();
+                        custom.report_distance_min_interval = u16();
+                        custom.report_distance_max_interval = u16();
+                        custom.report_energy_deadband = u16();
+                        custom.report_energy_min_interval = u16();
+                        custom.report_energy_max_interval = u16();
+                        custom.report_adaptive = u8();
+                    }
+                    else if (page == 1)
+                    {
+                        custom.moveSensitivity = bytes(14);
+                        custom.stillSensitivity = bytes(14);
+                        custom.zones_config = bytes(16);
+                    }
+                    else
+                        return;
+
+                    //feed the regular attribute converters as if all of it was read
+                    const result = {};
+                    const feed = (cluster, data) => {
+                        for (const c of model.fromZigbee)
+                        {
+                            const types = Array.isArray(c.type) ? c.type : [c.type];
+                            if (c.cluster != cluster || !types.includes('readResponse'))
+                                continue;
+                            const r = c.convert(model, {...msg, cluster: cluster, type: 'readResponse', data: data}, publish, options, meta);
+                            if (r)
+                                Object.assign(result, r);
+                        }
+                    };
+                    feed('customOccupationConfig', custom);
+                    if (Object.keys(occupancySensing).length)
+                        feed('msOccupancySensing', occupancySensing);
+                    return result;
+                }
+            }
+        ];
+
+        const toZigbee = [
+            {
+                key: ['refresh_config'],
+                convertSet: async (entity, key, value, meta) => {
+                    await entity.command('customOccupationConfig', 'config_snapshot', {}, {disableDefaultResponse: true});
+                },
+            }
+        ];
+
+        return {
+            exposes,
+            fromZigbee,
+            toZigbee,
+            isModernExtend: true,
+        };
+    },
     sensitivity: (prefix, descr) => {
         const attr = prefix + 'Sensitivity'
         const exp_entity = prefix + '_sensitivity'
@@ -636,6 +1086,7 @@ const orlangurOccupactionExtended = {
                     }
                     const payload = {[attr]: payloadValue}
                     await entity.write('customOccupationConfig', payload);
+                    scheduleConfigRefresh(meta.device);
                     return {state: {[key]: value}};
                 },
                 convertGet: async (entity, key, meta) => {
@@ -673,22 +1124,12 @@ const definition = {
             attributes: {
                 moveSensitivity: {ID: 0x0000, type: Zcl.DataType.OCTET_STR},
                 stillSensitivity: {ID: 0x0001, type: Zcl.DataType.OCTET_STR},
-                moveEnergy: {ID: 0x0002, type: Zcl.DataType.UINT8},
-                stillEnergy: {ID: 0x0003, type: Zcl.DataType.UINT8},
-                moveDistance: {ID: 0x0004, type: Zcl.DataType.UINT16},
-                stillDistance: {ID: 0x0005, type: Zcl.DataType.UINT16},
                 state: {ID: 0x0006, type: Zcl.DataType.ENUM8},
                 min_distance: {ID: 0x0007, type: Zcl.DataType.UINT16},
                 max_distance: {ID: 0x0008, type: Zcl.DataType.UINT16},
                 ex_state: {ID: 0x0009, type: Zcl.DataType.ENUM8},
                 presence_mode: {ID: 0x000a, type: Zcl.DataType.ENUM8},
                 measured_light: {ID: 0x000b, type: Zcl.DataType.UINT8},
-                move_energy_last: {ID: 0x000c, type: Zcl.DataType.OCTET_STR},
-                still_energy_last: {ID: 0x000d, type: Zcl.DataType.OCTET_STR},
-                move_energy_min: {ID: 0x000e, type: Zcl.DataType.OCTET_STR},
-                still_energy_min: {ID: 0x000f, type: Zcl.DataType.OCTET_STR},
-                move_energy_max: {ID: 0x0010, type: Zcl.DataType.OCTET_STR},
-                still_energy_max: {ID: 0x0011, type: Zcl.DataType.OCTET_STR},
                 pir_presence: {ID: 0x0012, type: Zcl.DataType.BOOLEAN},
                 on_off_mode: {ID: 0x0013, type: Zcl.DataType.ENUM8},
                 on_off_timeout: {ID: 0x0014, type: Zcl.DataType.UINT16},
@@ -702,6 +1143,27 @@ const definition = {
                 internals: {ID:0x001e, type: Zcl.DataType.UINT32},
                 restarts_count: {ID:0x001f, type: Zcl.DataType.UINT16},
                 internals2: {ID:0x0021, type: Zcl.DataType.UINT32},
+                report_distance_deadband: {ID:0x0022, type: Zcl.DataType.UINT16},
+                report_distance_min_interval: {ID:0x0023, type: Zcl.DataType.UINT16},
+                report_distance_max_interval: {ID:0x0024, type: Zcl.DataType.UINT16},
+                report_energy_deadband: {ID:0x0025, type: Zcl.DataType.UINT16},
+                report_energy_min_interval: {ID:0x0026, type: Zcl.DataType.UINT16},
+                report_energy_max_interval: {ID:0x0027, type: Zcl.DataType.UINT16},
+                report_adaptive: {ID:0x0028, type: Zcl.DataType.BOOLEAN},
+                approach_distance: {ID:0x0029, type: Zcl.DataType.UINT16},
+                approach_speed: {ID:0x002a, type: Zcl.DataType.INT16},
+                noise_floor_tracking: {ID:0x002b, type: Zcl.DataType.BOOLEAN},
+                noise_floor_max_delta: {ID:0x002c, type: Zcl.DataType.UINT8},
+                zones_config: {ID:0x002d, type: Zcl.DataType.OCTET_STR},
+                zones_occupancy: {ID:0x002e, type: Zcl.DataType.UINT8},
+                per_bind_delivery: {ID:0x002f, type: Zcl.DataType.BOOLEAN},
+                bind_delivery_stats: {ID:0x0030, type: Zcl.DataType.OCTET_STR},
+                engineering_telemetry_enabled: {ID:0x0031, type: Zcl.DataType.BOOLEAN},
+                engineering_telemetry: {ID:0x0032, type: Zcl.DataType.OCTET_STR},
+                active_reporting_check: {ID:0x0033, type: Zcl.DataType.BOOLEAN},
+                config_write_stats: {ID:0x0034, type: Zcl.DataType.OCTET_STR},
+                boot_timeline: {ID:0x0035, type: Zcl.DataType.OCTET_STR},
+                bind_delivery_stats_page: {ID:0x0036, type: Zcl.DataType.UINT8},
             },
             commands: {
                 restart: {
@@ -724,11 +1186,21 @@ const definition = {
                     ID: 0x0004,
                     parameters: [],
                 },
+                config_snapshot: {
+                    ID: 0x0005,
+                    parameters: [],
+                },
+            },
+            commandsResponse: {
+                configSnapshot: {
+                    ID: 0x0000,
+                    parameters: [{name: 'data', type: Zcl.DataType.OCTET_STR}],
+                },
             },
-            commandsResponse: {},
         }),
         orlangurOccupactionExtended.commands(),
-        numeric({
+        orlangurOccupactionExtended.configSnapshot(),
+        withConfigRefresh(numeric({
             name: 'presence_timeout',
             cluster: 'msOccupancySensing',
             attribute: 'ultrasonicOToUDelay',
@@ -737,7 +1209,7 @@ const definition = {
             valueMax: 120,
             access: 'ALL',
             entityCategory: 'config',
-        }),
+        })),
         enumLookup({
             name: 'presence_state',
             access: 'STATE_GET',
@@ -748,7 +1220,7 @@ const definition = {
             entityCategory: 'diagnostic',
         }),
         orlangurOccupactionExtended.onOff(),
-        numeric({
+        withConfigRefresh(numeric({
             name: 'external_on_time',
             cluster: 'customOccupationConfig',
             attribute: 'external_on_time',
@@ -757,7 +1229,7 @@ const definition = {
             valueMax: 120,
             access: 'ALL',
             entityCategory: 'config',
-        }),
+        })),
         enumLookup({
             name: 'pir_presence',
             access: 'STATE_GET',
@@ -785,7 +1257,7 @@ const definition = {
             description: 'Can be triggered again'
         }),
         orlangurOccupactionExtended.mode(),
-        enumLookup({
+        withConfigRefresh(enumLookup({
             name: 'on_off_mode',
             access: 'ALL',
             cluster: 'customOccupationConfig',
@@ -793,8 +1265,8 @@ const definition = {
             description: 'On/Off Command Mode',
             lookup: {OnOff: 0, OnOnly: 1, OffOnly: 2, TimedOn: 3, TimedOnLocal: 4, Nothing: 5},
             entityCategory: 'config',
-        }),
-        numeric({
+        })),
+        withConfigRefresh(numeric({
             name: 'on_off_timeout',
             cluster: 'customOccupationConfig',
             attribute: 'on_off_timeout',
@@ -803,8 +1275,8 @@ const definition = {
             valueMax: 1000,
             access: 'ALL',
             entityCategory: 'config',
-        }),
-        enumLookup({
+        })),
+        withConfigRefresh(enumLookup({
             name: 'distance_resolution',
             access: 'ALL',
             cluster: 'customOccupationConfig',
@@ -812,7 +1284,7 @@ const definition = {
             description: 'Distance resolution',
             lookup: {_75cm: 0, _50cm: 1, _20cm: 3},
             entityCategory: 'config',
-        }),
+        })),
         numeric({
             name: 'measured_light',
             cluster: 'customOccupationConfig',
@@ -824,7 +1296,7 @@ const definition = {
             unit: 'lx',
             entityCategory: 'diagnostic',
         }),
-        numeric({
+        withConfigRefresh(numeric({
             name: 'illuminance_threshold',
             cluster: 'customOccupationConfig',
             attribute: 'illuminance_threshold',
@@ -833,7 +1305,7 @@ const definition = {
             valueMax: 255,
             access: 'ALL',
             entityCategory: 'config',
-        }),
+        })),
         numeric({
             name: 'restarts_count',
             cluster: 'customOccupationConfig',
@@ -861,25 +1333,172 @@ const definition = {
                 },
             entityCategory: 'diagnostics',
         }),
+        withConfigRefresh(numeric({
+            name: 'report_distance_deadband',
+            cluster: 'customOccupationConfig',
+            attribute: 'report_distance_deadband',
+            description: 'Minimal distance change to report',
+            valueMin: 0,
+            valueMax: 1200,
+            access: 'ALL',
+            unit: 'cm',
+            entityCategory: 'config',
+        })),
+        withConfigRefresh(numeric({
+            name: 'report_distance_min_interval',
+            cluster: 'customOccupationConfig',
+            attribute: 'report_distance_min_interval',
+            description: 'Minimal interval between distance reports (0 - no limit)',
+            valueMin: 0,
+            valueMax: 60000,
+            access: 'ALL',
+            unit: 'ms',
+            entityCategory: 'config',
+        })),
+        withConfigRefresh(numeric({
+            name: 'report_distance_max_interval',
+            cluster: 'customOccupationConfig',
+            attribute: 'report_distance_max_interval',
+            description: 'Report a distance change within the deadband after this interval (0 - never)',
+            valueMin: 0,
+            valueMax: 3600,
+            access: 'ALL',
+            unit: 's',
+            entityCategory: 'config',
+        })),
+        withConfigRefresh(numeric({
+            name: 'report_energy_deadband',
+            cluster: 'customOccupationConfig',
+            attribute: 'report_energy_deadband',
+            description: 'Minimal energy change to report',
+            valueMin: 0,
+            valueMax: 100,
+            access: 'ALL',
+            entityCategory: 'config',
+        })),
+        withConfigRefresh(numeric({
+            name: 'report_energy_min_interval',
+            cluster: 'customOccupationConfig',
+            attribute: 'report_energy_min_interval',
+            description: 'Minimal interval between energy reports (0 - no limit)',
+            valueMin: 0,
+            valueMax: 60000,
+            access: 'ALL',
+            unit: 'ms',
+            entityCategory: 'config',
+        })),
+        withConfigRefresh(numeric({
+            name: 'report_energy_max_interval',
+            cluster: 'customOccupationConfig',
+            attribute: 'report_energy_max_interval',
+            description: 'Report an energy change within the deadband after this interval (0 - never)',
+            valueMin: 0,
+            valueMax: 3600,
+            access: 'ALL',
+            unit: 's',
+            entityCategory: 'config',
+        })),
+        withConfigRefresh(binary({
+            name: 'report_adaptive',
+            access: 'ALL',
+            cluster: 'customOccupationConfig',
+            attribute: 'report_adaptive',
+            valueOn: ['ON', 1],
+            valueOff: ['OFF', 0],
+            description: 'Widen report deadbands while the sensor pipeline is backlogged',
+            entityCategory: 'config',
+        })),
+        withConfigRefresh(numeric({
+            name: 'approach_distance',
+            cluster: 'customOccupationConfig',
+            attribute: 'approach_distance',
+            description: 'Target moving towards the sensor closer than this triggers presence (0 - disabled)',
+            valueMin: 0,
+            valueMax: 1200,
+            access: 'ALL',
+            unit: 'cm',
+            entityCategory: 'config',
+        })),
+        numeric({
+            name: 'approach_speed',
+            cluster: 'customOccupationConfig',
+            attribute: 'approach_speed',
+            description: 'Smoothed speed of the moving target towards the sensor',
+            access: 'STATE_GET',
+            unit: 'cm/s',
+            entityCategory: 'diagnostic',
+        }),
+        withConfigRefresh(binary({
+            name: 'noise_floor_tracking',
+            access: 'ALL',
+            cluster: 'customOccupationConfig',
+            attribute: 'noise_floor_tracking',
+            valueOn: ['ON', 1],
+            valueOff: ['OFF', 0],
+            description: 'Adjust gate thresholds to the background noise while the room is empty (energy mode only)',
+            entityCategory: 'config',
+        })),
+        withConfigRefresh(numeric({
+            name: 'noise_floor_max_delta',
+            cluster: 'customOccupationConfig',
+            attribute: 'noise_floor_max_delta',
+            description: 'Max deviation of an adjusted threshold from the one set explicitly or by calibration',
+            valueMin: 0,
+            valueMax: 50,
+            access: 'ALL',
+            entityCategory: 'config',
+        })),
+        withConfigRefresh(binary({
+            name: 'per_bind_delivery',
+            access: 'ALL',
+            cluster: 'customOccupationConfig',
+            attribute: 'per_bind_delivery',
+            valueOn: ['ON', 1],
+            valueOff: ['OFF', 0],
+            description: 'Send on/off commands as a unicast with own retries to every bound device instead of the binding table send',
+            entityCategory: 'config',
+        })),
+        withConfigRefresh(binary({
+            name: 'active_reporting_check',
+            access: 'ALL',
+            cluster: 'customOccupationConfig',
+            attribute: 'active_reporting_check',
+            valueOn: ['ON', 1],
+            valueOff: ['OFF', 0],
+            description: 'Verify that a bound device reports its on/off state by toggling it (lights flicker). Otherwise the reporting configuration is only read',
+            entityCategory: 'config',
+        })),
+        binary({
+            name: 'engineering_telemetry',
+            access: 'ALL',
+            cluster: 'customOccupationConfig',
+            attribute: 'engineering_telemetry_enabled',
+            valueOn: ['ON', 1],
+            valueOff: ['OFF', 0],
+            description: 'Publish targets and per gate energies (off after restart)',
+            entityCategory: 'diagnostic',
+        }),
         orlangurOccupactionExtended.presenceModeDetectionConfig(),
         orlangurOccupactionExtended.distanceConfig(),
         orlangurOccupactionExtended.sensitivity('move', 'Move Sensitivity'),
         orlangurOccupactionExtended.sensitivity('still', 'Still Sensitivity'),
+        orlangurOccupactionExtended.zones(),
         orlangurOccupactionExtended.internals(),
+        orlangurOccupactionExtended.bindDeliveryStats(),
+        orlangurOccupactionExtended.configWriteStats(),
+        orlangurOccupactionExtended.bootTimeline(),
+        orlangurOccupactionExtended.engineeringTelemetry(),
         orlangurOccupactionExtended.internals2(),
         orlangurOccupactionExtended.internals3(),
     ],
     configure: async (device, coordinatorEndpoint) => {
         const endpoint = device.getEndpoint(1);
         await reporting.bind(endpoint, coordinatorEndpoint, ['msOccupancySensing', 'customOccupationConfig', 'genOnOff']);
-        await endpoint.read('customOccupationConfig', ['presence_mode','pir_presence']);
-        await endpoint.read('msOccupancySensing', ['occupancy']);
-        await endpoint.read('msOccupancySensing', ['occupancy','ultrasonicOToUDelay']);
-        await endpoint.read('customOccupationConfig', ['min_distance', 'max_distance']);
-        await endpoint.read('customOccupationConfig', ['illuminance_threshold', 'on_off_timeout', 'on_off_mode']);
-        await endpoint.read('customOccupationConfig', ['stillSensitivity','moveSensitivity','state']);
+        //configuration and state in one response
+        await endpoint.command('customOccupationConfig', 'config_snapshot', {}, {disableDefaultResponse: true});
         await endpoint.read('customOccupationConfig', ['failure_status', 'internals', 'internals2', 'internals3']);
-        await endpoint.read('customOccupationConfig', [ 'presence_detection_config', 'armed_for_trigger', 'distance_resolution' ]);
+        await endpoint.read('customOccupationConfig', ['zones_occupancy', 'bind_delivery_stats', 'config_write_stats']);
+        await endpoint.read('customOccupationConfig', ['engineering_telemetry_enabled']);
         await endpoint.configureReporting('msOccupancySensing', [
             {
                 attribute: 'occupancy',
@@ -921,6 +1540,12 @@ const definition = {
                 maximumReportInterval: constants.repInterval.HOUR,
                 reportableChange: null,
             },
+            {
+                attribute: 'zones_occupancy',
+                minimumReportInterval: 0,
+                maximumReportInterval: constants.repInterval.HOUR,
+                reportableChange: null,
+            },
         ]);
 
         await endpoint.configureReporting('customOccupationConfig', [